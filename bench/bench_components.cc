@@ -0,0 +1,177 @@
+/// @file bench_components.cc
+/// @brief Microbenchmarks of the individual simulator components: cache lookup, replacement policies and coherence protocols
+
+#include "benchmark.h"
+#include "cache.h"
+#include "coherence_protocol.h"
+#include "duel.h"
+#include "memory_system.h"
+#include "replacement_policy.h"
+
+/// @brief The number of sets used when benchmarking replacement policies
+#define BENCH_SETS 64
+/// @brief The associativity used when benchmarking replacement policies
+#define BENCH_ASSOC 8
+/// @brief The number of precomputed accesses each benchmark cycles through (power of 2)
+#define BENCH_SEQUENCE 4096
+
+/// @brief A stand-in cache for benchmarking policies and protocols in isolation
+class StubCache : public CacheABC {
+public:
+
+    /// @brief Construct a new stub cache, with every line valid
+    /// @param num_lines The number of lines in the cache
+    /// @param assoc The associativity of the cache
+    StubCache(uint32_t num_lines, uint32_t assoc) : num_lines(num_lines), assoc(assoc), rng(1) {
+        lines = new cache_line[num_lines];
+        for (uint32_t i = 0; i < num_lines; i++) lines[i] = (cache_line){ S };
+    }
+    ~StubCache() {
+        delete[] lines;
+    }
+
+    /// @brief Pretend to issue a bus message
+    /// @param bus_msg The specific bus message
+    /// @return Whether the 'COPIES-EXIST' line was asserted (pseudo-random)
+    bool issueBusMsg(bus_msg_e bus_msg) {
+        rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+        return rng >> 63;
+    }
+
+    /// @brief Pretend to check the 'OWNED' line
+    /// @return Whether the 'OWNED' line was asserted (pseudo-random, but only set if copies exist)
+    bool isOwnedElsewhere() {
+        return (rng >> 62 & 3) == 3;
+    }
+
+    /// @brief Ignore an event detected by the coherence protocol
+    /// @param stat The statistic to increment
+    void addStatistic(statistic_e stat) {}
+
+    /// @brief Get the state of a line in the cache
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    /// @return The state of the cache line
+    state_e getLineState(uint32_t set_idx, uint32_t way_idx) { return lines[set_idx * assoc + way_idx].state; }
+
+    /// @brief Get the number of lines in the cache
+    /// @return The number of lines
+    uint32_t getNumLines() { return num_lines; }
+    /// @brief Get the index of a line in the cache
+    /// @param line The cache line (one of the cache's lines)
+    /// @return The index of the line
+    uint32_t getLineIndex(const cache_line* line) { return line - lines; }
+    /// @brief Get the tag of a line in the cache
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    /// @return The tag of the line (its index, since the stub lines never change)
+    uint64_t getLineTag(uint32_t set_idx, uint32_t way_idx) { return set_idx * assoc + way_idx; }
+
+    /// @brief The cache lines
+    cache_line* lines;
+
+private:
+
+    /// @brief The number of lines in the cache
+    uint32_t num_lines;
+    /// @brief The associativity of the cache
+    uint32_t assoc;
+    /// @brief State of the pseudo-random 'COPIES-EXIST' generator
+    uint64_t rng;
+};
+
+/// @brief Generate a reproducible sequence of pseudo-random numbers
+/// @param count The length of the sequence
+/// @param bound The exclusive upper bound of the numbers
+/// @return The sequence
+std::vector<uint32_t> randomSequence(uint32_t count, uint32_t bound) {
+    std::vector<uint32_t> sequence(count);
+    uint64_t rng = 0x2545F4914F6CDD1Dull;
+    for (uint32_t& value : sequence) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        value = rng % bound;
+    }
+    return sequence;
+}
+
+/// @brief Register the cache lookup benchmarks
+void cacheSuite() {
+    // A power of 2 number of sets (a mask), the same with a hashed set index, and 96 sets (a division by the inverse)
+    struct geometry { const char* name; uint32_t cache_size; uint32_t assoc; bool hashed_index; };
+    for (geometry g : { geometry{ "Cache/findLine", 32768, 8, false }, geometry{ "Cache/findLine/hashed", 32768, 8, true },
+        geometry{ "Cache/findLine/nonPow2", 49152, 8, false } }) {
+        registerBenchmark(g.name, [g](BenchState& state) {
+            cache_config config = { 0, g.cache_size, 64, g.assoc, "MESI", "Broadcast", "LRU" };
+            MemorySystem<uint32_t>* memory_system = (*directory_map)[config.directory].create<uint32_t>(config, 1);
+            options.hashed_index = g.hashed_index;
+            Cache<uint32_t> cache(*memory_system, 0, config);
+            options.hashed_index = false;
+
+            // Fill the cache, then look up a mix of 3/4 resident and 1/4 absent lines
+            uint32_t num_lines = config.cache_size / config.line_size;
+            for (uint32_t i = 0; i < num_lines; i++) cache.receivePrRd(i * config.line_size);
+            std::vector<uint32_t> sequence = randomSequence(BENCH_SEQUENCE, num_lines * 4 / 3);
+            for (uint32_t& line : sequence) line *= config.line_size;
+
+            uint32_t i = 0;
+            while (state.keepRunning()) doNotOptimize(cache.findLine(sequence[i++ & (BENCH_SEQUENCE - 1)]));
+            delete memory_system;
+            });
+    }
+}
+ADD_BENCHMARK_SUITE(cacheSuite);
+
+/// @brief Register the touch and getVictim benchmarks of every replacement policy
+void replacementSuite() {
+    // A duel of two cheap policies shows the cost of the set dueling bookkeeping
+    Duel::registerDuel(DUEL_REPLACER_PREFIX "LRU:FIFO");
+    for (auto& [name, factory] : *replacement_map) {
+        registerBenchmark("Replacer/" + name + "/touch", [factory](BenchState& state) {
+            StubCache cache(BENCH_SETS * BENCH_ASSOC, BENCH_ASSOC);
+            ReplacementPolicy* replacer = factory(cache, BENCH_SETS, BENCH_ASSOC);
+            std::vector<uint32_t> sequence = randomSequence(BENCH_SEQUENCE, BENCH_SETS * BENCH_ASSOC);
+
+            uint32_t i = 0;
+            while (state.keepRunning()) {
+                uint32_t line = sequence[i++ & (BENCH_SEQUENCE - 1)];
+                replacer->touch(line / BENCH_ASSOC, line % BENCH_ASSOC);
+            }
+            delete replacer;
+            });
+        registerBenchmark("Replacer/" + name + "/getVictim", [factory](BenchState& state) {
+            StubCache cache(BENCH_SETS * BENCH_ASSOC, BENCH_ASSOC);
+            ReplacementPolicy* replacer = factory(cache, BENCH_SETS, BENCH_ASSOC);
+            std::vector<uint32_t> sequence = randomSequence(BENCH_SEQUENCE, BENCH_SETS);
+
+            uint32_t i = 0;
+            while (state.keepRunning()) doNotOptimize(replacer->getVictim(sequence[i++ & (BENCH_SEQUENCE - 1)]));
+            delete replacer;
+            });
+    }
+}
+ADD_BENCHMARK_SUITE(replacementSuite);
+
+/// @brief Register the PrRd and PrWr benchmarks of every coherence protocol
+void coherenceSuite() {
+    for (auto& [name, factory] : *coherence_map) {
+        for (bool write : { false, true }) {
+            registerBenchmark("Coherence/" + name + (write ? "/PrWr" : "/PrRd"), [factory, write](BenchState& state) {
+                StubCache cache(BENCH_SETS, 1);
+                CoherenceProtocol* protocol = factory(cache);
+
+                // Every fourth pass over the lines starts them as invalid, so 1/4 of accesses miss
+                uint32_t i = 0;
+                while (state.keepRunning()) {
+                    cache_line* line = &cache.lines[i & (BENCH_SETS - 1)];
+                    if (!(i++ & (3 * BENCH_SETS))) line->state = I;
+                    if (write) protocol->PrWr(line);
+                    else protocol->PrRd(line);
+                }
+                delete protocol;
+                });
+        }
+    }
+}
+ADD_BENCHMARK_SUITE(coherenceSuite);
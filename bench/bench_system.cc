@@ -0,0 +1,115 @@
+/// @file bench_system.cc
+/// @brief Benchmarks of whole memory systems: bus message broadcasting and end-to-end trace processing
+
+#include "benchmark.h"
+#include "memory_system.h"
+
+/// @brief The number of shared lines the broadcast benchmarks cycle through
+#define BENCH_SHARED_LINES 256
+/// @brief The number of traces in the synthetic trace (power of 2)
+#define BENCH_TRACE_LEN (1 << 20)
+/// @brief The number of cores in the synthetic trace
+#define BENCH_TRACE_CORES 16
+
+/// @brief Issue a processor read or write to a memory system
+/// @param memory_system The memory system
+/// @param trace The memory access
+/// @param timestamp The access number
+inline void issueTrace(MemorySystem<uint32_t>* memory_system, trace_t& trace, size_t timestamp) {
+    if (trace.op & 1) memory_system->issuePrWr(trace.addr, trace.op >> 1, timestamp);
+    else memory_system->issuePrRd(trace.addr, trace.op >> 1, timestamp);
+}
+
+/// @brief Generate a reproducible synthetic trace mixing shared lines, per-core streams and per-core random accesses
+/// @return The synthetic trace
+std::vector<trace_t> syntheticTrace() {
+    std::vector<trace_t> trace(BENCH_TRACE_LEN);
+    uint32_t last[BENCH_TRACE_CORES] = { 0 };
+    uint64_t rng = 0x9E3779B97F4A7C15ull;
+    for (trace_t& entry : trace) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        uint32_t core = rng % BENCH_TRACE_CORES;
+        uint32_t kind = (rng >> 8) % 10;
+        uint32_t addr;
+        if (kind < 3) addr = ((rng >> 16) % 512) * 64;                          // Shared lines
+        else if (kind < 7) addr = last[core] + ((rng >> 16) % 4) * 4;          // Sequential stream
+        else addr = (core << 24) | (((rng >> 16) & 0xFFFF) << 2);              // Private random
+        last[core] = addr;
+        entry.op = (core << 1) | ((rng >> 40) % 10 < 3);
+        entry.addr = addr;
+    }
+    return trace;
+}
+
+/// @brief Register the bus message broadcast benchmarks
+void broadcastSuite() {
+    for (uint32_t n_caches : { 2, 16, 128 }) {
+        registerBenchmark("Broadcast/issueBusMsg/" + std::to_string(n_caches), [n_caches](BenchState& state) {
+            cache_config config = { 0, 32768, 64, 8, "MESI", "Broadcast", "LRU" };
+            MemorySystem<uint32_t>* memory_system = (*directory_map)[config.directory].create<uint32_t>(config, n_caches);
+
+            // Have every cache share the same lines
+            for (uint32_t core = 0; core < n_caches; core++)
+                for (uint32_t line = 0; line < BENCH_SHARED_LINES; line++) {
+                    trace_t trace = { (uint8_t)(core << 1), line * config.line_size };
+                    issueTrace(memory_system, trace, 0);
+                }
+
+            uint32_t i = 0;
+            while (state.keepRunning()) {
+                memory_system->issueBusMsg(BusRead, (i % BENCH_SHARED_LINES) * config.line_size, i % n_caches);
+                i++;
+            }
+            delete memory_system;
+            });
+        for (bool filtered : { false, true })
+            registerBenchmark("Broadcast/snoopMiss/" + std::to_string(n_caches) + (filtered ? "/filtered" : ""), [n_caches, filtered](BenchState& state) {
+                cache_config config = { 0, 32768, 64, 8, "MESI", "Broadcast", "LRU" };
+                MemorySystem<uint32_t>* memory_system = (*directory_map)[config.directory].create<uint32_t>(config, n_caches);
+
+                // Have every cache fill up on private lines (the caches are created with the snoop filter option)
+                options.snoop_filter = filtered;
+                uint32_t num_lines = config.cache_size / config.line_size;
+                for (uint32_t core = 0; core < n_caches; core++)
+                    for (uint32_t line = 0; line < num_lines; line++) {
+                        trace_t trace = { (uint8_t)(core << 1), (core << 24) | line * config.line_size };
+                        issueTrace(memory_system, trace, 0);
+                    }
+                options.snoop_filter = false;
+
+                // Bus reads of lines no other cache holds
+                uint32_t i = 0;
+                while (state.keepRunning()) {
+                    uint32_t core = i % n_caches;
+                    memory_system->issueBusMsg(BusRead, (core << 24) | (i % num_lines) * config.line_size, core);
+                    i++;
+                }
+                delete memory_system;
+                });
+    }
+}
+ADD_BENCHMARK_SUITE(broadcastSuite);
+
+/// @brief Register the end-to-end trace processing benchmark of every coherence protocol
+void traceSuite() {
+    static std::vector<trace_t> trace;
+    for (auto& [name, factory] : *coherence_map) {
+        registerBenchmark("Trace/" + name, [name](BenchState& state) {
+            if (trace.empty()) trace = syntheticTrace();
+            cache_config config = { 0, 8192, 64, 4, name, "Broadcast", "LRU" };
+            MemorySystem<uint32_t>* memory_system = (*directory_map)[config.directory].create<uint32_t>(config, BENCH_TRACE_CORES);
+
+            // Each iteration processes one trace
+            state.setItemsPerIteration(1);
+            size_t i = 0;
+            while (state.keepRunning()) {
+                issueTrace(memory_system, trace[i & (BENCH_TRACE_LEN - 1)], i);
+                i++;
+            }
+            delete memory_system;
+            });
+    }
+}
+ADD_BENCHMARK_SUITE(traceSuite);
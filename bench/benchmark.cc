@@ -0,0 +1,242 @@
+/// @file benchmark.cc
+/// @brief Implementation of the microbenchmark harness: runs the benchmarks, prints JSON results and compares against a baseline
+
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#include "benchmark.h"
+
+/// @brief The default minimum duration of a timed benchmark run, in seconds
+#define DEFAULT_MIN_TIME 0.2
+/// @brief The default number of timed runs per benchmark. The fastest one is reported
+#define DEFAULT_REPETITIONS 3
+/// @brief The default slowdown (in percent) above which a benchmark is flagged as a regression
+#define DEFAULT_THRESHOLD 5.0
+
+std::vector<bench_suite_t>* bench_suites = nullptr;
+
+/// @brief A registered benchmark
+struct benchmark {
+    /// @brief The name of the benchmark
+    std::string name;
+    /// @brief The benchmark function
+    bench_func_t func;
+};
+
+/// @brief The result of running a benchmark
+struct bench_result {
+    /// @brief The name of the benchmark
+    std::string name;
+    /// @brief The number of iterations per timed run
+    uint64_t iterations;
+    /// @brief The fastest time per iteration across all timed runs
+    double ns_per_op;
+    /// @brief The average time per iteration across all timed runs
+    double ns_per_op_mean;
+    /// @brief The number of items processed per second in the fastest run (0 if not reported)
+    double items_per_second;
+};
+
+/// @brief Every registered benchmark, in registration order
+static std::vector<benchmark> benchmarks;
+
+void registerBenchmark(std::string name, bench_func_t func) {
+    benchmarks.push_back({ name, func });
+}
+
+/// @brief Run a benchmark once
+/// @param func The benchmark function
+/// @param iterations The number of iterations to run
+/// @param items_per_iteration Set to the number of items per iteration reported by the benchmark
+/// @return The duration of the timed loop in nanoseconds
+double runOnce(bench_func_t& func, uint64_t iterations, double& items_per_iteration) {
+    BenchState state(iterations);
+    func(state);
+    items_per_iteration = state.items_per_iteration;
+    return std::chrono::duration<double, std::nano>(state.stop - state.start).count();
+}
+
+/// @brief Run a benchmark until its timing is stable enough to report
+/// @param bench The benchmark to run
+/// @param min_time The minimum duration of each timed run, in seconds
+/// @param repetitions The number of timed runs
+/// @return The result of the benchmark
+bench_result runBenchmark(benchmark& bench, double min_time, uint32_t repetitions) {
+    // Grow the iteration count until a run takes at least the minimum time
+    double items_per_iteration;
+    uint64_t iterations = 1;
+    double elapsed = runOnce(bench.func, iterations, items_per_iteration);
+    while (elapsed < min_time * 1e9 && iterations < (1ull << 40)) {
+        double scale = elapsed > 0 ? min_time * 1e9 / elapsed * 1.25 : 10;
+        iterations = std::max(iterations + 1, (uint64_t)(iterations * std::min(scale, 10.0)));
+        elapsed = runOnce(bench.func, iterations, items_per_iteration);
+    }
+
+    // Time the benchmark several times, keeping the fastest run
+    bench_result result = { bench.name, iterations, elapsed / iterations, 0, 0 };
+    double total = 0;
+    for (uint32_t i = 0; i < repetitions; i++) {
+        elapsed = runOnce(bench.func, iterations, items_per_iteration) / iterations;
+        result.ns_per_op = std::min(result.ns_per_op, elapsed);
+        total += elapsed;
+    }
+    result.ns_per_op_mean = repetitions ? total / repetitions : result.ns_per_op;
+    if (items_per_iteration) result.items_per_second = items_per_iteration * 1e9 / result.ns_per_op;
+    return result;
+}
+
+/// @brief Print the benchmark results as JSON
+/// @param out The stream to print to
+/// @param results The benchmark results
+/// @param min_time The minimum duration of each timed run, in seconds
+/// @param repetitions The number of timed runs
+void printJSON(std::ostream& out, std::vector<bench_result>& results, double min_time, uint32_t repetitions) {
+    char date[32];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    out << "{" << std::endl;
+    out << "  \"context\": {" << std::endl;
+    out << "    \"date\": \"" << date << "\"," << std::endl;
+    out << "    \"min_time\": " << min_time << "," << std::endl;
+    out << "    \"repetitions\": " << repetitions << std::endl;
+    out << "  }," << std::endl;
+    out << "  \"benchmarks\": [" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        bench_result& result = results[i];
+        out << "    {" << std::endl;
+        out << "      \"name\": \"" << result.name << "\"," << std::endl;
+        out << "      \"iterations\": " << result.iterations << "," << std::endl;
+        out << "      \"ns_per_op\": " << std::setprecision(6) << result.ns_per_op << "," << std::endl;
+        out << "      \"ns_per_op_mean\": " << result.ns_per_op_mean << "," << std::endl;
+        out << "      \"items_per_second\": " << std::setprecision(10) << result.items_per_second << std::endl;
+        out << "    }" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "  ]" << std::endl;
+    out << "}" << std::endl;
+}
+
+/// @brief Read the time per iteration of each benchmark from a JSON file produced by this program
+/// @param file_path The path to the JSON file
+/// @param baseline The map to fill with the time per iteration of each benchmark
+/// @return False if the file couldn't be read
+bool readBaseline(const char* file_path, std::map<std::string, double>& baseline) {
+    std::ifstream file(file_path);
+    if (!file) return false;
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string json = contents.str();
+
+    // Each benchmark object lists its name before its time per iteration
+    const std::string name_key = "\"name\": \"", time_key = "\"ns_per_op\": ";
+    for (size_t pos = json.find(name_key); pos != std::string::npos; pos = json.find(name_key, pos)) {
+        pos += name_key.length();
+        size_t name_end = json.find('"', pos);
+        size_t time_pos = json.find(time_key, name_end);
+        if (name_end == std::string::npos || time_pos == std::string::npos) break;
+        baseline[json.substr(pos, name_end - pos)] = strtod(json.c_str() + time_pos + time_key.length(), nullptr);
+        pos = time_pos;
+    }
+    return true;
+}
+
+/// @brief Compare benchmark results against a baseline, printing a comparison table to stderr
+/// @param results The benchmark results
+/// @param baseline The baseline time per iteration of each benchmark
+/// @param threshold The slowdown (in percent) above which a benchmark is flagged as a regression
+/// @return The number of regressions
+uint32_t compareBaseline(std::vector<bench_result>& results, std::map<std::string, double>& baseline, double threshold) {
+    size_t name_width = 9;
+    for (bench_result& result : results) name_width = std::max(name_width, result.name.length());
+
+    std::cerr << std::left << std::setw(name_width) << "Benchmark" << " | Baseline ns | Current ns |  Change" << std::endl;
+    std::cerr << std::string(name_width, '-') << "-|-------------|------------|---------" << std::endl;
+    uint32_t regressions = 0;
+    for (bench_result& result : results) {
+        std::cerr << std::left << std::setw(name_width) << result.name << " | " << std::right << std::fixed << std::setprecision(2);
+        if (!baseline.count(result.name) || baseline[result.name] <= 0) {
+            std::cerr << std::setw(11) << "-" << " | " << std::setw(10) << result.ns_per_op << " |     new" << std::endl;
+            continue;
+        }
+        double change = (result.ns_per_op / baseline[result.name] - 1) * 100;
+        std::cerr << std::setw(11) << baseline[result.name] << " | " << std::setw(10) << result.ns_per_op << " | ";
+        std::cerr << std::showpos << std::setw(6) << change << std::noshowpos << '%';
+        if (change > threshold) {
+            std::cerr << "  REGRESSION";
+            regressions++;
+        }
+        std::cerr << std::endl;
+    }
+    std::cerr << std::defaultfloat;
+    return regressions;
+}
+
+/// @brief Print the program usage method
+void usageMsg() {
+    std::cerr << "Usage:" << std::endl;
+    std::cerr << "  ./bench_cache [--filter <text>] [--min-time <seconds>] [--repetitions <n>] [--baseline <json_file> [--threshold <percent>]] [--list]" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --filter:      Only run the benchmarks whose name contains 'text'" << std::endl;
+    std::cerr << "  --min-time:    The minimum duration of each timed run (default " << DEFAULT_MIN_TIME << ")" << std::endl;
+    std::cerr << "  --repetitions: The number of timed runs per benchmark; the fastest is reported (default " << DEFAULT_REPETITIONS << ")" << std::endl;
+    std::cerr << "  --baseline:    Compare the results against a JSON file from a previous run" << std::endl;
+    std::cerr << "  --threshold:   The slowdown that is flagged as a regression (default " << DEFAULT_THRESHOLD << ")" << std::endl;
+    std::cerr << "  --list:        List the benchmark names without running them" << std::endl;
+    std::cerr << "The results are printed to stdout as JSON. The exit code is 1 if any regressions were found" << std::endl;
+}
+
+/// @brief The main function runs the benchmarks selected on the command line
+/// @param argc The number of command line arguments
+/// @param argv An array to the command line arguments
+/// @return 0 on success, 1 if a regression was found, 2 on invalid arguments
+int main(int argc, char* argv[]) {
+    std::string filter;
+    double min_time = DEFAULT_MIN_TIME;
+    uint32_t repetitions = DEFAULT_REPETITIONS;
+    const char* baseline_path = nullptr;
+    double threshold = DEFAULT_THRESHOLD;
+    bool list_only = false;
+
+    // Parse the options
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        bool has_value = i + 1 < argc;
+        if (option == "--filter" && has_value) filter = argv[++i];
+        else if (option == "--min-time" && has_value) min_time = strtod(argv[++i], nullptr);
+        else if (option == "--repetitions" && has_value) repetitions = strtoul(argv[++i], nullptr, 10);
+        else if (option == "--baseline" && has_value) baseline_path = argv[++i];
+        else if (option == "--threshold" && has_value) threshold = strtod(argv[++i], nullptr);
+        else if (option == "--list") list_only = true;
+        else {
+            usageMsg();
+            return 2;
+        }
+    }
+
+    // Read the baseline first so that a bad path fails fast
+    std::map<std::string, double> baseline;
+    if (baseline_path && !readBaseline(baseline_path, baseline)) {
+        std::cerr << "Baseline file read error: " << std::strerror(errno) << std::endl;
+        return 2;
+    }
+
+    // Register and run the benchmarks
+    if (bench_suites) for (bench_suite_t& suite : *bench_suites) suite();
+    std::vector<bench_result> results;
+    for (benchmark& bench : benchmarks) {
+        if (bench.name.find(filter) == std::string::npos) continue;
+        if (list_only) {
+            std::cout << bench.name << std::endl;
+            continue;
+        }
+        std::cerr << "Running " << bench.name << "..." << std::endl;
+        results.push_back(runBenchmark(bench, min_time, repetitions));
+    }
+    if (list_only) return 0;
+
+    printJSON(std::cout, results, min_time, repetitions);
+    if (baseline_path && compareBaseline(results, baseline, threshold)) return 1;
+    return 0;
+}
@@ -0,0 +1,80 @@
+/// @file benchmark.h
+/// @brief Declaration of the microbenchmark harness
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "typedefs.h"
+
+/// @brief The state of a running benchmark, polled by the benchmark body
+///
+/// Usage: `while (state.keepRunning()) { ... }`. Only the loop itself is timed, so any setup
+/// before the loop and cleanup after it do not count towards the result
+class BenchState {
+public:
+
+    /// @brief Construct a new benchmark state
+    /// @param iterations The number of iterations the loop will run for
+    BenchState(uint64_t iterations) : iterations(iterations), remaining(iterations), items_per_iteration(0), started(false) {}
+
+    /// @brief Check whether the timed loop should run another iteration, starting and stopping the timer as needed
+    /// @return True if there are iterations left
+    inline bool keepRunning() {
+        if (!started) {
+            started = true;
+            start = std::chrono::steady_clock::now();
+        }
+        if (remaining) {
+            remaining--;
+            return true;
+        }
+        stop = std::chrono::steady_clock::now();
+        return false;
+    }
+
+    /// @brief Report how many items (e.g. traces) each iteration processes
+    /// @param items The number of items per iteration
+    void setItemsPerIteration(double items) { items_per_iteration = items; }
+
+    /// @brief The number of iterations the loop runs for
+    const uint64_t iterations;
+    /// @brief The number of iterations left to run
+    uint64_t remaining;
+    /// @brief The number of items processed by each iteration (0 if not reported)
+    double items_per_iteration;
+    /// @brief Whether the timed loop has started
+    bool started;
+    /// @brief The time when the timed loop started
+    std::chrono::steady_clock::time_point start;
+    /// @brief The time when the timed loop ended
+    std::chrono::steady_clock::time_point stop;
+};
+
+/// @brief Benchmark function signature
+typedef std::function<void(BenchState&)> bench_func_t;
+/// @brief Benchmark suite function signature. A suite registers its benchmarks when called
+typedef std::function<void()> bench_suite_t;
+
+/// @brief The list of benchmark suites, called at startup (after every policy/protocol has registered itself)
+extern std::vector<bench_suite_t>* bench_suites;
+
+/// @brief Register a benchmark
+/// @param name The unique name of the benchmark, with '/' separated components
+/// @param func The benchmark function
+void registerBenchmark(std::string name, bench_func_t func);
+
+/// @brief Prevent the compiler from optimizing away a value or the computation producing it
+/// @param value The value to keep
+template<typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// @brief Add a benchmark suite function to 'bench_suites'
+/// @param suite The name of the suite function
+#define ADD_BENCHMARK_SUITE(suite) static int register_##suite = []() { \
+if (bench_suites == nullptr) bench_suites = new std::vector<bench_suite_t>(); \
+bench_suites->push_back(suite); return 0; }()
@@ -4,107 +4,207 @@
 #include <cmath>
 
 #include "cache.h"
+#include "checkpoint.h"
+#include "coherence_checker.h"
 #include "coherence_protocol.h"
+#include "instrumentation.h"
 #include "memory_system.h"
+#include "miss_classifier.h"
+#include "next_use.h"
 #include "replacement_policy.h"
+#include "results_sink.h"
 
-Cache::Cache(MemorySystem& memory_system, uint32_t cache_id, cache_config& config) :
-    memory_system(memory_system), config(config), cache_id(cache_id) {
-    // Calculate cache dimensions
+#ifdef GEOMETRY_KERNELS
+// Generated from a configs file by 'make GEOMETRY=<configs_file>'
+#include "geometry_kernels.h"
+#endif
+
+template<typename A>
+Cache<A>::Cache(MemorySystem<A>& memory_system, uint32_t cache_id, cache_config& config) :
+    memory_system(memory_system), config(config), cache_id(cache_id),
+    set_divisor(config.cache_size / config.line_size / config.assoc), repeat_line_addr((A)~0), repeat_silent{ false, false } {
+    // Calculate cache dimensions (the number of sets need not be a power of 2, but the line size is)
     uint32_t num_lines = config.cache_size / config.line_size;
     num_sets = num_lines / config.assoc;
     // The logarithm of an integer tells the position of its most significant digit
     // (Use float version since rounding errors are irrelevant)
     line_offset = std::log2f(config.line_size);
-    tag_offset = std::log2f(config.cache_size / config.assoc);
+    hashed_index = options.hashed_index && num_sets > 1;
+    set_bits = num_sets > 1 ? 32 - __builtin_clz(num_sets - 1) : 0;
+
+    // Use a findLine kernel specialized for the geometry, if the simulator was built with one (kernels do not hash)
+    find_line = &Cache<A>::findLineGeneric;
+#ifdef GEOMETRY_KERNELS
+    if (!hashed_index)
+#define SELECT_KERNEL(LINE_OFFSET, NUM_SETS, ASSOC) \
+        if (line_offset == LINE_OFFSET && num_sets == NUM_SETS && config.assoc == ASSOC) \
+            find_line = &Cache<A>::findLineKernel<LINE_OFFSET, NUM_SETS, ASSOC>;
+        GEOMETRY_KERNEL_LIST(SELECT_KERNEL)
+#undef SELECT_KERNEL
+#endif
 
     // Initialize cache components
     coherence_protocol = (*coherence_map)[config.coherence](*this);
     replacement_policy = config.assoc == 1
         ? new ReplacementPolicy(*this, num_sets, config.assoc) // Proverbial "None" Replacer
         : (*replacement_map)[config.replacer](*this, num_sets, config.assoc);
+    miss_classifier = options.classify_misses ? new MissClassifier<A>(num_lines) : nullptr;
+    snoop_filter = options.snoop_filter ? new SnoopFilter(num_lines) : nullptr;
 
     // Initialize cache lines
-    lines = new cache_line[num_lines];
-    for (uint32_t i = 0; i < num_lines; i++)
-        lines[i] = (cache_line){ (tag_t)~0, I };
+    lines = new tagged_line<A>[num_lines];
+    for (uint32_t i = 0; i < num_lines; i++) {
+        lines[i].tag = (A)~0;
+        lines[i].state = I;
+    }
+    checker_records = nullptr;
+    if (memory_system.checker) {
+        checker_records = new uint32_t[num_lines];
+        std::fill_n(checker_records, num_lines, ~0u);
+    }
 }
-Cache::~Cache() {
+template<typename A>
+Cache<A>::~Cache() {
     delete coherence_protocol;
     delete replacement_policy;
+    delete miss_classifier;
+    delete snoop_filter;
     delete[] lines;
+    delete[] checker_records;
+}
+
+template<typename A>
+uint32_t Cache<A>::checkerRecord(uint32_t line_idx) {
+    // The record is looked up once per allocation of the line
+    uint32_t& record = checker_records[line_idx];
+    if (record == ~0u) record = memory_system.checker->getRecord(lineAddr(lines[line_idx].tag, line_idx / config.assoc));
+    return record;
 }
 
-void Cache::receivePrRd(addr_t addr) {
+template<typename A>
+void Cache<A>::receivePrRd(A addr) {
+    // Coalesce repeated reads: once a repeat was seen to only count the read, nothing else can change until the cache
+    // accesses another line or receives a bus message for the line
+    A line_addr = addr >> line_offset;
+    if (line_addr == repeat_line_addr && repeat_silent[0]) {
+        statistics[ProcRead]++;
+        return;
+    }
+    bool repeat = line_addr == repeat_line_addr && replacement_policy->isRepeatTouchIdempotent();
+    size_t events = repeat ? countEvents() : 0;
+
     // Remember the current address being accessed so that it can be attached to issued bus messages
     curr_access_addr = addr;
 
     // Find the accessed line
-    cache_line* line = findLine(addr);
+    tagged_line<A>* line = findLine(addr);
     statistics[ProcRead]++;
 
     // Intercept read miss
     if (!line) line = allocate(addr);
     if (!line->state) statistics[ReadMiss]++;
 
+    // Classify the miss (the shadow caches are updated on every access)
+    if (miss_classifier) {
+        statistic_e miss_class = miss_classifier->access(addr >> line_offset, true);
+        if (!line->state) statistics[miss_class]++;
+    }
+
     // Initiate the PrRd state change
     state_e prev_state = line->state;
-#ifdef WRITE_TIMESTAMP
-    memory_system.most_recent_sibling = 0;
-#endif
     coherence_protocol->PrRd(line);
     stateChangeStatistic(prev_state, line->state);
-#ifdef WRITE_TIMESTAMP
-    // Update timestamp on a read miss
-    if (!prev_state) {
-        if (memory_system.copies_exist) line->timestamp = memory_system.most_recent_sibling;
-        else line->timestamp = memory_system.access_timestamp;
-    }
-#endif
+    snoopFilterTransition(addr >> line_offset, prev_state, line->state);
 
     // Inform replacer of cache line access
     uint32_t line_idx = line - lines;
     replacement_policy->touch(line_idx / config.assoc, line_idx % config.assoc);
+
+    // A read hit without a state change affects no copy of the line, so there is nothing to check
+    CoherenceChecker<A>* checker = memory_system.checker;
+    if (checker && prev_state != line->state) {
+        // On a miss, the line comes from whichever cache flushed it, or else from main memory
+        uint32_t record = checkerRecord(line_idx);
+        checker->transition(record, cache_id, prev_state, line->state);
+        if (!prev_state && line->state) checker->fill(record, cache_id, memory_system.flushed);
+        checker->verify(record, line_addr, cache_id, false, memory_system.access_timestamp);
+    }
+    endAccess(line_addr, false, repeat && prev_state == line->state && countEvents() == events + 1);
 }
-void Cache::receivePrWr(addr_t addr) {
+template<typename A>
+void Cache<A>::receivePrWr(A addr) {
+    // Coalesce repeated writes like repeated reads (a write that only counts the access is a write hit on a dirty
+    // exclusive copy, which the checker skips as well)
+    A line_addr = addr >> line_offset;
+    if (line_addr == repeat_line_addr && repeat_silent[1]) {
+        statistics[ProcWrite]++;
+        return;
+    }
+    bool repeat = line_addr == repeat_line_addr && replacement_policy->isRepeatTouchIdempotent();
+    size_t events = repeat ? countEvents() : 0;
+
     // Remember the current address being accessed so that it can be attached to issued bus messages
     curr_access_addr = addr;
 
     // Find the accessed line
-    cache_line* line = findLine(addr);
+    tagged_line<A>* line = findLine(addr);
     statistics[ProcWrite]++;
 
     // Intercept write miss
+    bool miss;
     if (coherence_protocol->doesWriteNoAllocate()) {
         statistics[WriteMemory]++;
-        if (!line || !line->state) statistics[WriteMiss]++;
+        miss = !line || !line->state;
     } else {
         if (!line) line = allocate(addr);
-        if (!line->state) statistics[WriteMiss]++;
+        miss = !line->state;
+    }
+    if (miss) statistics[WriteMiss]++;
+
+    // Classify the miss (the shadow caches are updated on every access)
+    if (miss_classifier) {
+        statistic_e miss_class = miss_classifier->access(addr >> line_offset, !coherence_protocol->doesWriteNoAllocate());
+        if (miss) statistics[miss_class]++;
     }
 
-    // Initiate the PrWr state change
-    state_e prev_state;
-    if (line) prev_state = line->state;
+    // Initiate the PrWr state change (the written value replaces every copy that isn't updated during the write)
+    // A write hit on a dirty exclusive copy changes no other copy, and main memory is already out of date, so unless
+    // the state changes there is nothing for the checker to record or check
+    CoherenceChecker<A>* checker = memory_system.checker;
+    state_e prev_state = line ? line->state : I;
+    bool dirty_hit = (prev_state == M || prev_state == D) && !coherence_protocol->doesWriteNoAllocate();
+    uint32_t record = 0;
+    if (checker) record = line ? checkerRecord(line - lines) : checker->getRecord(line_addr);
+    if (checker && !dirty_hit) checker->beginWrite(record, cache_id, memory_system.access_timestamp);
     coherence_protocol->PrWr(line);
-    if (line) stateChangeStatistic(prev_state, line->state);
+    if (line) {
+        stateChangeStatistic(prev_state, line->state);
+        snoopFilterTransition(addr >> line_offset, prev_state, line->state);
+    }
 
     if (line && line->state) {
         // Inform replacer of cache line access
         uint32_t line_idx = line - lines;
         replacement_policy->touch(line_idx / config.assoc, line_idx % config.assoc);
+    }
 
-#ifdef WRITE_TIMESTAMP
-        // Update the cache line's timestamp
-        line->timestamp = memory_system.access_timestamp;
-#endif
+    if (checker && !(dirty_hit && line->state == prev_state)) {
+        if (dirty_hit) checker->beginWrite(record, cache_id, memory_system.access_timestamp);
+        if (line) checker->transition(record, cache_id, prev_state, line->state);
+        if (line && line->state) checker->update(record, cache_id);
+        if (coherence_protocol->doesWriteNoAllocate()) checker->writeMemory(record);
+        checker->verify(record, line_addr, cache_id, true, memory_system.access_timestamp);
     }
+    endAccess(line_addr, true, repeat && line && prev_state == line->state && countEvents() == events + 1);
 }
 
-bool Cache::issueBusMsg(bus_msg_e bus_msg) {
+template<typename A>
+bool Cache<A>::issueBusMsg(bus_msg_e bus_msg) {
     // Reset shared signals (done here since this is the only method that reads the shared signals)
     memory_system.copies_exist = false;
     memory_system.flushed = false;
+    memory_system.owned = false;
+    memory_system.silent_copies = 0;
 
     // Send the bus message to each cache
     switch (bus_msg) {
@@ -113,8 +213,18 @@ bool Cache::issueBusMsg(bus_msg_e bus_msg) {
         memory_system.issueBusMsg(bus_msg, curr_access_addr, cache_id);
         // Figure out where the cache line was read from
         statistics[memory_system.flushed ? CacheToCache : LineFetch]++;
+        // Each copy that stayed silent on a BusRead could have flushed the line too (one of them is not redundant
+        // if none flushed it)
+        statistics[RedundantResponseAvoided] += memory_system.silent_copies - (!memory_system.flushed && memory_system.silent_copies);
         break;
     case BusUpdate:
+        memory_system.issueBusMsg(bus_msg, curr_access_addr, cache_id);
+        // The update also keeps main memory up to date in some protocols
+        if (coherence_protocol->doesUpdateMemory()) {
+            statistics[WriteMemory]++;
+            if (memory_system.checker) memory_system.checker->writeMemory(memory_system.checker->getRecord(curr_access_addr >> line_offset));
+        }
+        break;
     case BusUpgrade:
     case BusWrite:
         memory_system.issueBusMsg(bus_msg, curr_access_addr, cache_id);
@@ -125,89 +235,144 @@ bool Cache::issueBusMsg(bus_msg_e bus_msg) {
     statistics[bus_msg]++;
     return memory_system.copies_exist;
 }
-void Cache::receiveBusMsg(bus_msg_e bus_msg, addr_t addr) {
+template<typename A>
+bool Cache<A>::isOwnedElsewhere() {
+    return memory_system.owned;
+}
+template<typename A>
+void Cache<A>::receiveBusMsg(bus_msg_e bus_msg, A addr) {
+    // Repeated accesses of the line may no longer be coalesced
+    if (addr >> line_offset == repeat_line_addr) forgetRepeat();
+
     // Find the accessed line
-    cache_line* line = findLine(addr);
+    tagged_line<A>* line = findLine(addr);
+    if (snoop_filter && (!line || !line->state)) statistics[SnoopFilterFalsePositive]++;
     if (!line) return;
     memory_system.copies_exist |= line->state;
+    uint32_t record = memory_system.checker ? checkerRecord(line - lines) : 0;
 
     // Map bus_msg_e to the appropriate function call, keeping track of the line's state and if the line was flushed
     state_e prev_state = line->state;
+    bool flush;
     switch (bus_msg) {
     case BusRead:
-        if (coherence_protocol->BusRd(line)) {
+        flush = coherence_protocol->BusRd(line);
+        if (flush) {
             // The BusRead message requires extra logic for determining when a WriteBack occurs
-            if (!coherence_protocol->doesDirtySharing() && coherence_protocol->isWriteBackNeeded(prev_state))
+            if (!coherence_protocol->doesDirtySharing() && coherence_protocol->isWriteBackNeeded(prev_state)) {
                 statistics[WriteBack]++;
-            statistics[LineFlush]++;
-            memory_system.flushed = true;
-        }
+                if (memory_system.checker) memory_system.checker->writeBack(record, cache_id);
+            }
+        } else if (prev_state) memory_system.silent_copies++;
         break;
     case BusReadX:
-        if (coherence_protocol->BusRdX(line)) {
-            statistics[LineFlush]++;
-            memory_system.flushed = true;
-        }
+        flush = coherence_protocol->BusRdX(line);
         break;
     case BusUpdate:
-        if (coherence_protocol->BusUpdt(line)) {
-            statistics[LineFlush]++;
-            memory_system.flushed = true;
-        }
-#ifdef WRITE_TIMESTAMP
-        // BusUpdate is the only bus message that distribues a write,
-        // so it is the only bus message that sets the timestamp
-        line->timestamp = memory_system.access_timestamp;
-#endif
+        flush = coherence_protocol->BusUpdt(line);
+        // BusUpdate is the only bus message that distributes a write
+        if (memory_system.checker) memory_system.checker->update(record, cache_id);
         break;
     case BusUpgrade:
-        if (coherence_protocol->BusUpgr(line)) {
-            statistics[LineFlush]++;
-            memory_system.flushed = true;
-        }
+        flush = coherence_protocol->BusUpgr(line);
         break;
     case BusWrite:
-        if (coherence_protocol->BusWr(line)) {
-            statistics[LineFlush]++;
-            memory_system.flushed = true;
-        }
+        flush = coherence_protocol->BusWr(line);
         break;
     default: // Only respond to actual bus messages (enum has other values)
         return;
     }
+    if (flush) {
+        statistics[LineFlush]++;
+        memory_system.flushed = true;
+        // The flushed copy is what a cache missing on the line receives (even if the copy is invalidated)
+        if (memory_system.checker) memory_system.checker->flush(record, cache_id);
+    }
+    if (line->state == O || line->state == Sm) memory_system.owned = true;
     stateChangeStatistic(prev_state, line->state);
-
-#ifdef WRITE_TIMESTAMP
-    // Determine most recent timestamp across siblings
-    if (memory_system.most_recent_sibling < line->timestamp)
-        memory_system.most_recent_sibling = line->timestamp;
-#endif
+    snoopFilterTransition(addr >> line_offset, prev_state, line->state);
+    if (miss_classifier && prev_state && !line->state) miss_classifier->invalidate(addr >> line_offset);
+    if (memory_system.checker) memory_system.checker->transition(record, cache_id, prev_state, line->state);
 }
 
-state_e Cache::getLineState(uint32_t set_idx, uint32_t way_idx) {
+template<typename A>
+state_e Cache<A>::getLineState(uint32_t set_idx, uint32_t way_idx) {
     return lines[set_idx * config.assoc + way_idx].state;
 }
 
-#ifdef WRITE_TIMESTAMP
-size_t Cache::getTimestamp(addr_t addr) {
-    cache_line* line = findLine(addr);
-    if (line && line->state) return line->timestamp;
-    return 0;
+template<typename A>
+uint64_t Cache<A>::getNextUse() {
+    if (!memory_system.next_use) return UINT64_MAX;
+    uint32_t distance = memory_system.next_use[memory_system.access_timestamp];
+    return distance == NEXT_USE_NEVER ? UINT64_MAX : memory_system.access_timestamp + distance;
+}
+
+template<typename A>
+state_e Cache<A>::findUnsupportedState(const std::string& coherence) {
+    CoherenceProtocol* protocol = (*coherence_map)[coherence](*this);
+    state_e unsupported = I;
+    for (uint32_t i = 0; i < num_sets * config.assoc && !unsupported; i++)
+        if (lines[i].state && !protocol->isStateSupported(lines[i].state)) unsupported = lines[i].state;
+    delete protocol;
+    return unsupported;
 }
-#endif
 
-void Cache::printStats() {
-    if (statistics[ProcRead] + statistics[ProcWrite]) {
-        // Print miss rate
-        std::cout << config.id << ',' << cache_id << ',' <<
-            ((double)statistics[ReadMiss] + (double)statistics[WriteMiss]) / ((double)statistics[ProcRead] + (double)statistics[ProcWrite]);
-        // Print each statistics value
-        for (uint32_t i = 0; i < N_STATISTICS; i++) std::cout << ',' << statistics[i];
-        std::cout << std::endl;
+template<typename A>
+void Cache<A>::reconfigure(bool coherence, bool replacer) {
+    forgetRepeat();
+    if (coherence) {
+        delete coherence_protocol;
+        coherence_protocol = (*coherence_map)[config.coherence](*this);
+    }
+    // A direct-mapped cache keeps the "None" replacer
+    if (replacer && config.assoc > 1) {
+        delete replacement_policy;
+        replacement_policy = (*replacement_map)[config.replacer](*this, num_sets, config.assoc);
+    }
+}
+
+template<typename A>
+const size_t* Cache<A>::getStatistics() {
+    // The set regimes describe the replacer's state rather than counting events, so they are not accumulated
+    statistics[RecencySet] = statistics[FrequencySet] = 0;
+    replacement_policy->countSetRegimes(statistics[RecencySet], statistics[FrequencySet]);
+    return statistics;
+}
+
+template<typename A>
+void Cache<A>::printStats(ResultsSink& sink) {
+    if (statistics[ProcRead] + statistics[ProcWrite]) sink.addRow(config, cache_id, getStatistics());
+}
+
+template<typename A>
+void Cache<A>::checkpoint(std::ostream& out) {
+    writeArray(out, statistics, N_STATISTICS);
+    writeArray(out, lines, num_sets * config.assoc);
+    replacement_policy->checkpoint(out);
+    coherence_protocol->checkpoint(out);
+    if (miss_classifier) miss_classifier->checkpoint(out);
+}
+
+template<typename A>
+void Cache<A>::restore(std::istream& in) {
+    readArray(in, statistics, N_STATISTICS);
+    readArray(in, lines, num_sets * config.assoc);
+    forgetRepeat();
+    if (checker_records) std::fill_n(checker_records, num_sets * config.assoc, ~0u);
+    replacement_policy->restore(in);
+    coherence_protocol->restore(in);
+    if (miss_classifier) miss_classifier->restore(in);
+
+    // The snoop filter only depends on the lines, so it is rebuilt rather than saved
+    if (snoop_filter) {
+        snoop_filter->clear();
+        for (uint32_t i = 0; i < num_sets * config.assoc; i++)
+            if (lines[i].state) snoop_filter->insert(lineAddr(lines[i].tag, i / config.assoc));
     }
 }
 
-void Cache::stateChangeStatistic(state_e before, state_e after) {
+template<typename A>
+void Cache<A>::stateChangeStatistic(state_e before, state_e after) {
     // There are three state change statistics:
     //   - When a state transitions from a non-invalid state to the invalid state
     //   - When a state transitions from a shared state to a non-shared state
@@ -218,35 +383,68 @@ void Cache::stateChangeStatistic(state_e before, state_e after) {
     else if (before >= O && after <= V) statistics[Exclusion]++;
 }
 
-cache_line* Cache::allocate(addr_t addr) {
+template<typename A>
+size_t Cache<A>::countEvents() {
+    size_t events = 0;
+    for (size_t stat : statistics) events += stat;
+    return events;
+}
+
+template<typename A>
+tagged_line<A>* Cache<A>::allocate(A addr) {
     // Find the line index of the victim line
     // First, idx is the set index, and with the help of the replacer,
     //   is converted into line index
-    uint32_t idx = ((addr >> line_offset) % num_sets);
+    A tag;
+    uint32_t idx = setIndex(addr >> line_offset, tag);
     idx = replacement_policy->getVictim(idx) + idx * config.assoc;
 
     // Evict the line first if necessary
     if (lines[idx].state) {
         statistics[Eviction]++;
+        A victim_line_addr = lineAddr(lines[idx].tag, idx / config.assoc);
         if (coherence_protocol->isWriteBackNeeded(lines[idx].state)) {
             statistics[LineFlush]++;
             statistics[WriteBack]++;
+            if (memory_system.checker) memory_system.checker->writeBack(checkerRecord(idx), cache_id);
         }
+        if (memory_system.checker) memory_system.checker->transition(checkerRecord(idx), cache_id, lines[idx].state, I);
+        snoopFilterTransition(victim_line_addr, lines[idx].state, I);
     }
 
     // Initialize the line
-    lines[idx].tag = addr >> tag_offset;
+    lines[idx].tag = tag;
     lines[idx].state = I;
+    if (checker_records) checker_records[idx] = ~0u;
+    coherence_protocol->notifyAllocated(&lines[idx]);
     return &lines[idx];
 }
-cache_line* Cache::findLine(addr_t addr) {
-    // Cache line tag
-    tag_t tag = addr >> tag_offset;
-    // Cache line index of the first line in the set
-    uint32_t start_idx = ((addr >> line_offset) % num_sets) * config.assoc;
+template<typename A>
+tagged_line<A>* Cache<A>::findLineGeneric(A addr) {
+    INSTRUMENT_PHASE(PHASE_FIND_LINE);
+    // Cache line tag, and cache line index of the first line in the set
+    A tag;
+    uint32_t start_idx = setIndex(addr >> line_offset, tag) * config.assoc;
     // Return the first line found in the set with a matching tag
     for (uint32_t i = 0; i < config.assoc; i++)
         if (lines[start_idx + i].tag == tag)
             return &lines[start_idx + i];
     return nullptr;
 }
+template<typename A>
+template<uint32_t LINE_OFFSET, uint32_t NUM_SETS, uint32_t ASSOC>
+tagged_line<A>* Cache<A>::findLineKernel(A addr) {
+    INSTRUMENT_PHASE(PHASE_FIND_LINE);
+    // Same as findLineGeneric, with the division by a constant (a shift and a mask for a power of 2)
+    A line_addr = addr >> LINE_OFFSET;
+    A tag = line_addr / NUM_SETS;
+    tagged_line<A>* set = &lines[(line_addr - tag * NUM_SETS) * ASSOC];
+#pragma GCC unroll 16
+    for (uint32_t i = 0; i < ASSOC; i++)
+        if (set[i].tag == tag)
+            return &set[i];
+    return nullptr;
+}
+
+template class Cache<uint32_t>;
+template class Cache<uint64_t>;
@@ -4,8 +4,12 @@
 #pragma once
 
 #include "cache_abc.h"
+#include "fast_divisor.h"
+#include "snoop_filter.h"
 
 /// @brief An L1 Cache with coherence protocol and replacement policy
+/// @tparam A The address type
+template<typename A>
 class Cache : public CacheABC {
 public:
 
@@ -13,24 +17,40 @@ public:
     /// @param memory_system The parent memory system
     /// @param cache_id The ID of this cache
     /// @param config The configuration of the parent memory system
-    Cache(MemorySystem& memory_system, uint32_t cache_id, cache_config& config);
+    Cache(MemorySystem<A>& memory_system, uint32_t cache_id, cache_config& config);
     ~Cache();
 
     /// @brief Issue a PrRd message to this cache
     /// @param addr The address accessed
-    void receivePrRd(addr_t addr);
+    void receivePrRd(A addr);
     /// @brief Issue a PrWr message to this cache
     /// @param addr The address accessed
-    void receivePrWr(addr_t addr);
+    void receivePrWr(A addr);
 
     /// @brief Issue a BusRd message to neighboring caches
     /// @param bus_msg The specific bus message
     /// @return True if the 'COPIES-EXIST' line was asserted
     bool issueBusMsg(bus_msg_e bus_msg);
+    /// @brief Check if the 'OWNED' line was asserted by the last bus message
+    /// @return True if another cache owns the line
+    bool isOwnedElsewhere();
+    /// @brief Count an event that only the coherence protocol can detect
+    /// @param stat The statistic to increment
+    void addStatistic(statistic_e stat) { statistics[stat]++; }
     /// @brief Issue a bus message to this cache
     /// @param bus_msg The specific bus message
     /// @param addr The address accessed
-    void receiveBusMsg(bus_msg_e bus_msg, addr_t addr);
+    void receiveBusMsg(bus_msg_e bus_msg, A addr);
+    /// @brief Check the snoop filter before issuing a bus message to this cache
+    /// @param addr The address accessed
+    /// @return False if the cache certainly has no valid copy of the line (always true without a snoop filter)
+    inline bool passesSnoopFilter(A addr) {
+        if (!snoop_filter) return true;
+        statistics[SnoopFilterProbe]++;
+        if (snoop_filter->mayContain(addr >> line_offset)) return true;
+        statistics[SnoopLookupAvoided]++;
+        return false;
+    }
 
     /// @brief Get the state of a line in the cache
     /// @param set_idx The index of the set containing the line
@@ -38,21 +58,62 @@ public:
     /// @return The state of the cache line
     state_e getLineState(uint32_t set_idx, uint32_t way_idx);
 
-#ifdef WRITE_TIMESTAMP
-    /// @brief Get the access number of the most recent edit to a cache line
-    /// @param addr The address to ckeck
-    /// @return The timestamp of the cache line if the address is in the cache, otherwise 0
-    size_t getTimestamp(addr_t addr);
-#endif
+    /// @brief Get the number of lines in the cache
+    /// @return The number of lines
+    uint32_t getNumLines() { return num_sets * config.assoc; }
+    /// @brief Get the index of a line in the cache
+    /// @param line The cache line (one of the cache's lines)
+    /// @return The index of the line
+    uint32_t getLineIndex(const cache_line* line) { return static_cast<const tagged_line<A>*>(line) - lines; }
+    /// @brief Get the tag of a line in the cache
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    /// @return The tag of the line
+    uint64_t getLineTag(uint32_t set_idx, uint32_t way_idx) { return lines[set_idx * config.assoc + way_idx].tag; }
+    /// @brief Get the position in the trace of the next access of this cache's core to the line accessed now
+    /// @return The trace record index of the next access (UINT64_MAX if there is none or no next use index is loaded)
+    uint64_t getNextUse();
+    /// @brief Get a seed for the random choices of the replacer
+    /// @return The configuration ID and cache ID
+    uint64_t getRandomSeed() { return (uint64_t)config.id << 32 | cache_id; }
+
+    /// @brief Locate a line in the cache
+    /// @param addr The address being accessed
+    /// @return A pointer to the line if found, else nullptr
+    inline tagged_line<A>* findLine(A addr) { return (this->*find_line)(addr); }
+
+    /// @brief Get the simulation run statistics, with the set regimes of the replacer as they are now
+    /// @return The statistics (N_STATISTICS values)
+    const size_t* getStatistics();
+
+    /// @brief Find a line in a state that a coherence protocol does not have
+    /// @param coherence The name of the coherence protocol
+    /// @return The state of the first such line, or I if the protocol has the state of every line
+    state_e findUnsupportedState(const std::string& coherence);
 
-    /// @brief Print simulation run statistics in CSV format (headerless)
+    /// @brief Replace the coherence protocol and/or replacement policy with those of the configuration, keeping
+    /// the cache lines and statistics
+    /// @param coherence Whether to replace the coherence protocol
+    /// @param replacer Whether to replace the replacement policy
+    /// @note The new protocol and policy start out in their initial state
+    void reconfigure(bool coherence, bool replacer);
+
+    /// @brief Add the simulation run statistics to the output
+    /// @param sink The results sink collecting the output
     /// @note Does not produce output if the cache is unused
-    void printStats();
+    void printStats(ResultsSink& sink);
+
+    /// @brief Write the statistics, lines, replacer state and protocol state to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the statistics, lines, replacer state and protocol state from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
 
 private:
 
     /// @brief Parent memory system
-    MemorySystem& memory_system;
+    MemorySystem<A>& memory_system;
     /// @brief Config from the parent memory system
     cache_config& config;
 
@@ -60,8 +121,15 @@ private:
     CoherenceProtocol* coherence_protocol;
     /// @brief Replacement policy used by this cache
     ReplacementPolicy* replacement_policy;
+    /// @brief Miss classifier shadowing this cache (nullptr unless enabled)
+    MissClassifier<A>* miss_classifier;
+    /// @brief Filter of the valid lines of this cache (nullptr unless enabled)
+    SnoopFilter* snoop_filter;
     /// @brief Cache lines contained in this cache
-    cache_line* lines;
+    tagged_line<A>* lines;
+    /// @brief The index of the coherence checker's record of each line, or ~0 if not looked up since the line was
+    /// allocated (nullptr unless the checker is enabled)
+    uint32_t* checker_records;
 
     /// @brief ID of this cache
     uint32_t cache_id;
@@ -69,29 +137,123 @@ private:
     uint32_t num_sets;
     /// @brief Number of bits that come before the line offset field
     uint32_t line_offset;
-    /// @brief Number of bits that come before the tag field
-    uint32_t tag_offset;
+    /// @brief Divides a line address by the number of sets into its tag (quotient) and set index (remainder)
+    FastDivisor set_divisor;
+    /// @brief Whether the set index is hashed with the tag (always false for a single set)
+    bool hashed_index;
+    /// @brief The number of bits of a set index, rounded up
+    uint32_t set_bits;
 
     /// @brief Cache runtime statistics
     size_t statistics[N_STATISTICS] = { 0 };
 
+    /// @brief The findLine implementation for the geometry of this cache (findLineGeneric, or a findLineKernel
+    /// specialized for the geometry)
+    tagged_line<A>* (Cache<A>::*find_line)(A addr);
+
+    /// @brief The line address of the line this cache accessed last, until a bus message for the line is received
+    /// (all-ones if there is no such line)
+    A repeat_line_addr;
+    /// @brief Whether repeating a read (index 0) or a write (index 1) of the line accessed last was seen to have no
+    /// effect other than counting the access, so that later repeats only count the access
+    bool repeat_silent[2];
+
     /// @brief The address being accessed by the current processor read or write
     /// @note Remembering the currently accessed address only works because each memory
     /// access is atomic, i.e. all resulting bus messages will finish before the next memory access
-    addr_t curr_access_addr;
+    A curr_access_addr;
 
     /// @brief Update the correct state transition statistic
     /// @param before The state the line was in before
     /// @param after The new state of the line
     void stateChangeStatistic(state_e before, state_e after);
+    /// @brief Keep the snoop filter in sync with the valid lines of the cache
+    /// @param line_addr The line address of the line (address without the line offset)
+    /// @param before The state the line was in before
+    /// @param after The new state of the line
+    inline void snoopFilterTransition(A line_addr, state_e before, state_e after) {
+        if (!snoop_filter || !before == !after) return;
+        if (after) snoop_filter->insert(line_addr);
+        else snoop_filter->remove(line_addr);
+    }
+
+    /// @brief Split a line address into its tag and set index
+    /// @param line_addr The line address (address without the line offset)
+    /// @param tag The tag of the line
+    /// @return The set index
+    inline uint32_t setIndex(A line_addr, A& tag) {
+        uint64_t set_idx;
+        tag = set_divisor.divide(line_addr, set_idx);
+        if (!hashed_index) return set_idx;
+        // The set index is combined with a hash of the tag, in a way that can be undone given the tag (see lineAddr)
+        uint64_t hash = tagHash(tag);
+        if (set_divisor.isPow2()) return set_idx ^ hash;
+        return set_idx + hash < num_sets ? set_idx + hash : set_idx + hash - num_sets;
+    }
+    /// @brief Join the tag and set index of a line into its line address
+    /// @param tag The tag of the line
+    /// @param set_idx The set index of the line
+    /// @return The line address (address without the line offset)
+    inline A lineAddr(A tag, uint32_t set_idx) {
+        if (hashed_index) {
+            uint64_t hash = tagHash(tag);
+            if (set_divisor.isPow2()) set_idx ^= hash;
+            else set_idx = set_idx >= hash ? set_idx - hash : set_idx + num_sets - hash;
+        }
+        return tag * num_sets + set_idx;
+    }
+    /// @brief Hash a tag for a hashed set index, by folding it into a set index with XOR
+    /// @param tag The tag of the line
+    /// @return The hash (less than the number of sets)
+    inline uint64_t tagHash(A tag) {
+        uint64_t hash = 0;
+        for (uint64_t bits = tag; bits; bits >>= set_bits) hash ^= bits & ((1ull << set_bits) - 1);
+        return hash < num_sets ? hash : hash - num_sets;
+    }
+
+    /// @brief Get the index of the coherence checker's record of a line, looking it up if needed
+    /// @param line_idx The index of the line
+    /// @return The index of the record
+    uint32_t checkerRecord(uint32_t line_idx);
+
+    /// @brief Count every event recorded in the statistics
+    /// @return The sum of the statistics
+    size_t countEvents();
+    /// @brief Remember the line accessed, and whether the access was a repeat with no effect other than counting it
+    /// @param line_addr The line address accessed
+    /// @param write Whether the access was a write
+    /// @param silent Whether the access was a repeat that only counted the access
+    inline void endAccess(A line_addr, bool write, bool silent) {
+        if (line_addr != repeat_line_addr) {
+            repeat_line_addr = line_addr;
+            repeat_silent[0] = repeat_silent[1] = false;
+        } else if (silent) repeat_silent[write] = true;
+        else repeat_silent[0] = repeat_silent[1] = false;
+    }
+
+    /// @brief Stop coalescing repeated accesses of the line accessed last
+    inline void forgetRepeat() {
+        repeat_line_addr = (A)~0;
+        repeat_silent[0] = repeat_silent[1] = false;
+    }
+
+    /// @brief Locate a line in a cache of any geometry
+    /// @param addr The address being accessed
+    /// @return A pointer to the line if found, else nullptr
+    tagged_line<A>* findLineGeneric(A addr);
+    /// @brief Locate a line in a cache of a geometry known at compile time, which turns the set index into a constant
+    /// division (a mask for a power of 2) and unrolls the way loop
+    /// @tparam LINE_OFFSET The number of bits of the line offset field
+    /// @tparam NUM_SETS The number of sets
+    /// @tparam ASSOC The associativity
+    /// @param addr The address being accessed
+    /// @return A pointer to the line if found, else nullptr
+    template<uint32_t LINE_OFFSET, uint32_t NUM_SETS, uint32_t ASSOC>
+    tagged_line<A>* findLineKernel(A addr);
 
     /// @brief Initialize a line in the cache, performing a writeback if necessary
     /// @param addr The address that requires caching
     /// @return A pointer to the newly initialized cache line
     /// @note The line's state will be 'Invalid'
-    cache_line* allocate(addr_t addr);
-    /// @brief Locate a line in the cache
-    /// @param addr The address being accessed
-    /// @return A pointer to the line if found, else nullptr
-    cache_line* findLine(addr_t addr);
+    tagged_line<A>* allocate(A addr);
 };
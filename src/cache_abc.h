@@ -16,9 +16,41 @@ public:
     /// @return True if the 'COPIES-EXIST' line was asserted
     virtual bool issueBusMsg(bus_msg_e bus_msg) = 0;
 
+    /// @brief Check if the 'OWNED' line was asserted by the last bus message, meaning that another cache owns the
+    /// line and keeps responding to bus reads
+    /// @return True if the 'OWNED' line was asserted
+    virtual bool isOwnedElsewhere() = 0;
+
+    /// @brief Count an event that only the coherence protocol can detect
+    /// @param stat The statistic to increment
+    virtual void addStatistic(statistic_e stat) = 0;
+
     /// @brief Get the state of a line in the cache
     /// @param set_idx The index of the set containing the line
     /// @param way_idx The index of the way containing the line (0 to assoc-1)
     /// @return The state of the cache line
     virtual state_e getLineState(uint32_t set_idx, uint32_t way_idx) = 0;
+
+    /// @brief Get the number of lines in the cache
+    /// @return The number of lines
+    virtual uint32_t getNumLines() = 0;
+    /// @brief Get the index of a line in the cache, so that coherence protocols can keep per-line state
+    /// @param line The cache line (one of the cache's lines)
+    /// @return The index of the line (0 to the number of lines - 1)
+    virtual uint32_t getLineIndex(const cache_line* line) = 0;
+    /// @brief Get the tag of a line in the cache, so that replacement policies can remember evicted lines
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    /// @return The tag of the line (unique within its set)
+    virtual uint64_t getLineTag(uint32_t set_idx, uint32_t way_idx) = 0;
+
+    /// @brief Get the position in the trace of the next access of this cache's core to the line accessed now, so that
+    /// the OPT replacer can evict the line used furthest in the future
+    /// @return The trace record index of the next access (UINT64_MAX if there is none or it is unknown)
+    virtual uint64_t getNextUse() { return UINT64_MAX; }
+
+    /// @brief Get a seed for the random choices of the replacer, which differs between the caches of a run so that
+    /// they make independent choices
+    /// @return The seed (the same in every run of the cache's configuration)
+    virtual uint64_t getRandomSeed() { return 0; }
 };
@@ -0,0 +1,102 @@
+/// @file checkpoint.cc
+/// @brief Implementation of the checkpoint writer and reader
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "checkpoint.h"
+#include "memory_system.h"
+#include "trace_reader.h"
+
+/// @brief The version of the checkpoint format
+#define CHECKPOINT_VERSION 10
+
+/// @brief Write a length-prefixed string to a checkpoint
+/// @param out The checkpoint stream
+/// @param str The string to write
+static inline void writeString(std::ostream& out, const std::string& str) {
+    writeValue<uint32_t>(out, str.size());
+    out.write(str.data(), str.size());
+}
+
+/// @brief Encode the fields identifying the run that a checkpoint belongs to
+/// @param trace_reader The reader of the trace being processed
+/// @param configs The configuration of each memory system
+/// @return The encoded fields
+static std::string runInfo(const TraceReader& trace_reader, const std::vector<cache_config>& configs) {
+    std::ostringstream info;
+    writeValue<uint32_t>(info, trace_reader.version);
+    writeValue<uint32_t>(info, trace_reader.n_cores);
+    writeValue<uint32_t>(info, trace_reader.addr_width);
+    writeValue<uint64_t>(info, trace_reader.n_records);
+    writeValue<uint8_t>(info, options.classify_misses);
+    writeValue<uint8_t>(info, options.snoop_filter);
+    writeValue<uint8_t>(info, options.hashed_index);
+    writeValue<uint8_t>(info, options.check_coherence);
+    writeValue<uint32_t>(info, configs.size());
+    for (const cache_config& config : configs) {
+        writeValue<uint32_t>(info, config.cache_size);
+        writeValue<uint32_t>(info, config.line_size);
+        writeValue<uint32_t>(info, config.assoc);
+        writeString(info, config.coherence);
+        writeString(info, config.replacer);
+        writeString(info, config.directory);
+    }
+    return info.str();
+}
+
+template<typename A>
+std::string writeCheckpoint(const char* path, const TraceReader& trace_reader, const std::vector<cache_config>& configs,
+    const std::vector<MemorySystem<A>*>& memory_systems, uint64_t trace_offset) {
+    // Write to a temporary file first, so that a run killed while writing keeps its previous checkpoint
+    std::string temp_path = std::string(path) + ".tmp";
+    std::ofstream out(temp_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!out) return std::string("Checkpoint write error: ") + std::strerror(errno);
+
+    out.write("CSIMCKPT", 8);
+    writeValue<uint32_t>(out, CHECKPOINT_VERSION);
+    out << runInfo(trace_reader, configs);
+    writeValue<uint64_t>(out, trace_offset);
+    for (MemorySystem<A>* memory_system : memory_systems) memory_system->checkpoint(out);
+
+    out.close();
+    if (!out) return std::string("Checkpoint write error: ") + std::strerror(errno);
+    if (std::rename(temp_path.c_str(), path)) return std::string("Checkpoint write error: ") + std::strerror(errno);
+    return "";
+}
+
+template<typename A>
+std::string readCheckpoint(const char* path, const TraceReader& trace_reader, const std::vector<cache_config>& configs,
+    const std::vector<MemorySystem<A>*>& memory_systems, uint64_t& trace_offset) {
+    std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+    if (!in) return std::string("Checkpoint read error: ") + std::strerror(errno);
+
+    // Header
+    char magic[8] = { 0 };
+    uint32_t version = 0;
+    in.read(magic, sizeof(magic));
+    readValue(in, version);
+    if (memcmp(magic, "CSIMCKPT", sizeof(magic)) || version != CHECKPOINT_VERSION) return "Malformed checkpoint file";
+
+    // The checkpoint must come from the same trace, configurations and options
+    std::string expected_info = runInfo(trace_reader, configs);
+    std::string info(expected_info.size(), '\0');
+    in.read(info.data(), info.size());
+    if (info != expected_info) return "Checkpoint does not match the trace file, configurations or options";
+
+    // State
+    readValue(in, trace_offset);
+    for (MemorySystem<A>* memory_system : memory_systems) memory_system->restore(in);
+    if (!in || in.peek() != EOF) return "Malformed checkpoint file";
+    return "";
+}
+
+template std::string writeCheckpoint(const char* path, const TraceReader& trace_reader, const std::vector<cache_config>& configs,
+    const std::vector<MemorySystem<uint32_t>*>& memory_systems, uint64_t trace_offset);
+template std::string writeCheckpoint(const char* path, const TraceReader& trace_reader, const std::vector<cache_config>& configs,
+    const std::vector<MemorySystem<uint64_t>*>& memory_systems, uint64_t trace_offset);
+template std::string readCheckpoint(const char* path, const TraceReader& trace_reader, const std::vector<cache_config>& configs,
+    const std::vector<MemorySystem<uint32_t>*>& memory_systems, uint64_t& trace_offset);
+template std::string readCheckpoint(const char* path, const TraceReader& trace_reader, const std::vector<cache_config>& configs,
+    const std::vector<MemorySystem<uint64_t>*>& memory_systems, uint64_t& trace_offset);
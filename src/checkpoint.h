@@ -0,0 +1,85 @@
+/// @file checkpoint.h
+/// @brief Declaration of the checkpoint writer and reader, and the helpers the simulator components serialize their state with
+///
+/// Checkpoint format (native byte order, since a checkpoint is resumed on the machine that wrote it):
+/// - Magic number: the 8 characters "CSIMCKPT"
+/// - Format version (uint32_t): 10
+/// - The trace format version, number of cores and address width (uint32_t each), and the number of records
+///   in the trace (uint64_t), which must match the trace file on resume
+/// - The number of trace records processed (uint64_t)
+/// - Whether miss classification, snoop filters, hashed set indices and coherence checking are enabled (uint8_t
+///   each), which must match on resume
+/// - The number of configurations (uint32_t), followed by each configuration: its cache size, line size and
+///   associativity (uint32_t each), and its coherence protocol, replacement policy and directory protocol
+///   names (uint32_t length followed by the characters)
+/// - The state of each memory system, in configuration order (see MemorySystem::checkpoint)
+///
+/// The components write their state as flat arrays, so the size of a checkpoint (and the time to write it)
+/// is proportional to the cache footprint, independent of the trace length
+
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "typedefs.h"
+
+/// @brief Write a value to a checkpoint
+/// @param out The checkpoint stream
+/// @param value The value to write (trivially copyable)
+template<typename T>
+inline void writeValue(std::ostream& out, const T& value) {
+    out.write((const char*)&value, sizeof(T));
+}
+
+/// @brief Read a value from a checkpoint
+/// @param in The checkpoint stream
+/// @param value The value to read into (trivially copyable)
+template<typename T>
+inline void readValue(std::istream& in, T& value) {
+    in.read((char*)&value, sizeof(T));
+}
+
+/// @brief Write a flat array to a checkpoint in a single bulk write
+/// @param out The checkpoint stream
+/// @param data The array (of trivially copyable elements)
+/// @param count The number of elements
+template<typename T>
+inline void writeArray(std::ostream& out, const T* data, size_t count) {
+    out.write((const char*)data, count * sizeof(T));
+}
+
+/// @brief Read a flat array from a checkpoint in a single bulk read
+/// @param in The checkpoint stream
+/// @param data The array to read into (of trivially copyable elements)
+/// @param count The number of elements
+template<typename T>
+inline void readArray(std::istream& in, T* data, size_t count) {
+    in.read((char*)data, count * sizeof(T));
+}
+
+/// @brief Write a checkpoint of every memory system, replacing the checkpoint file only once it is complete
+/// @tparam A The address type
+/// @param path The path to the checkpoint file
+/// @param trace_reader The reader of the trace being processed
+/// @param configs The configuration of each memory system
+/// @param memory_systems The memory systems, in the same order as 'configs'
+/// @param trace_offset The number of trace records processed by every memory system
+/// @return An error message, or an empty string on success
+template<typename A>
+std::string writeCheckpoint(const char* path, const TraceReader& trace_reader, const std::vector<cache_config>& configs,
+    const std::vector<MemorySystem<A>*>& memory_systems, uint64_t trace_offset);
+
+/// @brief Restore every memory system from a checkpoint
+/// @tparam A The address type
+/// @param path The path to the checkpoint file
+/// @param trace_reader The reader of the trace being processed
+/// @param configs The configuration of each memory system
+/// @param memory_systems The newly constructed memory systems to restore, in the same order as 'configs'
+/// @param trace_offset Set to the number of trace records processed when the checkpoint was written
+/// @return An error message, or an empty string on success
+template<typename A>
+std::string readCheckpoint(const char* path, const TraceReader& trace_reader, const std::vector<cache_config>& configs,
+    const std::vector<MemorySystem<A>*>& memory_systems, uint64_t& trace_offset);
@@ -47,18 +47,37 @@ public:
     /// @return True if the line was flushed to the bus
     virtual bool BusWr(cache_line* line) { UNIMPLEMENTED; };
 
+    /// @brief Receive notice that a line was allocated for a new address, before the access that missed on it
+    /// @param line The cache line allocated (invalid)
+    virtual void notifyAllocated(cache_line* line) {}
+
     /// @brief Determine whether the coherence protocol does dirty sharing
     /// @return True if the coherence protocol does dirty sharing
     virtual bool doesDirtySharing() { return false; }
     /// @brief Determine whether the coherence protocol uses write no-allocate
     /// @return True if the coherence protocol uses write no-allocate
     virtual bool doesWriteNoAllocate() { return false; }
+    /// @brief Determine whether the coherence protocol writes bus updates through to main memory
+    /// @return True if the coherence protocol writes bus updates through to main memory
+    virtual bool doesUpdateMemory() { return false; }
 
     /// @brief Determine whether a line needs to be written back to main memory
     /// @param state The state of the line
     /// @return Whether the line needs to be written back to main memory
     virtual bool isWriteBackNeeded(state_e state) = 0;
 
+    /// @brief Determine whether a line can be in a state under this protocol
+    /// @param state The state of the line
+    /// @return Whether the protocol has the state (so that it can take over lines in that state from another protocol)
+    virtual bool isStateSupported(state_e state) = 0;
+
+    /// @brief Write the protocol's internal state (if any) to a checkpoint
+    /// @param out The checkpoint stream
+    virtual void checkpoint(std::ostream& out) {}
+    /// @brief Restore the protocol's internal state (if any) from a checkpoint
+    /// @param in The checkpoint stream
+    virtual void restore(std::istream& in) {}
+
 protected:
 
     /// @brief The parent cache
@@ -68,5 +87,5 @@ protected:
 /// @brief Create a mapping in 'coherence_map' from a string containing the class name to a factory method for the class
 /// @param coh_prot The coherence protocol type
 #define ADD_COHERENCE_TO_CMD_LINE(coh_prot) static int register_coherence = []() { \
-if (coherence_map == nullptr) coherence_map = new std::map<std::string, coh_factory_t, ci_less>(); \
+if (coherence_map == nullptr) coherence_map = new std::map<std::string, coh_factory_t, protocol_less>(); \
 (*coherence_map)[#coh_prot] = [](CacheABC& cache) { return new coh_prot(cache); }; return 0; }()
@@ -0,0 +1,100 @@
+/// @file competitive.cc
+/// @brief Implementation of the Competitive coherence protocol
+
+#include "checkpoint.h"
+#include "competitive.h"
+
+ADD_COHERENCE_TO_CMD_LINE(Competitive);
+
+void Competitive::PrRd(cache_line* line) {
+    update_counts[cache.getLineIndex(line)] = 0;
+    switch (line->state) {
+    case E:
+    case Sc:
+    case Sm:
+    case M:
+        break;
+    case I:
+        line->state = cache.issueBusMsg(BusRead) ? Sc : E;
+        break;
+    default:
+        STATE_ERR;
+        return;
+    }
+}
+
+void Competitive::PrWr(cache_line* line) {
+    update_counts[cache.getLineIndex(line)] = 0;
+    switch (line->state) {
+    case E:
+        line->state = M;
+        break;
+    case Sc:
+    case Sm:
+        // Once every other copy invalidated itself, the line is no longer shared and updates stop
+        line->state = cache.issueBusMsg(BusUpdate) ? Sm : M;
+    case M:
+        break;
+    case I:
+        line->state =
+            // Short circuit AND. BusUpdate is only issued if other caches have the line
+            cache.issueBusMsg(BusRead) && cache.issueBusMsg(BusUpdate)
+            ? Sm : M;
+        break;
+    default:
+        STATE_ERR;
+        return;
+    }
+}
+
+bool Competitive::BusRd(cache_line* line) {
+    switch (line->state) {
+    case E:
+        line->state = Sc;
+    case Sc:
+    case I:
+        return false;
+    case M:
+        line->state = Sm;
+    case Sm:
+        return true;
+    default:
+        STATE_ERR;
+        return false;
+    }
+}
+
+bool Competitive::BusUpdt(cache_line* line) {
+    switch (line->state) {
+    case Sm:
+        line->state = Sc;
+    case Sc:
+        // The updater became the owner, so the copy is clean and can be dropped without a write back
+        if (++update_counts[cache.getLineIndex(line)] >= COMPETITIVE_UPDATE_LIMIT) line->state = I;
+    case I:
+        return false;
+    default:
+        STATE_ERR;
+        return false;
+    }
+}
+
+bool Competitive::doesDirtySharing() {
+    return true;
+}
+
+bool Competitive::isWriteBackNeeded(state_e state) {
+    return state == Sm || state == M;
+}
+
+bool Competitive::isStateSupported(state_e state) {
+    return state == I || state == Sc || state == E || state == Sm || state == M;
+}
+
+void Competitive::checkpoint(std::ostream& out) {
+    writeArray(out, update_counts.data(), update_counts.size());
+}
+
+void Competitive::restore(std::istream& in) {
+    readArray(in, update_counts.data(), update_counts.size());
+}
@@ -0,0 +1,66 @@
+/// @file competitive.h
+/// @brief Declaration of the Competitive coherence protocol
+
+#pragma once
+
+#include <vector>
+
+#include "coherence_protocol.h"
+
+#ifndef COMPETITIVE_UPDATE_LIMIT
+/// @brief The number of consecutive bus updates a line may receive without being accessed before it is invalidated
+#define COMPETITIVE_UPDATE_LIMIT 4
+#endif
+
+/// @brief The competitive-update coherence protocol: Dragon, except that a copy which receives
+/// COMPETITIVE_UPDATE_LIMIT bus updates in a row without being accessed by its own processor invalidates itself, so
+/// that the writer stops broadcasting updates nobody reads
+class Competitive : public CoherenceProtocol {
+public:
+
+    /// @brief Construct a new Competitive coherence protocol
+    /// @param cache The parent cache
+    Competitive(CacheABC& cache) : CoherenceProtocol(cache), update_counts(cache.getNumLines(), 0) {}
+
+    /// @brief Receive a PrRd message
+    /// @param line The cache line accessed (non-null)
+    void PrRd(cache_line* line);
+    /// @brief Receive a PrWr message
+    /// @param line The cache line accessed (non-null)
+    void PrWr(cache_line* line);
+
+    /// @brief Receive a BusRd message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusRd(cache_line* line);
+    /// @brief Receive a BusUpdt message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusUpdt(cache_line* line);
+
+    /// @brief Determine whether the coherence protocol does dirty sharing
+    /// @return True if the coherence protocol does dirty sharing
+    bool doesDirtySharing();
+
+    /// @brief Determine whether a line needs to be written back to main memory
+    /// @param state The state of the line
+    /// @return Whether the line needs to be written back to main memory
+    bool isWriteBackNeeded(state_e state);
+
+    /// @brief Determine whether a line can be in a state under this protocol
+    /// @param state The state of the line
+    /// @return Whether the protocol has the state
+    bool isStateSupported(state_e state);
+
+    /// @brief Write the update counter of each line to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the update counter of each line from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
+private:
+
+    /// @brief The number of bus updates each line received since its processor last accessed it
+    std::vector<uint8_t> update_counts;
+};
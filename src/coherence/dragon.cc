@@ -78,3 +78,7 @@ bool Dragon::doesDirtySharing() {
 bool Dragon::isWriteBackNeeded(state_e state) {
     return state == Sm || state == M;
 }
+
+bool Dragon::isStateSupported(state_e state) {
+    return state == Unallocated || state == Sc || state == E || state == Sm || state == M;
+}
@@ -0,0 +1,81 @@
+/// @file firefly.cc
+/// @brief Implementation of the Firefly coherence protocol
+
+#include "firefly.h"
+
+ADD_COHERENCE_TO_CMD_LINE(Firefly);
+
+void Firefly::PrRd(cache_line* line) {
+    switch (line->state) {
+    case E:
+    case S:
+    case D:
+        break;
+    case Unallocated:
+        line->state = cache.issueBusMsg(BusRead) ? S : E;
+        break;
+    default:
+        STATE_ERR;
+        return;
+    }
+}
+
+void Firefly::PrWr(cache_line* line) {
+    switch (line->state) {
+    case E:
+        line->state = D;
+        break;
+    case S:
+        // Main memory is updated as well, so the line stays clean even if no other copy is left
+        line->state = cache.issueBusMsg(BusUpdate) ? S : E;
+    case D:
+        break;
+    case Unallocated:
+        line->state =
+            // Short circuit AND. BusUpdate is only issued if other caches have the line
+            cache.issueBusMsg(BusRead) && cache.issueBusMsg(BusUpdate)
+            ? S : D;
+        break;
+    default:
+        STATE_ERR;
+        return;
+    }
+}
+
+bool Firefly::BusRd(cache_line* line) {
+    switch (line->state) {
+    case E:
+    case D:
+        line->state = S;
+    case S:
+        return true;
+    case Unallocated:
+        return false;
+    default:
+        STATE_ERR;
+        return false;
+    }
+}
+
+bool Firefly::BusUpdt(cache_line* line) {
+    switch (line->state) {
+    case S:
+    case Unallocated:
+        return false;
+    default:
+        STATE_ERR;
+        return false;
+    }
+}
+
+bool Firefly::doesUpdateMemory() {
+    return true;
+}
+
+bool Firefly::isWriteBackNeeded(state_e state) {
+    return state == D;
+}
+
+bool Firefly::isStateSupported(state_e state) {
+    return state == Unallocated || state == E || state == S || state == D;
+}
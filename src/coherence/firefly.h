@@ -0,0 +1,46 @@
+/// @file firefly.h
+/// @brief Declaration of the Firefly coherence protocol
+
+#pragma once
+
+#include "coherence_protocol.h"
+
+/// @brief The Firefly coherence protocol, an update protocol where writes to shared lines are also written through to
+/// main memory, so that shared lines are never dirty
+class Firefly : public CoherenceProtocol {
+public:
+
+    /// @brief Construct a new Firefly coherence protocol
+    /// @param cache The parent cache
+    Firefly(CacheABC& cache) : CoherenceProtocol(cache) {}
+
+    /// @brief Receive a PrRd message
+    /// @param line The cache line accessed (non-null)
+    void PrRd(cache_line* line);
+    /// @brief Receive a PrWr message
+    /// @param line The cache line accessed (non-null)
+    void PrWr(cache_line* line);
+
+    /// @brief Receive a BusRd message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusRd(cache_line* line);
+    /// @brief Receive a BusUpdt message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusUpdt(cache_line* line);
+
+    /// @brief Determine whether the coherence protocol writes bus updates through to main memory
+    /// @return True if the coherence protocol writes bus updates through to main memory
+    bool doesUpdateMemory();
+
+    /// @brief Determine whether a line needs to be written back to main memory
+    /// @param state The state of the line
+    /// @return Whether the line needs to be written back to main memory
+    bool isWriteBackNeeded(state_e state);
+
+    /// @brief Determine whether a line can be in a state under this protocol
+    /// @param state The state of the line
+    /// @return Whether the protocol has the state
+    bool isStateSupported(state_e state);
+};
@@ -83,3 +83,7 @@ bool MESI::BusUpgr(cache_line* line) {
 bool MESI::isWriteBackNeeded(state_e state) {
     return state == M;
 }
+
+bool MESI::isStateSupported(state_e state) {
+    return state == I || state == S || state == E || state == M;
+}
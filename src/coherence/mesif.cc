@@ -0,0 +1,96 @@
+/// @file mesif.cc
+/// @brief Implementation of the MESIF coherence protocol
+
+#include "mesif.h"
+
+ADD_COHERENCE_TO_CMD_LINE(MESIF);
+
+void MESIF::PrRd(cache_line* line) {
+    switch (line->state) {
+    case M:
+    case E:
+    case F:
+    case S:
+        break;
+    case I:
+        // The new sharer takes over forwarding the line from the previous forwarder
+        line->state = cache.issueBusMsg(BusRead) ? F : E;
+        break;
+    default:
+        STATE_ERR;
+        return;
+    }
+}
+
+void MESIF::PrWr(cache_line* line) {
+    switch (line->state) {
+    case I:
+        cache.issueBusMsg(BusReadX);
+        line->state = M;
+        break;
+    case F:
+    case S:
+        cache.issueBusMsg(BusUpgrade);
+    case E:
+        line->state = M;
+    case M:
+        break;
+    default:
+        STATE_ERR;
+        return;
+    }
+}
+
+bool MESIF::BusRd(cache_line* line) {
+    switch (line->state) {
+    case M:
+    case E:
+    case F:
+        line->state = S;
+        return true;
+    case S: // The forwarder responds instead, or main memory if there is none
+    case I:
+        return false;
+    default:
+        STATE_ERR;
+        return false;
+    }
+}
+
+bool MESIF::BusRdX(cache_line* line) {
+    switch (line->state) {
+    case M:
+    case E:
+    case F:
+        line->state = I;
+        return true;
+    case S:
+        line->state = I;
+    case I:
+        return false;
+    default:
+        STATE_ERR;
+        return false;
+    }
+}
+
+bool MESIF::BusUpgr(cache_line* line) {
+    switch (line->state) {
+    case F:
+    case S:
+        line->state = I;
+    case I:
+        return false;
+    default:
+        STATE_ERR;
+        return false;
+    }
+}
+
+bool MESIF::isWriteBackNeeded(state_e state) {
+    return state == M;
+}
+
+bool MESIF::isStateSupported(state_e state) {
+    return state == I || state == S || state == E || state == M || state == F;
+}
@@ -0,0 +1,78 @@
+/// @file migratory_mesi.cc
+/// @brief Implementation of the MigratoryMESI coherence protocol
+
+#include "checkpoint.h"
+#include "migratory_mesi.h"
+
+ADD_COHERENCE_TO_CMD_LINE(MigratoryMESI);
+
+/// @brief The bits of a predictor holding the saturating counter
+#define PREDICTOR_COUNTER 3
+/// @brief The counter value from which a line is predicted to be migratory
+#define PREDICTOR_THRESHOLD 2
+/// @brief The bit of a predictor set while a line granted on a read miss is not written yet
+#define PREDICTOR_GRANTED 4
+
+void MigratoryMESI::PrRd(cache_line* line) {
+    uint8_t& predictor = predictors[cache.getLineIndex(line)];
+    if (line->state != I) return MESI::PrRd(line);
+
+    // A grant is only pending while the line is valid
+    predictor &= ~PREDICTOR_GRANTED;
+    if ((predictor & PREDICTOR_COUNTER) < PREDICTOR_THRESHOLD) return MESI::PrRd(line);
+
+    // Take exclusive ownership right away (the line may be dirty if it came from another cache)
+    cache.addStatistic(MigratoryPrediction);
+    line->state = cache.issueBusMsg(BusReadX) ? M : E;
+    predictor |= PREDICTOR_GRANTED;
+}
+
+void MigratoryMESI::PrWr(cache_line* line) {
+    uint8_t& predictor = predictors[cache.getLineIndex(line)];
+    if (predictor & PREDICTOR_GRANTED) {
+        // The write the line was granted for
+        if (line->state != I) {
+            cache.addStatistic(MigratoryPredictionCorrect);
+            if ((predictor & PREDICTOR_COUNTER) < PREDICTOR_COUNTER) predictor++;
+        }
+        predictor &= ~PREDICTOR_GRANTED;
+    } else if (line->state == S && (predictor & PREDICTOR_COUNTER) < PREDICTOR_COUNTER) {
+        // A shared line that is read and then written is what a migratory line looks like
+        predictor++;
+    }
+    MESI::PrWr(line);
+}
+
+void MigratoryMESI::notifyAllocated(cache_line* line) {
+    predictors[cache.getLineIndex(line)] = 0;
+}
+
+bool MigratoryMESI::BusRd(cache_line* line) {
+    snooped(line);
+    return MESI::BusRd(line);
+}
+
+bool MigratoryMESI::BusRdX(cache_line* line) {
+    snooped(line);
+    return MESI::BusRdX(line);
+}
+
+bool MigratoryMESI::BusUpgr(cache_line* line) {
+    snooped(line);
+    return MESI::BusUpgr(line);
+}
+
+void MigratoryMESI::snooped(cache_line* line) {
+    uint8_t& predictor = predictors[cache.getLineIndex(line)];
+    if (!(predictor & PREDICTOR_GRANTED) || line->state == I) return;
+    if (predictor & PREDICTOR_COUNTER) predictor--;
+    predictor &= ~PREDICTOR_GRANTED;
+}
+
+void MigratoryMESI::checkpoint(std::ostream& out) {
+    writeArray(out, predictors.data(), predictors.size());
+}
+
+void MigratoryMESI::restore(std::istream& in) {
+    readArray(in, predictors.data(), predictors.size());
+}
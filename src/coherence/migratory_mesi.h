@@ -0,0 +1,63 @@
+/// @file migratory_mesi.h
+/// @brief Declaration of the MigratoryMESI coherence protocol
+
+#pragma once
+
+#include <vector>
+
+#include "mesi.h"
+
+/// @brief The MESI coherence protocol with adaptive detection of migratory lines (read, then written, by one
+/// processor after the other). A 2-bit saturating counter per line learns whether the line is migratory, in which
+/// case a read miss requests exclusive ownership (BusRdX) and the BusUpgr of the following write is saved
+///
+/// The counters belong to the cache lines, and are reset when a line is allocated for a new address, so that an address
+/// does not inherit the prediction of the address it replaced
+class MigratoryMESI : public MESI {
+public:
+
+    /// @brief Construct a new MigratoryMESI coherence protocol
+    /// @param cache The parent cache
+    MigratoryMESI(CacheABC& cache) : MESI(cache), predictors(cache.getNumLines(), 0) {}
+
+    /// @brief Receive a PrRd message
+    /// @param line The cache line accessed (non-null)
+    void PrRd(cache_line* line);
+    /// @brief Receive a PrWr message
+    /// @param line The cache line accessed (non-null)
+    void PrWr(cache_line* line);
+
+    /// @brief Reset the predictor of a line allocated for a new address
+    /// @param line The cache line allocated
+    void notifyAllocated(cache_line* line);
+
+    /// @brief Receive a BusRd message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusRd(cache_line* line);
+    /// @brief Receive a BusRdX message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusRdX(cache_line* line);
+    /// @brief Receive a BusUpgr message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusUpgr(cache_line* line);
+
+    /// @brief Write the predictor of each line to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the predictor of each line from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
+private:
+
+    /// @brief The predictor of each line: a 2-bit saturating counter (lowest bits), and whether the line was last
+    /// read with exclusive ownership and is not written yet (PREDICTOR_GRANTED)
+    std::vector<uint8_t> predictors;
+
+    /// @brief Another cache accessed a line, which is a misprediction if the line was granted and not written yet
+    /// @param line The cache line accessed
+    void snooped(cache_line* line);
+};
@@ -95,3 +95,7 @@ bool MOESI::doesDirtySharing() {
 bool MOESI::isWriteBackNeeded(state_e state) {
     return state == M || state == O;
 }
+
+bool MOESI::isStateSupported(state_e state) {
+    return state == I || state == S || state == E || state == O || state == M;
+}
@@ -0,0 +1,108 @@
+/// @file moesif.cc
+/// @brief Implementation of the MOESIF coherence protocol
+
+#include "moesif.h"
+
+ADD_COHERENCE_TO_CMD_LINE(MOESIF);
+
+void MOESIF::PrRd(cache_line* line) {
+    switch (line->state) {
+    case M:
+    case O:
+    case E:
+    case F:
+    case S:
+        break;
+    case I:
+        // The new sharer takes over forwarding a clean line, while the owner of a dirty line keeps responding
+        if (!cache.issueBusMsg(BusRead)) line->state = E;
+        else line->state = cache.isOwnedElsewhere() ? S : F;
+        break;
+    default:
+        STATE_ERR;
+        return;
+    }
+}
+
+void MOESIF::PrWr(cache_line* line) {
+    switch (line->state) {
+    case I:
+        cache.issueBusMsg(BusReadX);
+        line->state = M;
+        break;
+    case O:
+    case F:
+    case S:
+        cache.issueBusMsg(BusUpgrade);
+    case E:
+        line->state = M;
+    case M:
+        break;
+    default:
+        STATE_ERR;
+        return;
+    }
+}
+
+bool MOESIF::BusRd(cache_line* line) {
+    switch (line->state) {
+    case M:
+        line->state = O;
+    case O:
+        return true;
+    case E:
+    case F:
+        line->state = S;
+        return true;
+    case S: // The owner or forwarder responds instead, or main memory if there is neither
+    case I:
+        return false;
+    default:
+        STATE_ERR;
+        return false;
+    }
+}
+
+bool MOESIF::BusRdX(cache_line* line) {
+    switch (line->state) {
+    case M:
+    case O:
+    case E:
+    case F:
+        line->state = I;
+        return true;
+    case S:
+        line->state = I;
+    case I:
+        return false;
+    default:
+        STATE_ERR;
+        return false;
+    }
+}
+
+bool MOESIF::BusUpgr(cache_line* line) {
+    switch (line->state) {
+    case O:
+    case F:
+    case S:
+        line->state = I;
+    case I:
+        return false;
+    default:
+        STATE_ERR;
+        return false;
+    }
+}
+
+bool MOESIF::doesDirtySharing() {
+    return true;
+}
+
+bool MOESIF::isWriteBackNeeded(state_e state) {
+    return state == M || state == O;
+}
+
+bool MOESIF::isStateSupported(state_e state) {
+    return state == I || state == S || state == E || state == O || state == M || state == F;
+}
@@ -0,0 +1,50 @@
+/// @file moesif.h
+/// @brief Declaration of the MOESIF coherence protocol
+
+#pragma once
+
+#include "coherence_protocol.h"
+
+/// @brief The MOESIF coherence protocol, where a shared line has a single responder to bus reads: the owner (O) of
+/// a dirty line, or else the most recent reader of the clean line (F)
+class MOESIF : public CoherenceProtocol {
+public:
+
+    /// @brief Construct a new MOESIF coherence protocol
+    /// @param cache The parent cache
+    MOESIF(CacheABC& cache) : CoherenceProtocol(cache) {}
+
+    /// @brief Receive a PrRd message
+    /// @param line The cache line accessed (non-null)
+    void PrRd(cache_line* line);
+    /// @brief Receive a PrWr message
+    /// @param line The cache line accessed (non-null)
+    void PrWr(cache_line* line);
+
+    /// @brief Receive a BusRd message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusRd(cache_line* line);
+    /// @brief Receive a BusRdX message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusRdX(cache_line* line);
+    /// @brief Receive a BusUpgr message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusUpgr(cache_line* line);
+
+    /// @brief Determine whether the coherence protocol does dirty sharing
+    /// @return True if the coherence protocol does dirty sharing
+    bool doesDirtySharing();
+
+    /// @brief Determine whether a line needs to be written back to main memory
+    /// @param state The state of the line
+    /// @return Whether the line needs to be written back to main memory
+    bool isWriteBackNeeded(state_e state);
+
+    /// @brief Determine whether a line can be in a state under this protocol
+    /// @param state The state of the line
+    /// @return Whether the protocol has the state
+    bool isStateSupported(state_e state);
+};
@@ -66,3 +66,7 @@ bool MSI::BusRdX(cache_line* line) {
 bool MSI::isWriteBackNeeded(state_e state) {
     return state == M;
 }
+
+bool MSI::isStateSupported(state_e state) {
+    return state == I || state == S || state == M;
+}
@@ -33,4 +33,9 @@ public:
     /// @param state The state of the line
     /// @return Whether the line needs to be written back to main memory
     bool isWriteBackNeeded(state_e state);
+
+    /// @brief Determine whether a line can be in a state under this protocol
+    /// @param state The state of the line
+    /// @return Whether the protocol has the state
+    bool isStateSupported(state_e state);
 };
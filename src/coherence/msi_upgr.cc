@@ -81,3 +81,7 @@ bool MSIUpgr::BusUpgr(cache_line* line) {
 bool MSIUpgr::isWriteBackNeeded(state_e state) {
     return state == M;
 }
+
+bool MSIUpgr::isStateSupported(state_e state) {
+    return state == I || state == S || state == M;
+}
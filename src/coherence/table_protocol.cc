@@ -0,0 +1,215 @@
+/// @file table_protocol.cc
+/// @brief Implementation of the TableProtocol coherence protocol and its spec file parser
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "table_protocol.h"
+
+/// @brief Spec file names of the events in table_event_e
+constexpr const char* spec_event_names[N_TABLE_EVENTS] = { "PrRd", "PrWr", "BusRd", "BusRdX", "BusUpdt", "BusUpgr", "BusWr" };
+/// @brief The bus message issued for each bus event in table_event_e (processor events are not bus messages)
+constexpr bus_msg_e event_bus_msgs[N_TABLE_EVENTS] = { ProcRead, ProcWrite, BusRead, BusReadX, BusUpdate, BusUpgrade, BusWrite };
+
+/// @brief Find a state by its spec file name
+/// @param name The name of the state (case-sensitive, since 'S' and 'Sc' differ only by a letter)
+/// @param state The state found
+/// @return True if the name is a state
+static bool parseState(const std::string& name, state_e& state) {
+    for (int i = 0; i < N_STATES; i++)
+        if (name == state_names[i]) {
+            state = static_cast<state_e>(i);
+            return true;
+        }
+    return false;
+}
+
+/// @brief Find an event by its spec file name
+/// @param name The name of the event
+/// @param event The event found
+/// @return True if the name is an event
+static bool parseEvent(const std::string& name, table_event_e& event) {
+    for (int i = 0; i < N_TABLE_EVENTS; i++)
+        if (name == spec_event_names[i]) {
+            event = static_cast<table_event_e>(i);
+            return true;
+        }
+    return false;
+}
+
+/// @brief Parse a transition line of a spec file into the table
+/// @param fields The fields of the line, after the state
+/// @param state The state the transition starts from
+/// @param table The table to add the transition to
+/// @param event The event of the transition
+/// @return An error message, or an empty string if the transition is valid
+static std::string parseTransition(std::istringstream& fields, state_e state, protocol_table& table, table_event_e& event) {
+    std::string field;
+    if (!(fields >> field)) return "Missing event";
+    if (!parseEvent(field, event)) return "Unknown event '" + field + "'";
+    table_transition& transition = table.transitions[state][event];
+    if (transition.defined) return "Duplicate transition for " + std::string(state_names[state]) + ' ' + field;
+    if (!(fields >> field)) return "Missing next state";
+    if (!parseState(field, transition.next)) return "Unknown state '" + field + "'";
+    transition.shared = transition.owned = transition.next;
+    transition.defined = true;
+
+    bool has_shared = false, has_owned = false;
+    while (fields >> field) {
+        if (field == "flush") {
+            if (event <= EVENT_PRWR) return "Only bus events can flush the line";
+            transition.flush = true;
+        } else if (!field.compare(0, 7, "shared=")) {
+            if (!parseState(field.substr(7), transition.shared)) return "Unknown state '" + field.substr(7) + "'";
+            has_shared = true;
+        } else if (!field.compare(0, 6, "owned=")) {
+            if (!parseState(field.substr(6), transition.owned)) return "Unknown state '" + field.substr(6) + "'";
+            has_owned = true;
+        } else {
+            // A comma-separated list of bus messages
+            if (event > EVENT_PRWR) return "Only processor events can issue bus messages";
+            if (transition.n_bus_msgs) return "Bus messages must be given as one comma-separated list";
+            std::istringstream msgs(field);
+            std::string msg;
+            while (std::getline(msgs, msg, ',')) {
+                table_event_e bus_event;
+                if (!parseEvent(msg, bus_event) || bus_event <= EVENT_PRWR) return "Unknown bus message '" + msg + "'";
+                if (transition.n_bus_msgs == 2) return "At most two bus messages can be issued";
+                transition.bus_msgs[transition.n_bus_msgs++] = event_bus_msgs[bus_event];
+            }
+        }
+    }
+    if ((has_shared || has_owned) && !transition.n_bus_msgs) return "shared= and owned= need a bus message";
+    if (!has_owned) transition.owned = transition.shared;
+    return "";
+}
+
+/// @brief Parse and validate a spec file
+/// @param path The path to the spec file
+/// @param table The table to fill
+/// @return An error message, or an empty string if the spec is valid
+static std::string parseSpec(const std::string& path, protocol_table& table) {
+    std::ifstream spec_file(path);
+    if (!spec_file) return "Coherence spec read error: " + path + ": " + std::strerror(errno);
+
+    // Undefined transitions keep the line in its state, which makes bus events on invalid lines no-ops
+    for (int state = 0; state < N_STATES; state++)
+        for (int event = 0; event < N_TABLE_EVENTS; event++) {
+            table_transition& transition = table.transitions[state][event];
+            transition.next = transition.shared = transition.owned = static_cast<state_e>(state);
+        }
+
+    // Line numbers of the definitions, for error messages
+    uint32_t transition_lines[N_STATES][N_TABLE_EVENTS] = {};
+    uint32_t states_line = 0, writeback_line = 0;
+
+    std::string spec_line;
+    for (uint32_t line_num = 1; std::getline(spec_file, spec_line); line_num++) {
+        std::string error;
+        std::istringstream fields(spec_line.substr(0, spec_line.find('#')));
+        std::string keyword, field;
+        if (!(fields >> keyword)) continue;
+
+        state_e state;
+        if (keyword == "states" || keyword == "writeback") {
+            uint32_t& states = keyword == "states" ? table.states : table.writeback_states;
+            (keyword == "states" ? states_line : writeback_line) = line_num;
+            while (error.empty() && fields >> field) {
+                if (!parseState(field, state)) error = "Unknown state '" + field + "'";
+                else if (states >> state & 1) error = "State " + field + " listed twice";
+                states |= 1 << state;
+            }
+        } else if (keyword == "option") {
+            while (error.empty() && fields >> field) {
+                if (field == "dirty-sharing") table.dirty_sharing = true;
+                else if (field == "write-no-allocate") table.write_no_allocate = true;
+                else if (field == "update-memory") table.update_memory = true;
+                else error = "Unknown option '" + field + "'";
+            }
+        } else if (parseState(keyword, state)) {
+            table_event_e event;
+            error = parseTransition(fields, state, table, event);
+            if (error.empty()) transition_lines[state][event] = line_num;
+        } else error = "Unknown state or directive '" + keyword + "'";
+
+        if (!error.empty()) return path + ':' + std::to_string(line_num) + ": " + error;
+    }
+
+    // Validate the table as a whole
+    auto at = [&path](uint32_t line_num) { return path + ':' + std::to_string(line_num) + ": "; };
+    if (!(table.states & 1 << I)) return at(states_line) + "The states must include I";
+    if (table.writeback_states & ~table.states) return at(writeback_line) + "Write back states must be in the states";
+
+    // Bus messages issued by the protocol must be handled by every valid state
+    uint32_t issued = 0;
+    for (int state = 0; state < N_STATES; state++)
+        for (int event = 0; event < N_TABLE_EVENTS; event++) {
+            const table_transition& transition = table.transitions[state][event];
+            if (!transition.defined) continue;
+            uint32_t line_num = transition_lines[state][event];
+            if (!(table.states >> state & 1)) return at(line_num) + "Transition from undeclared state " + state_names[state];
+            if (!(table.states >> transition.next & 1) || !(table.states >> transition.shared & 1) || !(table.states >> transition.owned & 1))
+                return at(line_num) + "Transition to undeclared state";
+            // Invalid lines must ignore bus messages, since the snoop filter keeps them from caches without a valid copy
+            if (state == I && event > EVENT_PRWR && (transition.next != I || transition.flush))
+                return at(line_num) + "Invalid lines must ignore bus events";
+            for (uint8_t i = 0; i < transition.n_bus_msgs; i++) issued |= 1 << (transition.bus_msgs[i] - BusRead + EVENT_BUSRD);
+        }
+    for (int state = 0; state < N_STATES; state++) {
+        if (!(table.states >> state & 1)) continue;
+        for (int event = 0; event < N_TABLE_EVENTS; event++)
+            // Bus messages are ignored by invalid lines unless the spec says otherwise
+            if (!table.transitions[state][event].defined && (event <= EVENT_PRWR || (state != I && issued >> event & 1)))
+                return at(states_line) + "Missing transition for " + state_names[state] + ' ' + spec_event_names[event];
+    }
+
+    // Every state must be reachable from I
+    uint32_t reached = 1 << I;
+    for (uint32_t prev_reached = 0; reached != prev_reached;) {
+        prev_reached = reached;
+        for (int state = 0; state < N_STATES; state++)
+            if (prev_reached >> state & 1)
+                for (const table_transition& transition : table.transitions[state])
+                    reached |= 1 << transition.next | 1 << transition.shared | 1 << transition.owned;
+    }
+    for (int state = 0; state < N_STATES; state++)
+        if (table.states & ~reached & 1 << state) return at(states_line) + "State " + state_names[state] + " is unreachable from I";
+
+    return "";
+}
+
+std::string TableProtocol::registerSpec(const std::string& name) {
+    // Only names with the prefix refer to spec files, and each spec file only needs to be loaded once
+    size_t prefix_len = std::strlen(TABLE_PROTOCOL_PREFIX);
+    if (name.length() <= prefix_len || strncasecmp(name.c_str(), TABLE_PROTOCOL_PREFIX, prefix_len) || coherence_map->count(name))
+        return "";
+
+    auto table = std::make_shared<protocol_table>();
+    std::string error = parseSpec(name.substr(prefix_len), *table);
+    if (!error.empty()) return error;
+
+    std::shared_ptr<const protocol_table> shared_table = table;
+    (*coherence_map)[name] = [shared_table](CacheABC& cache) { return new TableProtocol(cache, shared_table); };
+    return "";
+}
+
+void TableProtocol::PrRd(cache_line* line) {
+    processorEvent(line, EVENT_PRRD);
+}
+
+void TableProtocol::PrWr(cache_line* line) {
+    processorEvent(line, EVENT_PRWR);
+}
+
+void TableProtocol::processorEvent(cache_line* line, table_event_e event) {
+    // Lines not allocated under write no-allocate behave as invalid lines
+    const table_transition& transition = table->transitions[line ? line->state : I][event];
+
+    // The second bus message is only issued if other caches have the line (like the Dragon protocol)
+    bool copies = transition.n_bus_msgs && cache.issueBusMsg(transition.bus_msgs[0]);
+    if (copies && transition.n_bus_msgs == 2) copies = cache.issueBusMsg(transition.bus_msgs[1]);
+
+    if (line) line->state = !copies ? transition.next : cache.isOwnedElsewhere() ? transition.owned : transition.shared;
+}
@@ -0,0 +1,153 @@
+/// @file table_protocol.h
+/// @brief Declaration of the TableProtocol coherence protocol, which executes a transition table loaded from a spec file
+///
+/// A coherence protocol spec file has one directive or transition per line ('#' starts a comment):
+/// - 'states <state..>': The states of the protocol (I is required), from I, D, E, M, V, O, S, Sc, Sm and F
+/// - 'writeback <state..>': The states which are written back to main memory when evicted
+/// - 'option <dirty-sharing|write-no-allocate|update-memory>': See the CoherenceProtocol method of the same name
+/// - '<state> <event> <next_state> [bus_msg[,bus_msg]] [flush] [shared=<state>] [owned=<state>]': A transition
+///   - event: PrRd, PrWr, BusRd, BusRdX, BusUpdt, BusUpgr or BusWr
+///   - bus_msg: The bus message(s) issued on a processor event. The second message is only issued if the first one
+///     asserted the 'COPIES-EXIST' line
+///   - flush: The line is flushed to the bus on a bus event
+///   - shared: The next state if the (last) bus message asserted the 'COPIES-EXIST' line
+///   - owned: The next state if the 'OWNED' line was asserted as well
+///
+/// The table is validated when it is loaded: every transition must be between declared states, every state must
+/// define both processor events and every bus event that the protocol issues, invalid lines must ignore bus events, and
+/// every state must be reachable from I
+
+#pragma once
+
+#include <memory>
+
+#include "coherence_protocol.h"
+
+/// @brief Events of a coherence protocol, the columns of the transition table
+enum table_event_e {
+    EVENT_PRRD,
+    EVENT_PRWR,
+    EVENT_BUSRD,
+    EVENT_BUSRDX,
+    EVENT_BUSUPDT,
+    EVENT_BUSUPGR,
+    EVENT_BUSWR,
+    N_TABLE_EVENTS
+};
+
+/// @brief A transition of the table
+struct table_transition {
+    /// @brief The next state
+    state_e next;
+    /// @brief The next state if the 'COPIES-EXIST' line was asserted
+    state_e shared;
+    /// @brief The next state if the 'COPIES-EXIST' and 'OWNED' lines were asserted
+    state_e owned;
+    /// @brief The bus messages to issue (processor events only)
+    bus_msg_e bus_msgs[2];
+    /// @brief The number of bus messages to issue
+    uint8_t n_bus_msgs;
+    /// @brief Whether the line is flushed (bus events only)
+    bool flush;
+    /// @brief Whether the transition is defined
+    bool defined;
+};
+
+/// @brief A transition table loaded from a spec file
+struct protocol_table {
+    /// @brief The transitions, indexed by state and event
+    table_transition transitions[N_STATES][N_TABLE_EVENTS];
+    /// @brief Bitmask of the states of the protocol
+    uint32_t states;
+    /// @brief Bitmask of the states written back to main memory
+    uint32_t writeback_states;
+    /// @brief Whether the protocol does dirty sharing
+    bool dirty_sharing;
+    /// @brief Whether the protocol uses write no-allocate
+    bool write_no_allocate;
+    /// @brief Whether the protocol writes bus updates through to main memory
+    bool update_memory;
+};
+
+/// @brief A coherence protocol executing a transition table
+class TableProtocol : public CoherenceProtocol {
+public:
+
+    /// @brief Construct a new table-driven coherence protocol
+    /// @param cache The parent cache
+    /// @param table The transition table (shared by every cache using the spec file)
+    TableProtocol(CacheABC& cache, std::shared_ptr<const protocol_table> table) : CoherenceProtocol(cache), table(table) {}
+
+    /// @brief Register a table-driven coherence protocol in 'coherence_map', if the name refers to a spec file
+    /// @param name The name of the coherence protocol, TABLE_PROTOCOL_PREFIX followed by the path to the spec file
+    /// @return An error message, or an empty string if the protocol was registered (or the name is not a spec file)
+    static std::string registerSpec(const std::string& name);
+
+    /// @brief Receive a PrRd message
+    /// @param line The cache line accessed (non-null)
+    void PrRd(cache_line* line);
+    /// @brief Receive a PrWr message
+    /// @param line The cache line accessed (null if not allocated under write no-allocate)
+    void PrWr(cache_line* line);
+
+    /// @brief Receive a BusRd message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusRd(cache_line* line) { return busEvent(line, EVENT_BUSRD); }
+    /// @brief Receive a BusRdX message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusRdX(cache_line* line) { return busEvent(line, EVENT_BUSRDX); }
+    /// @brief Receive a BusUpdt message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusUpdt(cache_line* line) { return busEvent(line, EVENT_BUSUPDT); }
+    /// @brief Receive a BusUpgr message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusUpgr(cache_line* line) { return busEvent(line, EVENT_BUSUPGR); }
+    /// @brief Receive a BusWr message
+    /// @param line The cache line accessed
+    /// @return True if the line was flushed to the bus
+    bool BusWr(cache_line* line) { return busEvent(line, EVENT_BUSWR); }
+
+    /// @brief Determine whether the coherence protocol does dirty sharing
+    /// @return True if the coherence protocol does dirty sharing
+    bool doesDirtySharing() { return table->dirty_sharing; }
+    /// @brief Determine whether the coherence protocol uses write no-allocate
+    /// @return True if the coherence protocol uses write no-allocate
+    bool doesWriteNoAllocate() { return table->write_no_allocate; }
+    /// @brief Determine whether the coherence protocol writes bus updates through to main memory
+    /// @return True if the coherence protocol writes bus updates through to main memory
+    bool doesUpdateMemory() { return table->update_memory; }
+
+    /// @brief Determine whether a line needs to be written back to main memory
+    /// @param state The state of the line
+    /// @return Whether the line needs to be written back to main memory
+    bool isWriteBackNeeded(state_e state) { return table->writeback_states >> state & 1; }
+
+    /// @brief Determine whether a line can be in a state under this protocol
+    /// @param state The state of the line
+    /// @return Whether the protocol has the state
+    bool isStateSupported(state_e state) { return table->states >> state & 1; }
+
+private:
+
+    /// @brief The transition table
+    std::shared_ptr<const protocol_table> table;
+
+    /// @brief Take the transition of a processor event, issuing its bus messages
+    /// @param line The cache line accessed (null if not allocated under write no-allocate)
+    /// @param event The processor event
+    void processorEvent(cache_line* line, table_event_e event);
+
+    /// @brief Take the transition of a bus event
+    /// @param line The cache line accessed
+    /// @param event The bus event
+    /// @return True if the line was flushed to the bus
+    inline bool busEvent(cache_line* line, table_event_e event) {
+        const table_transition& transition = table->transitions[line->state][event];
+        line->state = transition.next;
+        return transition.flush;
+    }
+};
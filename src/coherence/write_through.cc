@@ -63,3 +63,7 @@ bool WriteThrough::doesWriteNoAllocate() {
 bool WriteThrough::isWriteBackNeeded(state_e state) {
     return false;
 }
+
+bool WriteThrough::isStateSupported(state_e state) {
+    return state == I || state == V;
+}
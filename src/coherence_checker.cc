@@ -0,0 +1,173 @@
+/// @file coherence_checker.cc
+/// @brief Implementation of the CoherenceChecker class
+
+#include <sstream>
+
+#include "coherence_checker.h"
+
+/// @brief Set a cache's bit in a bitmap
+#define SET_BIT(bitmap, cache_id) ((bitmap)[(cache_id) / 64] |= 1ull << (cache_id) % 64)
+/// @brief Clear a cache's bit in a bitmap
+#define CLEAR_BIT(bitmap, cache_id) ((bitmap)[(cache_id) / 64] &= ~(1ull << (cache_id) % 64))
+/// @brief Check a cache's bit in a bitmap
+#define GET_BIT(bitmap, cache_id) ((bitmap)[(cache_id) / 64] >> (cache_id) % 64 & 1)
+
+template<typename A>
+CoherenceChecker<A>::CoherenceChecker(uint32_t n_caches, uint32_t config_id)
+    : words((n_caches + 63) / 64), config_id(config_id), last_line(0), last_index(~0u), flushed_uptodate(false) {
+    stride = sizeof(line_record) / sizeof(uint64_t) + N_BITMAPS * words;
+}
+
+template<typename A>
+uint32_t CoherenceChecker<A>::findRecord(A line_addr) {
+    bool inserted;
+    uint32_t& index = index_of.insert(line_addr, inserted);
+    if (inserted) {
+        // Lines start out in main memory only
+        index = records.size() / stride;
+        records.resize(records.size() + stride, 0);
+        getLine(index).memory_uptodate = true;
+    }
+    last_line = line_addr;
+    last_index = index;
+    return index;
+}
+
+template<typename A>
+void CoherenceChecker<A>::beginWrite(uint32_t record, uint32_t cache_id, size_t timestamp) {
+    getLine(record).last_write = timestamp;
+    getLine(record).last_writer = cache_id;
+    getLine(record).memory_uptodate = false;
+    std::fill_n(getBitmap(record, UPTODATE), words, 0);
+}
+
+template<typename A>
+void CoherenceChecker<A>::transition(uint32_t record, uint32_t cache_id, state_e before, state_e after) {
+    if (before == after) return;
+    uint64_t* valid = getBitmap(record, VALID);
+    uint64_t* uptodate = getBitmap(record, UPTODATE);
+    uint64_t* exclusive = getBitmap(record, EXCLUSIVE);
+    uint64_t* owned = getBitmap(record, OWNED);
+
+    if (after) SET_BIT(valid, cache_id);
+    else {
+        // An invalid copy holds no value
+        CLEAR_BIT(valid, cache_id);
+        CLEAR_BIT(uptodate, cache_id);
+    }
+    if (after == D || after == E || after == M) SET_BIT(exclusive, cache_id);
+    else CLEAR_BIT(exclusive, cache_id);
+
+    // A dirty copy is written back before main memory is read again, even if it was granted without a write
+    if (after == D || after == M) getLine(record).memory_uptodate = false;
+    if (after == O || after == Sm || after == F) SET_BIT(owned, cache_id);
+    else CLEAR_BIT(owned, cache_id);
+}
+
+template<typename A>
+void CoherenceChecker<A>::flush(uint32_t record, uint32_t cache_id) {
+    flushed_uptodate = GET_BIT(getBitmap(record, UPTODATE), cache_id);
+}
+
+template<typename A>
+void CoherenceChecker<A>::fill(uint32_t record, uint32_t cache_id, bool from_cache) {
+    uint64_t* uptodate = getBitmap(record, UPTODATE);
+
+    // The copy is up to date if its source was (the flushing cache may have given up its copy since)
+    bool source_uptodate = from_cache ? flushed_uptodate : getLine(record).memory_uptodate;
+    if (source_uptodate) SET_BIT(uptodate, cache_id);
+    else CLEAR_BIT(uptodate, cache_id);
+}
+
+template<typename A>
+void CoherenceChecker<A>::update(uint32_t record, uint32_t cache_id) {
+    SET_BIT(getBitmap(record, UPTODATE), cache_id);
+}
+
+template<typename A>
+void CoherenceChecker<A>::writeBack(uint32_t record, uint32_t cache_id) {
+    if (GET_BIT(getBitmap(record, UPTODATE), cache_id)) getLine(record).memory_uptodate = true;
+}
+
+template<typename A>
+void CoherenceChecker<A>::writeMemory(uint32_t record) {
+    getLine(record).memory_uptodate = true;
+}
+
+template<typename A>
+bool CoherenceChecker<A>::verify(uint32_t record, A line_addr, uint32_t cache_id, bool write, size_t timestamp) {
+    uint64_t* valid = getBitmap(record, VALID);
+    uint64_t* uptodate = getBitmap(record, UPTODATE);
+    uint64_t* exclusive = getBitmap(record, EXCLUSIVE);
+    uint64_t* owned = getBitmap(record, OWNED);
+
+    // Tally each invariant
+    uint32_t n_valid = 0, n_exclusive = 0, n_owned = 0;
+    uint64_t stale = 0;
+    for (uint32_t i = 0; i < words; i++) {
+        n_valid += __builtin_popcountll(valid[i]);
+        n_exclusive += __builtin_popcountll(exclusive[i]);
+        n_owned += __builtin_popcountll(owned[i]);
+        stale |= valid[i] & ~uptodate[i];
+    }
+    bool swmr_violation = (n_exclusive && n_valid > 1) || n_owned > 1;
+    if (!swmr_violation && !stale) return true;
+
+    // Report the violation in a single write, since batch mode runs several checkers at once
+    std::ostringstream report;
+    report << "Coherence violation in config " << config_id << " after core " << cache_id;
+    report << (write ? " wrote to" : " read from") << " line " << std::setbase(16) << line_addr;
+    report << " at step " << std::setbase(10) << timestamp + 1 << ':';
+    if (n_exclusive && n_valid > 1) {
+        report << " exclusive copy in ";
+        printCaches(report, exclusive);
+        report << " shared with ";
+        printCaches(report, valid);
+        report << ';';
+    }
+    if (n_owned > 1) {
+        report << " multiple owners ";
+        printCaches(report, owned);
+        report << ';';
+    }
+    if (stale) {
+        std::vector<uint64_t> stale_copies(words);
+        for (uint32_t i = 0; i < words; i++) stale_copies[i] = valid[i] & ~uptodate[i];
+        report << " out of date copies in ";
+        printCaches(report, stale_copies.data());
+        report << " (last written at step " << getLine(record).last_write + 1 << " by core " << getLine(record).last_writer << ')';
+    }
+    report << '\n';
+    std::cerr << report.str();
+    return false;
+}
+
+template<typename A>
+void CoherenceChecker<A>::printCaches(std::ostream& out, const uint64_t* bitmap) {
+    bool first = true;
+    for (uint32_t i = 0; i < words * 64; i++)
+        if (GET_BIT(bitmap, i)) {
+            out << (first ? "" : ", ") << i;
+            first = false;
+        }
+}
+
+template<typename A>
+void CoherenceChecker<A>::checkpoint(std::ostream& out) {
+    index_of.checkpoint(out);
+    writeValue<uint64_t>(out, records.size());
+    writeArray(out, records.data(), records.size());
+}
+
+template<typename A>
+void CoherenceChecker<A>::restore(std::istream& in) {
+    index_of.restore(in);
+    uint64_t n_words = 0;
+    readValue(in, n_words);
+    records.resize(in ? n_words : 0);
+    readArray(in, records.data(), records.size());
+    last_index = ~0u;
+}
+
+template class CoherenceChecker<uint32_t>;
+template class CoherenceChecker<uint64_t>;
@@ -0,0 +1,159 @@
+/// @file coherence_checker.h
+/// @brief Declaration of the CoherenceChecker class
+
+#pragma once
+
+#include <vector>
+
+#include "flat_map.h"
+
+/// @brief Verifies the coherence invariants of a memory system after every memory access
+///
+/// A record is kept for every line accessed by the memory system, holding the access number and core of
+/// the last write, whether main memory is up to date, and four bitmaps with one bit per cache: the caches
+/// holding a valid copy, the caches whose copy holds the last written value, the caches holding the line in
+/// an exclusive state (D, E or M) and the caches holding the line in an owned state (O or Sm). The caches
+/// report each event affecting a line, and after each access the invariants are checked on the accessed line:
+///   - Single writer, multiple readers: a line held in an exclusive state is held by no other cache, and
+///     at most one cache owns the line
+///   - Data value: every valid copy of the line holds the last written value
+///
+/// The events name a line by the index of its record, which the caches keep for each of their lines, so that only
+/// an access to a line not in the accessing cache looks the line up. Since only the accessed line is checked, each
+/// access costs at most one hash lookup and a constant number of bitmap operations
+/// @tparam A The address type
+template<typename A>
+class CoherenceChecker {
+public:
+
+    /// @brief Construct a new coherence checker
+    /// @param n_caches The number of caches in the memory system
+    /// @param config_id The ID of the configuration being checked (for the violation reports)
+    CoherenceChecker(uint32_t n_caches, uint32_t config_id);
+
+    /// @brief Get the index of a line's record, creating the record if needed
+    /// @param line_addr The line address (address without the line offset)
+    /// @return The index of the line's record (stable for the life of the checker)
+    inline uint32_t getRecord(A line_addr) {
+        // Consecutive lookups usually concern the same line
+        return line_addr == last_line && last_index != ~0u ? last_index : findRecord(line_addr);
+    }
+
+    /// @brief Record the start of a processor write, after which only the copies written or updated are up to date
+    /// @param record The index of the record of the line written
+    /// @param cache_id The ID of the writing cache
+    /// @param timestamp The access number of the write
+    void beginWrite(uint32_t record, uint32_t cache_id, size_t timestamp);
+
+    /// @brief Record a change of state of a cache's copy of a line
+    /// @param record The index of the line's record
+    /// @param cache_id The ID of the cache
+    /// @param before The state the line was in before
+    /// @param after The new state of the line
+    void transition(uint32_t record, uint32_t cache_id, state_e before, state_e after);
+
+    /// @brief Record that a cache flushed its copy of a line to the bus (before the copy changes state)
+    /// @param record The index of the line's record
+    /// @param cache_id The ID of the flushing cache
+    void flush(uint32_t record, uint32_t cache_id);
+
+    /// @brief Record that a cache received a line on a read miss
+    /// @param record The index of the record of the line read
+    /// @param cache_id The ID of the reading cache
+    /// @param from_cache Whether another cache supplied the line, as last flushed (otherwise main memory did)
+    void fill(uint32_t record, uint32_t cache_id, bool from_cache);
+
+    /// @brief Record that a cache's copy of a line now holds the last written value (written or bus updated)
+    /// @param record The index of the line's record
+    /// @param cache_id The ID of the cache
+    void update(uint32_t record, uint32_t cache_id);
+
+    /// @brief Record that a cache wrote its copy of a line back to main memory
+    /// @param record The index of the line's record
+    /// @param cache_id The ID of the cache
+    void writeBack(uint32_t record, uint32_t cache_id);
+
+    /// @brief Record that a processor write went straight to main memory
+    /// @param record The index of the record of the line written
+    void writeMemory(uint32_t record);
+
+    /// @brief Check the coherence invariants on a line after a memory access, reporting any violation to stderr
+    /// @param record The index of the record of the line accessed
+    /// @param line_addr The line address accessed (for the violation report)
+    /// @param cache_id The ID of the accessing cache
+    /// @param write Whether the access was a processor write
+    /// @param timestamp The access number
+    /// @return True if the invariants hold
+    bool verify(uint32_t record, A line_addr, uint32_t cache_id, bool write, size_t timestamp);
+
+    /// @brief Write the line records to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the line records from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
+private:
+
+    /// @brief The per-line record, followed in memory by its bitmaps
+    struct line_record {
+        /// @brief The access number of the last write
+        size_t last_write;
+        /// @brief The ID of the cache that performed the last write
+        uint32_t last_writer;
+        /// @brief Whether main memory holds the last written value
+        bool memory_uptodate;
+    };
+
+    /// @brief Offsets of each bitmap after a record
+    enum bitmap_e {
+        VALID,
+        UPTODATE,
+        EXCLUSIVE,
+        OWNED,
+        N_BITMAPS
+    };
+
+    /// @brief Map from line address to the index of its record
+    FlatMap<A, uint32_t> index_of;
+    /// @brief The records of every line, each followed by its bitmaps ('stride' words per line, so that
+    /// checking an access touches a single contiguous block of memory)
+    std::vector<uint64_t> records;
+    /// @brief The number of 64-bit words in each bitmap
+    uint32_t words;
+    /// @brief The number of 64-bit words in a record and its bitmaps
+    uint32_t stride;
+    /// @brief The ID of the configuration being checked
+    uint32_t config_id;
+
+    /// @brief The line address of the most recently looked up record
+    A last_line;
+    /// @brief The index of the most recently looked up record
+    uint32_t last_index;
+    /// @brief Whether the copy most recently flushed to the bus was up to date
+    bool flushed_uptodate;
+
+    /// @brief Look up the index of a line's record in the map, creating the record if needed
+    /// @param line_addr The line address
+    /// @return The index of the line's record
+    uint32_t findRecord(A line_addr);
+
+    /// @brief Get a record
+    /// @param index The index of the record
+    /// @return The record
+    inline line_record& getLine(uint32_t index) {
+        return *(line_record*)&records[(size_t)index * stride];
+    }
+    /// @brief Get a bitmap of a record
+    /// @param index The index of the record
+    /// @param bitmap The bitmap
+    /// @return The first word of the bitmap
+    inline uint64_t* getBitmap(uint32_t index, bitmap_e bitmap) {
+        return &records[(size_t)index * stride + sizeof(line_record) / sizeof(uint64_t) + bitmap * words];
+    }
+
+    /// @brief Print the IDs of the caches set in a bitmap, separated by commas
+    /// @param out The stream to print to
+    /// @param bitmap The bitmap
+    void printCaches(std::ostream& out, const uint64_t* bitmap);
+};
@@ -3,11 +3,17 @@
 
 #include "broadcast.h"
 #include "cache.h"
+#include "instrumentation.h"
 
 ADD_DIRECTORY_TO_CMD_LINE(Broadcast);
 
-void Broadcast::issueBusMsg(bus_msg_e bus_msg, addr_t addr, uint32_t cache_id) {
-    for (uint32_t i = 0; i < MAX_N_CACHES; i++)
-        if (i != cache_id && caches[i])
+template<typename A>
+void Broadcast<A>::issueBusMsg(bus_msg_e bus_msg, A addr, uint32_t cache_id) {
+    INSTRUMENT_PHASE(PHASE_SNOOP_FANOUT);
+    // No other cache ever holds a copy of a private line
+    if (!this->isLineShared(addr)) return;
+    Cache<A>** caches = this->caches;
+    for (uint32_t i = 0, n_caches = this->n_caches; i < n_caches; i++)
+        if (i != cache_id && caches[i] && caches[i]->passesSnoopFilter(addr))
             caches[i]->receiveBusMsg(bus_msg, addr);
 }
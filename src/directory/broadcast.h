@@ -6,16 +6,19 @@
 #include "memory_system.h"
 
 /// @brief The Broadcast directory protocol
-class Broadcast : public MemorySystem {
+/// @tparam A The address type
+template<typename A>
+class Broadcast : public MemorySystem<A> {
 public:
 
     /// @brief Construct a new Broadcast directory protocol
     /// @param config The configuration of the memory system
-    Broadcast(cache_config& config) : MemorySystem(config) {}
+    /// @param n_caches The number of caches in the memory system
+    Broadcast(cache_config& config, uint32_t n_caches) : MemorySystem<A>(config, n_caches) {}
 
     /// @brief Issue a bus message from a cache to all other caches
     /// @param bus_msg The specific bus message
     /// @param addr The address accessed
     /// @param cache_id The cache ID of the requestor
-    void issueBusMsg(bus_msg_e bus_msg, addr_t addr, uint32_t cache_id);
+    void issueBusMsg(bus_msg_e bus_msg, A addr, uint32_t cache_id);
 };
@@ -0,0 +1,68 @@
+/// @file fast_divisor.h
+/// @brief Declaration and implementation of the FastDivisor class
+
+#pragma once
+
+#include <cstdint>
+
+/// @brief A divisor fixed at runtime, which divides by a multiplication with a precomputed inverse instead of the
+/// hardware divide (a shift for powers of 2)
+/// @note The inverse is the round-up method of Granlund and Montgomery, exact for every 64-bit dividend
+class FastDivisor {
+public:
+
+    /// @brief Construct a new divisor
+    /// @param divisor The divisor (positive)
+    FastDivisor(uint64_t divisor) : divisor(divisor) {
+        pow2 = !(divisor & (divisor - 1));
+        if (pow2) {
+            shift = __builtin_ctzll(divisor);
+            magic = 0;
+        } else {
+            // 2^(shift - 1) < divisor < 2^shift
+            shift = 64 - __builtin_clzll(divisor - 1);
+            magic = (uint64_t)(((((unsigned __int128)1 << shift) - divisor) << 64) / divisor) + 1;
+        }
+    }
+
+    /// @brief Get the divisor
+    /// @return The divisor
+    inline uint64_t get() const { return divisor; }
+    /// @brief Determine whether the divisor is a power of 2
+    /// @return True if dividing is a shift
+    inline bool isPow2() const { return pow2; }
+
+    /// @brief Divide a number by the divisor
+    /// @param n The dividend
+    /// @return The quotient
+    inline uint64_t divide(uint64_t n) const {
+        if (pow2) return n >> shift;
+        uint64_t high = (uint64_t)(((unsigned __int128)magic * n) >> 64);
+        return (high + ((n - high) >> 1)) >> (shift - 1);
+    }
+
+    /// @brief Divide a number by the divisor, with the remainder
+    /// @param n The dividend
+    /// @param remainder The remainder
+    /// @return The quotient
+    inline uint64_t divide(uint64_t n, uint64_t& remainder) const {
+        if (pow2) {
+            remainder = n & (divisor - 1);
+            return n >> shift;
+        }
+        uint64_t quotient = divide(n);
+        remainder = n - quotient * divisor;
+        return quotient;
+    }
+
+private:
+
+    /// @brief The divisor
+    uint64_t divisor;
+    /// @brief The inverse multiplier (unused for powers of 2)
+    uint64_t magic;
+    /// @brief The logarithm of the divisor, rounded up
+    uint32_t shift;
+    /// @brief Whether the divisor is a power of 2
+    bool pow2;
+};
@@ -0,0 +1,195 @@
+/// @file flat_map.h
+/// @brief Declaration and implementation of the FlatMap class template
+
+#pragma once
+
+#include <algorithm>
+
+#include "checkpoint.h"
+
+/// @brief An open addressing hash map from integer keys to values, using linear probing
+/// @tparam K The (unsigned integer) key type
+/// @tparam V The value type (trivially copyable)
+/// @note The all-ones key is used to mark empty slots, so it is stored outside of the table
+template<typename K, typename V>
+class FlatMap {
+public:
+
+    /// @brief Construct a new empty map
+    /// @param expected_size The number of keys the map should hold without growing
+    FlatMap(size_t expected_size = 8) : num_keys(0), has_max_key(false), max_key_value() {
+        capacity = 16;
+        while (capacity < expected_size * 2) capacity <<= 1;
+        allocate();
+    }
+    ~FlatMap() {
+        delete[] slots;
+    }
+
+    FlatMap(const FlatMap&) = delete;
+    FlatMap& operator=(const FlatMap&) = delete;
+
+    /// @brief Locate the value of a key
+    /// @param key The key to look up
+    /// @return A pointer to the value if the key is present, else nullptr
+    V* find(K key) {
+        if (key == EMPTY) return has_max_key ? &max_key_value : nullptr;
+        for (size_t i = slot(key); ; i = (i + 1) & (capacity - 1)) {
+            if (slots[i].key == key) return &slots[i].value;
+            if (slots[i].key == EMPTY) return nullptr;
+        }
+    }
+
+    /// @brief Locate the value of a key, inserting a value-initialized entry if not present
+    /// @param key The key to look up
+    /// @param inserted Set to true if the key was not present before
+    /// @return A reference to the value of the key
+    V& insert(K key, bool& inserted) {
+        inserted = false;
+        if (key == EMPTY) {
+            if (!has_max_key) {
+                has_max_key = inserted = true;
+                max_key_value = V();
+                num_keys++;
+            }
+            return max_key_value;
+        }
+
+        // Keep the load factor at or below one half
+        if ((num_keys + 1) * 2 > capacity) grow();
+        size_t i = slot(key);
+        for (; slots[i].key != EMPTY; i = (i + 1) & (capacity - 1))
+            if (slots[i].key == key) return slots[i].value;
+        slots[i].key = key;
+        slots[i].value = V();
+        num_keys++;
+        inserted = true;
+        return slots[i].value;
+    }
+
+    /// @brief Remove a key from the map
+    /// @param key The key to remove
+    /// @return True if the key was present
+    bool erase(K key) {
+        if (key == EMPTY) {
+            if (!has_max_key) return false;
+            has_max_key = false;
+            num_keys--;
+            return true;
+        }
+
+        size_t i = slot(key);
+        for (; slots[i].key != key; i = (i + 1) & (capacity - 1))
+            if (slots[i].key == EMPTY) return false;
+
+        // Backward shift deletion: pull later entries of the probe chain into the hole
+        for (size_t j = i; ; ) {
+            j = (j + 1) & (capacity - 1);
+            if (slots[j].key == EMPTY) break;
+            size_t home = slot(slots[j].key);
+            // Move the entry only if its home slot does not lie cyclically within (i, j]
+            if (((j - home) & (capacity - 1)) >= ((j - i) & (capacity - 1))) {
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        slots[i].key = EMPTY;
+        num_keys--;
+        return true;
+    }
+
+    /// @brief Remove every key from the map (keeps the current capacity)
+    void clear() {
+        for (size_t i = 0; i < capacity; i++) slots[i].key = EMPTY;
+        has_max_key = false;
+        num_keys = 0;
+    }
+
+    /// @brief Get the number of keys in the map
+    /// @return The number of keys in the map
+    size_t size() const { return num_keys; }
+
+    /// @brief Call a function on every key-value pair in the map (in no particular order)
+    /// @param func The function to call, with signature void(K, V&)
+    template<typename F>
+    void forEach(F func) {
+        for (size_t i = 0; i < capacity; i++)
+            if (slots[i].key != EMPTY) func(slots[i].key, slots[i].value);
+        if (has_max_key) func(EMPTY, max_key_value);
+    }
+
+    /// @brief Write the map to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out) {
+        writeValue(out, capacity);
+        writeValue(out, num_keys);
+        writeValue(out, has_max_key);
+        writeValue(out, max_key_value);
+        writeArray(out, slots, capacity);
+    }
+
+    /// @brief Replace the contents of the map with the contents of a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in) {
+        delete[] slots;
+        readValue(in, capacity);
+        readValue(in, num_keys);
+        readValue(in, has_max_key);
+        readValue(in, max_key_value);
+        // Guard against a corrupt capacity, which must be a power of 2
+        if (!in || !capacity || capacity & (capacity - 1) || capacity > ((size_t)1 << 40)) capacity = 16;
+        allocate();
+        readArray(in, slots, capacity);
+    }
+
+private:
+
+    /// @brief Key value marking an empty slot
+    static constexpr K EMPTY = (K)~(K)0;
+
+    /// @brief A key and its value (kept together, so that a lookup usually touches a single cache line)
+    struct slot_t {
+        K key;
+        V value;
+    };
+
+    /// @brief The slots of the table
+    slot_t* slots;
+    /// @brief The number of slots (power of 2)
+    size_t capacity;
+    /// @brief The number of keys in the map
+    size_t num_keys;
+
+    /// @brief Whether the all-ones key is present
+    bool has_max_key;
+    /// @brief The value of the all-ones key
+    V max_key_value;
+
+    /// @brief Get the home slot of a key (Fibonacci hashing)
+    /// @param key The key
+    /// @return The index of the first slot to probe
+    size_t slot(K key) const {
+        return (size_t)(((uint64_t)key * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+    }
+
+    /// @brief Allocate an array of empty slots for the current capacity
+    void allocate() {
+        slots = new slot_t[capacity]();
+        for (size_t i = 0; i < capacity; i++) slots[i].key = EMPTY;
+    }
+
+    /// @brief Double the capacity of the map, rehashing every entry
+    void grow() {
+        slot_t* old_slots = slots;
+        size_t old_capacity = capacity;
+        capacity <<= 1;
+        allocate();
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old_slots[i].key == EMPTY) continue;
+            size_t j = slot(old_slots[i].key);
+            while (slots[j].key != EMPTY) j = (j + 1) & (capacity - 1);
+            slots[j] = old_slots[i];
+        }
+        delete[] old_slots;
+    }
+};
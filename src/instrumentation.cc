@@ -0,0 +1,187 @@
+/// @file instrumentation.cc
+/// @brief Implementation of the hot path instrumentation (per-phase timers and hardware counters)
+
+#include "instrumentation.h"
+
+#ifdef INSTRUMENT
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// @brief Hardware counters sampled per profiled thread
+enum counter_e {
+    /// @brief CPU cycles
+    COUNTER_CYCLES,
+    /// @brief Last level cache misses
+    COUNTER_LLC_MISSES,
+    /// @brief Mispredicted branches
+    COUNTER_BRANCH_MISSES,
+
+    /// @brief The number of hardware counters; not a counter
+    N_COUNTERS
+};
+
+/// @brief Summary table names of the phases in 'phase_e'
+constexpr const char* phase_names[N_PHASES] = {
+    "trace read", "barrier wait", "config processing", "snoop fan-out", "findLine"
+};
+
+/// @brief The profile of a thread that has finished
+struct thread_profile {
+    /// @brief The name of the thread
+    std::string name;
+    /// @brief The total ticks spent in each phase
+    uint64_t ticks[N_PHASES];
+    /// @brief The number of times each phase was entered
+    uint64_t calls[N_PHASES];
+    /// @brief The value of each hardware counter (negative if unavailable)
+    int64_t counters[N_COUNTERS];
+};
+
+thread_local uint64_t phase_ticks[N_PHASES] = { 0 };
+thread_local uint64_t phase_calls[N_PHASES] = { 0 };
+
+/// @brief Guards 'profiles'
+static std::mutex profiles_mutex;
+/// @brief The profiles of the finished threads
+static std::vector<thread_profile> profiles;
+
+/// @brief Tick count at program start, to convert ticks to time
+static const uint64_t start_ticks = readTicks();
+/// @brief Time at program start, to convert ticks to time
+static const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+/// @brief Open a hardware counter for the current thread
+/// @param config The generic hardware event (PERF_COUNT_HW_*)
+/// @return The counter's file descriptor, or -1 if unavailable
+static int openCounter(uint64_t config) {
+#ifdef __linux__
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+/// @brief Records the profile of the current thread when it exits
+class ThreadProfiler {
+public:
+
+    ~ThreadProfiler() {
+        if (active) finish();
+    }
+
+    /// @brief Start profiling the current thread
+    /// @param thread_name The name of the thread
+    void begin(std::string thread_name) {
+        name = thread_name;
+        active = true;
+#ifdef __linux__
+        counter_fds[COUNTER_CYCLES] = openCounter(PERF_COUNT_HW_CPU_CYCLES);
+        counter_fds[COUNTER_LLC_MISSES] = openCounter(PERF_COUNT_HW_CACHE_MISSES);
+        counter_fds[COUNTER_BRANCH_MISSES] = openCounter(PERF_COUNT_HW_BRANCH_MISSES);
+#else
+        for (int& fd : counter_fds) fd = -1;
+#endif
+    }
+
+    /// @brief Stop profiling the current thread, recording its profile
+    void finish() {
+        thread_profile profile;
+        profile.name = name;
+        for (uint32_t i = 0; i < N_PHASES; i++) {
+            profile.ticks[i] = phase_ticks[i];
+            profile.calls[i] = phase_calls[i];
+        }
+        for (uint32_t i = 0; i < N_COUNTERS; i++) {
+            profile.counters[i] = -1;
+            if (counter_fds[i] < 0) continue;
+            uint64_t value;
+            if (read(counter_fds[i], &value, sizeof(value)) == sizeof(value)) profile.counters[i] = value;
+            close(counter_fds[i]);
+        }
+        active = false;
+
+        std::lock_guard guard(profiles_mutex);
+        profiles.push_back(profile);
+    }
+
+    /// @brief Whether the current thread is being profiled
+    bool active = false;
+
+private:
+
+    /// @brief The name of the thread
+    std::string name;
+    /// @brief The file descriptor of each hardware counter (-1 if unavailable)
+    int counter_fds[N_COUNTERS];
+};
+
+/// @brief The profiler of the current thread
+static thread_local ThreadProfiler profiler;
+
+void beginThreadProfile(std::string name) {
+    profiler.begin(name);
+}
+
+void printInstrumentation() {
+    if (profiler.active) profiler.finish();
+
+    // Convert ticks to milliseconds using the elapsed time since program start
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    double ms_per_tick = elapsed_ms / (readTicks() - start_ticks);
+
+    std::lock_guard guard(profiles_mutex);
+    std::cerr << std::fixed << std::setprecision(1);
+    std::cerr << "Instrumentation summary (wall time " << elapsed_ms << " ms)" << std::endl;
+
+    // Phase totals across all threads. Snoop fan-out and findLine are nested within config processing
+    std::cerr << std::left << std::setw(18) << "Phase" << std::right << " | " << std::setw(14) << "Calls" << " | ";
+    std::cerr << std::setw(14) << "Total ms" << " | " << std::setw(10) << "Mean ns" << std::endl;
+    std::cerr << std::string(18, '-') << "-|-" << std::string(14, '-') << "-|-" << std::string(14, '-') << "-|-" << std::string(10, '-') << std::endl;
+    for (uint32_t phase = 0; phase < N_PHASES; phase++) {
+        uint64_t ticks = 0, calls = 0;
+        for (thread_profile& profile : profiles) {
+            ticks += profile.ticks[phase];
+            calls += profile.calls[phase];
+        }
+        std::cerr << std::left << std::setw(18) << phase_names[phase] << std::right << " | " << std::setw(14) << calls << " | ";
+        std::cerr << std::setw(14) << ticks * ms_per_tick << " | " << std::setw(10) << (calls ? ticks * ms_per_tick * 1e6 / calls : 0) << std::endl;
+    }
+    std::cerr << std::endl;
+
+    // Per-thread breakdown with hardware counters
+    std::cerr << std::left << std::setw(18) << "Thread" << std::right;
+    for (const char* column : { "Read ms", "Wait ms", "Process ms", "Cycles", "LLC misses", "Branch misses" })
+        std::cerr << " | " << std::setw(14) << column;
+    std::cerr << std::endl << std::string(18, '-');
+    for (uint32_t i = 0; i < 6; i++) std::cerr << "-|-" << std::string(14, '-');
+    std::cerr << std::endl;
+    for (thread_profile& profile : profiles) {
+        std::cerr << std::left << std::setw(18) << profile.name << std::right;
+        for (phase_e phase : { PHASE_TRACE_READ, PHASE_BARRIER_WAIT, PHASE_CONFIG_PROCESSING })
+            std::cerr << " | " << std::setw(14) << profile.ticks[phase] * ms_per_tick;
+        for (uint32_t i = 0; i < N_COUNTERS; i++) {
+            std::cerr << " | " << std::setw(14);
+            if (profile.counters[i] < 0) std::cerr << "n/a";
+            else std::cerr << profile.counters[i];
+        }
+        std::cerr << std::endl;
+    }
+    std::cerr << std::defaultfloat;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/// @file instrumentation.h
+/// @brief Declaration of the hot path instrumentation (per-phase timers and hardware counters)
+///
+/// The instrumentation is only compiled in when the INSTRUMENT predefine is present. Otherwise every
+/// macro below expands to nothing, so the instrumentation has no runtime cost
+
+#pragma once
+
+#include "typedefs.h"
+
+#ifdef INSTRUMENT
+
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <ctime>
+#endif
+
+/// @brief The instrumented phases of a simulation run
+enum phase_e {
+    /// @brief Reading a chunk of the trace file
+    PHASE_TRACE_READ,
+    /// @brief Waiting at the batch mode barrier for the next chunk
+    PHASE_BARRIER_WAIT,
+    /// @brief Processing a chunk of traces for one configuration
+    PHASE_CONFIG_PROCESSING,
+    /// @brief Delivering a bus message to the other caches
+    PHASE_SNOOP_FANOUT,
+    /// @brief Looking up a line in a cache
+    PHASE_FIND_LINE,
+
+    /// @brief The number of instrumented phases; not a phase
+    N_PHASES
+};
+
+/// @brief The total ticks spent in each phase by the current thread
+extern thread_local uint64_t phase_ticks[N_PHASES];
+/// @brief The number of times the current thread entered each phase
+extern thread_local uint64_t phase_calls[N_PHASES];
+
+/// @brief Read the time stamp counter (or the monotonic clock in nanoseconds where there is none)
+/// @return The current tick count
+inline uint64_t readTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif
+}
+
+/// @brief Scoped timer adding the time until the end of its scope to a phase
+class PhaseTimer {
+public:
+
+    /// @brief Start timing a phase
+    /// @param phase The phase being timed
+    PhaseTimer(phase_e phase) : phase(phase), start(readTicks()) {}
+    /// @brief Stop timing the phase
+    ~PhaseTimer() {
+        phase_ticks[phase] += readTicks() - start;
+        phase_calls[phase]++;
+    }
+
+private:
+
+    /// @brief The phase being timed
+    phase_e phase;
+    /// @brief The tick count at the start of the phase
+    uint64_t start;
+};
+
+/// @brief Name the current thread in the summary and start its hardware counters (if available)
+/// @param name The name of the thread
+void beginThreadProfile(std::string name);
+
+/// @brief Print the summary of every profiled thread to stderr
+/// @note Call after every other profiled thread has exited
+void printInstrumentation();
+
+/// @brief Time the rest of the current scope as part of a phase
+#define INSTRUMENT_PHASE(phase) PhaseTimer phase_timer(phase)
+/// @brief Name the current thread and start its hardware counters
+#define INSTRUMENT_THREAD(name) beginThreadProfile(name)
+/// @brief Print the instrumentation summary to stderr
+#define INSTRUMENT_REPORT() printInstrumentation()
+
+#else
+
+/// @brief Time the rest of the current scope as part of a phase (disabled)
+#define INSTRUMENT_PHASE(phase)
+/// @brief Name the current thread and start its hardware counters (disabled)
+#define INSTRUMENT_THREAD(name)
+/// @brief Print the instrumentation summary to stderr (disabled)
+#define INSTRUMENT_REPORT()
+
+#endif
@@ -24,6 +24,12 @@ public:
     /// @param bus_msg The specific bus message
     /// @return True if the 'COPIES-EXIST' line was asserted
     virtual bool issueBusMsg(bus_msg_e bus_msg) { return false; }
+    /// @brief Check if the 'OWNED' line was asserted by the last bus message
+    /// @return True if another cache owns the line
+    virtual bool isOwnedElsewhere() { return false; }
+    /// @brief Count an event that only the coherence protocol can detect
+    /// @param stat The statistic to increment
+    virtual void addStatistic(statistic_e stat) {}
 
     /// @brief Get the state of a line in the cache
     /// @param set_idx The index of the set containing the line
@@ -31,6 +37,19 @@ public:
     /// @return The state of the cache line
     state_e getLineState(uint32_t set_idx, uint32_t way_idx) { return lines[way_idx].state; }
 
+    /// @brief Get the number of lines in the cache
+    /// @return The number of lines
+    uint32_t getNumLines() { return N_INTERACTIVE_MODE_LINES; }
+    /// @brief Get the index of a line in the cache
+    /// @param line The cache line (one of the cache's lines)
+    /// @return The index of the line
+    uint32_t getLineIndex(const cache_line* line) { return static_cast<const tagged_line<uint32_t>*>(line) - lines; }
+    /// @brief Get the tag of a line in the cache
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    /// @return The tag of the line
+    uint64_t getLineTag(uint32_t set_idx, uint32_t way_idx) { return lines[way_idx].tag; }
+
     /// @brief Write the command format message to stderr
     virtual void printCmdFormatMessage() = 0;
 
@@ -40,7 +59,7 @@ protected:
     std::string p_name;
 
     /// @brief The cache lines in interactive mode
-    cache_line lines[N_INTERACTIVE_MODE_LINES];
+    tagged_line<uint32_t> lines[N_INTERACTIVE_MODE_LINES];
 
 private:
 
@@ -7,14 +7,17 @@
 /// @brief Dummy tag value indicating that a line is allocated
 #define ALLOCATED 0x55555555
 
-/// @brief String names of the states in state_e
-constexpr const char* state_names[] = {
-    " I ", " D ", " E ", " M ", " V ", " O ", " S ", " Sc", " Sm"
+/// @brief Table cell labels of the states in state_e
+constexpr const char* state_labels[N_STATES] = {
+    " I ", " D ", " E ", " M ", " V ", " O ", " S ", " Sc", " Sm", " F "
 };
 /// @brief String names of bus messages and statistics in bus_msg_e and statistic_e
 constexpr const char* bus_event_names[] = {
     "PrRd", "PrWr", "BusRd", "BusRdX", "BusUpdt", "BusUpgr", "BusWr", "Read Miss",
-    "Write Miss", "Line Flush", "Line Fetch", "Cache to Cache", "Write Back", "Write Memory"
+    "Write Miss", "Line Flush", "Line Fetch", "Cache to Cache", "Write Back", "Write Memory", "Eviction",
+    "Exclusion", "Intervention", "Invalidation", "Compulsory", "Capacity", "Conflict", "Coherence",
+    "Redundant Resp", "Migratory", "Migratory Hit", "Filter Probe", "Snoop Avoided", "False Positive",
+    "Recency Ghost", "Freq Ghost", "Counter Aging", "Recency Sets", "Freq Sets"
 };
 
 /// @brief Table column widths
@@ -93,6 +96,7 @@ bool InteractiveModeCoherence::issueBusMsg(bus_msg_e bus_msg) {
 
     bool copies = false;
     bool flushed = false;
+    owned = false;
     switch (bus_msg) {
     case BusRead:
     case BusReadX:
@@ -107,6 +111,7 @@ bool InteractiveModeCoherence::issueBusMsg(bus_msg_e bus_msg) {
                     flushed = true;
                 }
                 copies = true;
+                owned |= lines[i].state == O || lines[i].state == Sm;
             }
         break;
     default: // Only respond to actual bus messages (enum has other values)
@@ -117,6 +122,7 @@ bool InteractiveModeCoherence::issueBusMsg(bus_msg_e bus_msg) {
         if (flushed) bus_events.emplace_back(CacheToCache, command.issuer);
         else bus_events.emplace_back(LineFetch, N_INTERACTIVE_MODE_LINES);
     }
+    if (bus_msg == BusUpdate && coherence_protocol->doesUpdateMemory()) bus_events.emplace_back(WriteMemory, command.issuer);
     return copies;
 }
 bool InteractiveModeCoherence::receiveBusMsg(bus_msg_e bus_msg, uint32_t cache_id) {
@@ -294,6 +300,6 @@ void InteractiveModeCoherence::printStats() {
     // Print resulting cache line states
     std::cout << " |";
     for (uint32_t i = 0; i < N_INTERACTIVE_MODE_LINES; i++)
-        std::cout << (lines[i].tag ? state_names[lines[i].state] : " - ");
+        std::cout << (lines[i].tag ? state_labels[lines[i].state] : " - ");
     std::cout << std::endl;
 }
@@ -43,6 +43,12 @@ public:
     /// @param bus_msg The specific bus message
     /// @return True if the 'COPIES-EXIST' line was asserted
     bool issueBusMsg(bus_msg_e bus_msg);
+    /// @brief Check if the 'OWNED' line was asserted by the last bus message
+    /// @return True if another cache owns the line
+    bool isOwnedElsewhere() { return owned; }
+    /// @brief Show an event that only the coherence protocol can detect
+    /// @param stat The statistic of the event
+    void addStatistic(statistic_e stat) { bus_events.emplace_back(stat, command.issuer); }
 
     /// @brief Write the command format message to stderr
     void printCmdFormatMessage();
@@ -59,6 +65,9 @@ private:
     /// @brief The most recent command issued
     bus_event command;
 
+    /// @brief Flag to indicate if another cache kept owning the line during the last bus message
+    bool owned = false;
+
     /// @brief Issue an Evict message to a cache
     /// @param cache_id The cache ID of the recipient
     void receiveEvict(uint32_t cache_id);
@@ -52,7 +52,7 @@ bool InteractiveModeReplacer::evalutateCommand(std::string& cmd) {
     }
 
     // Access command
-    tag_t tag = std::toupper(cmd[0]);
+    uint32_t tag = std::toupper(cmd[0]);
     if ('A' <= tag && tag <= 'Z') {
         receiveAccess(tag);
         printStats();
@@ -66,7 +66,7 @@ void InteractiveModeReplacer::printCmdFormatMessage() {
     std::cerr << "Command must be a letter between 'A' and 'Z' or '-'" << std::endl;
 }
 
-void InteractiveModeReplacer::receiveAccess(tag_t tag) {
+void InteractiveModeReplacer::receiveAccess(uint32_t tag) {
     accessee = tag;
     victim = ' ';
 
@@ -27,7 +27,7 @@ private:
 
     /// @brief Issue an access to a cache block
     /// @param tag The tag of the block
-    void receiveAccess(tag_t tag);
+    void receiveAccess(uint32_t tag);
 
     /// @brief Revert the system back to the initial state
     void reset();
@@ -1,42 +1,20 @@
 /// @file main.cc
 /// @brief This file processes the command line arguments, provides helper methods for processing the command line arguments, and decides what to run
 
-#include <filesystem>
 #include <fstream>
+#include <sstream>
 
-#include "typedefs.h"
+#include "main.h"
+#include "duel.h"
 #include "run_modes.h"
+#include "table_protocol.h"
 
 /// @brief The value of 'argc' if no arguments were passed on the command line
 #define NO_ARGS 1
 
-/// @brief The number of columns that appear in the output statistics
-#define NUM_COLUMNS (N_STATISTICS + 3)
-
 /// @brief The size of the config line buffer
 #define CONFIG_LINE_SIZE (ARG_C_COUNT * 10)
 
-std::map<std::string, coh_factory_t, ci_less>* coherence_map = nullptr;
-std::map<std::string, dir_factory_t, ci_less>* directory_map = nullptr;
-std::map<std::string, rep_factory_t, ci_less>* replacement_map = nullptr;
-
-/// @brief CSV-friendly names for cache runtime statistics. Make sure these match up with 'bus_msg_e' and 'statistic_e'
-constexpr const char* stat_names[NUM_COLUMNS] = {
-    "config", "core", "miss rate",
-    "processor reads", "processor writes",
-    "bus reads", "bus readxs", "bus updates", "bus upgrades", "bus writes",
-    "read misses", "write misses",
-    "line flushes", "line fetches", "c2c transfers", "write backs", "memory writes",
-    "evictions",
-    "exclusions", "interventions", "invalidations"
-};
-
-/// @brief Provide error message and exit code on condition
-/// @param condition Whether the program should print an error message and exit
-/// @param msg The error message to print
-/// @param config_id The ID of the config that caused the error
-/// @param arg_index The argument of the config that caused the error
-/// @see @ref docs/pages/exit_codes.md
 void exitIf(bool condition, std::string msg, uint32_t config_id, uint32_t arg_index) {
     if (condition) {
         std::cerr << arg_index << '@' << config_id << ": " << msg << std::endl;
@@ -44,13 +22,69 @@ void exitIf(bool condition, std::string msg, uint32_t config_id, uint32_t arg_in
     }
 }
 
+void getOptions(int& argc, char**& argv) {
+    // Options come before any other argument
+    int n_options = 0;
+    while (n_options + 1 < argc && argv[n_options + 1][0] == '-' && argv[n_options + 1][1] == '-') {
+        std::string option = argv[++n_options];
+        if (option == "--classify-misses") options.classify_misses = true;
+        else if (option == "--snoop-filter") options.snoop_filter = true;
+        else if (option == "--private-lines") options.private_lines = true;
+        else if (option == "--hashed-index") options.hashed_index = true;
+        else if (option == "--no-check") options.check_coherence = false;
+        else if (option == "--checkpoint" && n_options + 1 < argc) options.checkpoint_file = argv[++n_options];
+        else if (option == "--checkpoint-interval" && n_options + 1 < argc) {
+            char* suffix;
+            options.checkpoint_interval = strtoul(argv[++n_options], &suffix, 10);
+            if (*suffix || !options.checkpoint_interval) {
+                std::cerr << "Invalid checkpoint interval (expect positive number of chunks): " << argv[n_options] << std::endl;
+                exit(-1);
+            }
+        }
+        else if (option == "--resume" && n_options + 1 < argc) options.resume_file = argv[++n_options];
+        else if (option == "--fork" && n_options + 2 < argc) {
+            char* suffix;
+            options.fork_at = strtoull(argv[++n_options], &suffix, 10);
+            if (*suffix || !options.fork_at) {
+                std::cerr << "Invalid fork point (expect positive number of trace entries): " << argv[n_options] << std::endl;
+                exit(-1);
+            }
+            options.variants_file = argv[++n_options];
+        }
+        else if (option == "--format" && n_options + 1 < argc) {
+            std::string format = argv[++n_options];
+            if (format == "csv") options.output_format = FORMAT_CSV;
+            else if (format == "bin") options.output_format = FORMAT_BIN;
+            else if (format == "col") options.output_format = FORMAT_COL;
+            else {
+                std::cerr << "Unknown output format: " << format << std::endl;
+                exit(-1);
+            }
+        }
+        else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            exit(-1);
+        }
+    }
+
+    // Bus messages for private lines never reach the snoop filters, so their statistics would differ
+    if (options.private_lines && options.snoop_filter) {
+        std::cerr << "--private-lines cannot be combined with --snoop-filter" << std::endl;
+        exit(-1);
+    }
+
+    // Remove the options from the argument list, keeping the program name as the first argument
+    argv[n_options] = argv[0];
+    argv += n_options;
+    argc -= n_options;
+}
+
 void getConfig(int argc, char* argv[], cache_config& config) {
     char* suffix;   // Points to the next character after each parse
 
     // Cache size
     config.cache_size = strtoul(argv[ARG_CACHE_SIZE], &suffix, 10);
-    exitIf(suffix == argv[ARG_CACHE_SIZE], "Invalid format for cache size (expect positive number of bytes)", config.id, ARG_CACHE_SIZE);
-    exitIf(config.cache_size == 0 || config.cache_size & (config.cache_size - 1), "Cache size must be a power of 2", config.id, ARG_CACHE_SIZE);
+    exitIf(suffix == argv[ARG_CACHE_SIZE] || config.cache_size == 0, "Invalid format for cache size (expect positive number of bytes)", config.id, ARG_CACHE_SIZE);
     switch (suffix[0]) {
     case '\0':
         break;
@@ -72,14 +106,20 @@ void getConfig(int argc, char* argv[], cache_config& config) {
     // Associativity
     config.assoc = strtoul(argv[ARG_ASSOCIATIVITY], &suffix, 10);
     exitIf(suffix == argv[ARG_ASSOCIATIVITY] || *suffix, "Invalid format for associativity (expect positive integer)", config.id, ARG_ASSOCIATIVITY);
-    exitIf(config.assoc == 0 || config.assoc & (config.assoc - 1), "Associativity must be a power of 2", config.id, ARG_ASSOCIATIVITY);
+    exitIf(config.assoc == 0, "Invalid format for associativity (expect positive integer)", config.id, ARG_ASSOCIATIVITY);
     exitIf(config.assoc * config.line_size > config.cache_size, "Associativity cannot exceed the number of lines", config.id, ARG_ASSOCIATIVITY);
+    // The number of sets can be any integer
+    exitIf(config.cache_size % (config.assoc * config.line_size), "Cache size must be a multiple of the line size times the associativity", config.id, ARG_ASSOCIATIVITY);
 
-    // Coherence protocol
+    // Coherence protocol (a spec file is loaded the first time it is named)
+    std::string spec_error = TableProtocol::registerSpec(argv[ARG_COHERENCE]);
+    exitIf(!spec_error.empty(), spec_error, config.id, ARG_COHERENCE);
     exitIf(!coherence_map->count(argv[ARG_COHERENCE]), "Coherence protocol not found", config.id, ARG_COHERENCE);
     config.coherence = argv[ARG_COHERENCE];
 
-    // Replacement policy
+    // Replacement policy (a duel is registered the first time it is named)
+    std::string duel_error = Duel::registerDuel(argv[ARG_REPLACEMENT]);
+    exitIf(!duel_error.empty(), duel_error, config.id, ARG_REPLACEMENT);
     exitIf(!replacement_map->count(argv[ARG_REPLACEMENT]), "Replacement policy not found", config.id, ARG_REPLACEMENT);
     config.replacer = argv[ARG_REPLACEMENT];
 
@@ -88,12 +128,15 @@ void getConfig(int argc, char* argv[], cache_config& config) {
     config.directory = argv[ARG_DIRECTORY];
 }
 
-size_t getTrace(int argc, char* argv[], std::ifstream& trace_file, int arg_max_count) {
-    // Open trace file (2nd to last argument)
-    trace_file.open(argv[arg_max_count - 2], std::ios_base::in | std::ios_base::binary);
-    std::string tf_error = "Trace file read error: ";
-    exitIf(!trace_file, tf_error + std::strerror(errno), 0, arg_max_count - 2);
-    exitIf(std::filesystem::file_size(argv[arg_max_count - 2]) % sizeof(trace_t), "Malformed trace file", 0, arg_max_count - 2);
+bool needsNextUse(const cache_config& config) {
+    // Direct-mapped caches never use their replacer
+    return config.assoc > 1 && !strcasecmp(config.replacer.c_str(), "OPT");
+}
+
+size_t getTrace(int argc, char* argv[], TraceReader& trace_reader, int arg_max_count) {
+    // Open trace file (2nd to last argument) and read its header
+    std::string tf_error = trace_reader.open(argv[arg_max_count - 2]);
+    exitIf(!tf_error.empty(), tf_error, 0, arg_max_count - 2);
 
     // If trace limit was not specified
     if (argc < arg_max_count) return 0;
@@ -150,25 +193,67 @@ void readConfigurations(std::vector<cache_config>& configs, char* configs_file_p
     delete[] config_line_cstr;
 }
 
-void printStatsHeader() {
-    std::cout << stat_names[0];
-    for (uint32_t i = 1; i < NUM_COLUMNS; i++) std::cout << ',' << stat_names[i];
-    std::cout << std::endl;
+void readVariants(std::vector<fork_variant>& variants, const char* variants_file_path, const cache_config& base, TraceReader& trace_reader) {
+    // Get the variants file
+    std::ifstream variants_file(variants_file_path);
+    if (!variants_file) {
+        std::cerr << "Variants file read error: " << std::strerror(errno) << std::endl;
+        exit(-1);
+    }
+
+    // Each line is '<coherence> <replacer> [tail_trace_file]'
+    std::string variant_line;
+    for (uint32_t variant_id = 1; std::getline(variants_file, variant_line); variant_id++) {
+        std::istringstream fields(variant_line);
+        fork_variant variant = { base };
+        variant.config.id = variant_id;
+        exitIf(!(fields >> variant.config.coherence >> variant.config.replacer), "Too few arguments in variant", variant_id, ARG_REPLACEMENT);
+        std::string spec_error = TableProtocol::registerSpec(variant.config.coherence);
+        exitIf(!spec_error.empty(), spec_error, variant_id, ARG_COHERENCE);
+        exitIf(!coherence_map->count(variant.config.coherence), "Coherence protocol not found", variant_id, ARG_COHERENCE);
+        std::string duel_error = Duel::registerDuel(variant.config.replacer);
+        exitIf(!duel_error.empty(), duel_error, variant_id, ARG_REPLACEMENT);
+        exitIf(!replacement_map->count(variant.config.replacer), "Replacement policy not found", variant_id, ARG_REPLACEMENT);
+
+        // The tail trace is opened again by the variant's process, but checked here so that errors surface before forking
+        if (fields >> variant.tail_trace) {
+            exitIf(needsNextUse(variant.config), "The OPT replacer only knows the next uses of the trace, not of a tail trace", variant_id, ARG_REPLACEMENT);
+            TraceReader tail_reader;
+            std::string tf_error = tail_reader.open(variant.tail_trace.c_str());
+            exitIf(!tf_error.empty(), tf_error, variant_id, ARG_S_TRACE_FILE);
+            exitIf(tail_reader.addr_width != trace_reader.addr_width || tail_reader.n_cores > trace_reader.n_cores,
+                "Tail trace must have the address width of the trace and no more cores", variant_id, ARG_S_TRACE_FILE);
+        }
+        std::string extra;
+        exitIf((bool)(fields >> extra), "Too many arguments in variant", variant_id, ARG_S_TRACE_FILE);
+        variants.push_back(variant);
+    }
 }
 
 /// @brief Print the program usage method
 void usageMsg() {
     std::cout << "Usage:" << std::endl;
     std::cout << "  (1) ./simulate_cache <coherence|replacer>" << std::endl;
-    std::cout << "  (2) ./simulate_cache <configuration> <trace_file> [trace_limit]" << std::endl;
+    std::cout << "  (2) ./simulate_cache [options..] <configuration> <trace_file> [trace_limit]" << std::endl;
     std::cout << "Description:" << std::endl;
     std::cout << "  (1) Run the simulator in interactive mode (see the manual for more info)" << std::endl;
     std::cout << "  (2) Run the simulator in metrics mode (see below)" << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  configuration: Either a single memory system configuration (see below) or" << std::endl;
     std::cout << "                   the path to a file containing multiple memory system configurations" << std::endl;
-    std::cout << "  trace_file:    The path to the input trace file" << std::endl;
+    std::cout << "  trace_file:    The path to the input trace file, FIFO or Unix socket, or '-' for stdin" << std::endl;
     std::cout << "  trace_limit:   (Optional) The maximum number of trace entries to read" << std::endl;
+    std::cout << "  options:       (Optional) Any of the following:" << std::endl;
+    std::cout << "                   --classify-misses: Classify misses as compulsory, capacity, conflict or coherence" << std::endl;
+    std::cout << "                   --format <csv|bin|col>: The format of the statistics output (default csv)" << std::endl;
+    std::cout << "                   --snoop-filter: Filter the bus messages sent to caches without a copy of the line" << std::endl;
+    std::cout << "                   --hashed-index: Hash the set index of each line with its tag (XOR folding)" << std::endl;
+    std::cout << "                   --private-lines: Skip the bus messages of lines only one core accesses (pre-pass over the trace)" << std::endl;
+    std::cout << "                   --no-check: Do not verify the coherence invariants after each access" << std::endl;
+    std::cout << "                   --checkpoint <file>: Periodically save the simulator state to a checkpoint file" << std::endl;
+    std::cout << "                   --checkpoint-interval <n>: The number of million-trace chunks between checkpoints (default 16)" << std::endl;
+    std::cout << "                   --resume <file>: Resume the run saved in a checkpoint file" << std::endl;
+    std::cout << "                   --fork <n> <variants_file>: Fork the variants of a single configuration after n trace entries" << std::endl;
     std::cout << "Memory system configuration:" << std::endl;
     std::cout << "  Syntax:" << std::endl;
     std::cout << "    <cache_size[unit]> <line_size> <associativity> <coherence> <replacer> <directory>" << std::endl;
@@ -177,11 +262,13 @@ void usageMsg() {
     std::cout << "    cache_size:    The size of the cache in bytes or in the specified unit" << std::endl;
     std::cout << "    coherence:     The name of the coherence protocol (not case sensitive). One of:" << std::endl;
     for (auto& [coh, factory] : *coherence_map) std::cout << "                     - " << coh << std::endl;
+    std::cout << "                   Or " << TABLE_PROTOCOL_PREFIX << "<spec_file> to load a protocol from a transition table" << std::endl;
     std::cout << "    directory:     The name of the directory protocol (not case sensitive). One of:" << std::endl;
     for (auto& [coh, factory] : *directory_map) std::cout << "                     - " << coh << std::endl;
     std::cout << "    line_size:     The size of a line in the cache" << std::endl;
     std::cout << "    replacer:      The name of the replacement policy (not case sensitive). One of:" << std::endl;
     for (auto& [rep, factory] : *replacement_map) std::cout << "                     - " << rep << std::endl;
+    std::cout << "                   Or " << DUEL_REPLACER_PREFIX << "<replacer>:<replacer> to adapt between two of them by set dueling" << std::endl;
     std::cout << "    unit:          (Optional) The unit of the cache size." << std::endl;
     std::cout << "                     Either 'k' or 'M' for kilobytes and megabytes respectively" << std::endl;
 }
@@ -192,6 +279,7 @@ void usageMsg() {
 /// @return The program exit code 
 /// @see @ref docs/pages/exit_codes.md
 int main(int argc, char* argv[]) {
+    getOptions(argc, argv);
     switch (argc) {
     case NO_ARGS:
         usageMsg();
@@ -212,10 +300,3 @@ int main(int argc, char* argv[]) {
         return -1;
     }
 }
-
-bool ci_less::operator()(const std::string& s1, const std::string& s2) const {
-    std::string s1l = s1, s2l = s2;
-    for (char& c : s1l) c = std::tolower(c);
-    for (char& c : s2l) c = std::tolower(c);
-    return s1l < s2l;
-}
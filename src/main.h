@@ -3,7 +3,28 @@
 
 #pragma once
 
-#include "typedefs.h"
+#include "trace_reader.h"
+
+/// @brief A variant of the single configuration, forked from its simulated state partway through the trace
+struct fork_variant {
+    /// @brief The configuration of the variant (only the coherence protocol and replacement policy can differ)
+    cache_config config;
+    /// @brief The trace file processed after the fork (empty to process the rest of the trace)
+    std::string tail_trace;
+};
+
+/// @brief Provide error message and exit code on condition
+/// @param condition Whether the program should print an error message and exit
+/// @param msg The error message to print
+/// @param config_id The ID of the config that caused the error
+/// @param arg_index The argument of the config that caused the error
+/// @see @ref docs/pages/exit_codes.md
+void exitIf(bool condition, std::string msg, uint32_t config_id, uint32_t arg_index);
+
+/// @brief Parse the leading command line options into 'options', removing them from the argument list
+/// @param argc The number of program arguments
+/// @param argv The array of program arguments
+void getOptions(int& argc, char**& argv);
 
 /// @brief Parse the given arguments into a memory system configuration
 /// @param argc The number of program arguments
@@ -11,18 +32,27 @@
 /// @param config The configuration struct to populate
 void getConfig(int argc, char* argv[], cache_config& config);
 
+/// @brief Check if a configuration needs the next use index of the trace, i.e. if its caches use the OPT replacer
+/// @param config The configuration
+/// @return True if the next use index must be loaded
+bool needsNextUse(const cache_config& config);
+
 /// @brief Open the trace file and read the trace limit
 /// @param argc The number of program arguments
 /// @param argv The array of program arguments
-/// @param trace_file An ifstream that will become the trace file
+/// @param trace_reader The reader to open the trace file with
 /// @param arg_max_count The number of arguments when the trace limit argument is present
 /// @return The trace limit
-size_t getTrace(int argc, char* argv[], std::ifstream& trace_file, int arg_max_count);
-
-/// @brief Print the header row in the statistics output CSV
-void printStatsHeader();
+size_t getTrace(int argc, char* argv[], TraceReader& trace_reader, int arg_max_count);
 
 /// @brief Parse the cache configurations from the given configs file
 /// @param configs The vector to contain the configurations
 /// @param configs_file_path The file path to the configs file
 void readConfigurations(std::vector<cache_config>& configs, char* configs_file_path);
+
+/// @brief Parse the variants of the single configuration from the given variants file
+/// @param variants The vector to contain the variants
+/// @param variants_file_path The file path to the variants file
+/// @param base The single configuration
+/// @param trace_reader The reader of the trace (every tail trace must have the same address width and no more cores)
+void readVariants(std::vector<fork_variant>& variants, const char* variants_file_path, const cache_config& base, TraceReader& trace_reader);
@@ -2,90 +2,107 @@
 /// @brief Implementation of the MemorySystem class methods
 
 #include "cache.h"
+#include "checkpoint.h"
+#include "coherence_checker.h"
 #include "memory_system.h"
 
-MemorySystem::MemorySystem(cache_config& config)
-    : copies_exist(false), flushed(false), caches{ 0 }, config(config) {}
-MemorySystem::~MemorySystem() {
-    for (uint32_t i = 0; i < MAX_N_CACHES; i++)
+template<typename A>
+MemorySystem<A>::MemorySystem(cache_config& config, uint32_t n_caches)
+    : access_timestamp(0), copies_exist(false), flushed(false), owned(false), silent_copies(0),
+    shared_lines(nullptr), next_use(nullptr), n_caches(n_caches), line_offset(__builtin_ctz(config.line_size)), config(config) {
+    caches = new Cache<A>*[n_caches] { 0 };
+    checker = options.check_coherence ? new CoherenceChecker<A>(n_caches, config.id) : nullptr;
+}
+template<typename A>
+MemorySystem<A>::~MemorySystem() {
+    for (uint32_t i = 0; i < n_caches; i++)
         delete caches[i];
+    delete[] caches;
+    delete checker;
 }
 
-void MemorySystem::issuePrRd(addr_t addr, uint32_t cache_id
-#ifdef WRITE_TIMESTAMP
-    , size_t read_timestamp
-#endif
-) {
+template<typename A>
+void MemorySystem<A>::issuePrRd(A addr, uint32_t cache_id, size_t timestamp) {
     // Dynamically allocate cache
-    if (!caches[cache_id]) caches[cache_id] = new Cache(*this, cache_id, config);
+    if (!caches[cache_id]) caches[cache_id] = new Cache<A>(*this, cache_id, config);
 
-#ifdef WRITE_TIMESTAMP
-    access_timestamp = read_timestamp;
-#endif
+    access_timestamp = timestamp;
     caches[cache_id]->receivePrRd(addr);
-#ifdef WRITE_TIMESTAMP
-    verifyTimestamp(addr, false, read_timestamp);
-#endif
 }
 
-void MemorySystem::issuePrWr(addr_t addr, uint32_t cache_id
-#ifdef WRITE_TIMESTAMP
-    , size_t write_timestamp
-#endif
-) {
+template<typename A>
+void MemorySystem<A>::issuePrWr(A addr, uint32_t cache_id, size_t timestamp) {
     // Dynamically allocate cache
-    if (!caches[cache_id]) caches[cache_id] = new Cache(*this, cache_id, config);
+    if (!caches[cache_id]) caches[cache_id] = new Cache<A>(*this, cache_id, config);
 
-#ifdef WRITE_TIMESTAMP
-    access_timestamp = write_timestamp;
-#endif
+    access_timestamp = timestamp;
     caches[cache_id]->receivePrWr(addr);
-#ifdef WRITE_TIMESTAMP
-    verifyTimestamp(addr, true, write_timestamp);
-#endif
 }
 
-void MemorySystem::printStats() {
-    for (uint32_t i = 0; i < MAX_N_CACHES; i++)
+template<typename A>
+void MemorySystem<A>::printStats(ResultsSink& sink) {
+    for (uint32_t i = 0; i < n_caches; i++)
         if (caches[i])
-            caches[i]->printStats();
+            caches[i]->printStats(sink);
 }
 
-#ifdef WRITE_TIMESTAMP
-void MemorySystem::verifyTimestamp(addr_t addr, bool write, size_t current_timestamp) {
-    // Collect each cache's timestamps for the accessed address
-    size_t timestamps[MAX_N_CACHES];
-    for (uint32_t i = 0; i < MAX_N_CACHES; i++)
-        timestamps[i] = caches[i] ? caches[i]->getTimestamp(addr) : 0;
+template<typename A>
+void MemorySystem<A>::copyStats(size_t* statistics) {
+    for (uint32_t i = 0; i < n_caches; i++) {
+        if (caches[i]) std::copy_n(caches[i]->getStatistics(), N_STATISTICS, &statistics[i * N_STATISTICS]);
+        else std::fill_n(&statistics[i * N_STATISTICS], N_STATISTICS, 0);
+    }
+}
 
-    // Determine if any of the timestamps differ and keep track of the maximum
-    bool discrepancy = false;
-    size_t max_timestamp = 0;
-    for (uint32_t i = 0; i < MAX_N_CACHES; i++) {
-        if (!timestamps[i]) continue;
-        if (timestamps[i] != max_timestamp) discrepancy = (bool)max_timestamp;
-        if (timestamps[i] > max_timestamp) max_timestamp = timestamps[i];
+template<typename A>
+std::string MemorySystem<A>::checkCoherenceSwitch(const std::string& coherence) {
+    for (uint32_t i = 0; i < n_caches; i++) {
+        if (!caches[i]) continue;
+        state_e unsupported = caches[i]->findUnsupportedState(coherence);
+        if (unsupported) return "Coherence protocol cannot take over cache " + std::to_string(i) + ", which holds lines in the " + state_names[unsupported] + " state";
     }
+    return "";
+}
 
-    if (discrepancy) {
-        // Report the discrepancy
-        std::cerr << "Cache lines out of date after " << (write ? "writing to" : "reading from");
-        std::cerr << " address " << std::setbase(16) << addr;
-        std::cerr << " at step " << std::setbase(10) << current_timestamp + 1 << ": ";
+template<typename A>
+void MemorySystem<A>::reconfigure(const std::string& coherence, const std::string& replacer) {
+    // Only the components that change are replaced, so that the others keep their state
+    protocol_less coherence_less;
+    ci_less less;
+    bool new_coherence = coherence_less(coherence, config.coherence) || coherence_less(config.coherence, coherence);
+    bool new_replacer = less(replacer, config.replacer) || less(config.replacer, replacer);
 
-        // Print the first discrepancy
-        uint32_t i = 0;
-        for (; i < MAX_N_CACHES; i++)
-            if (timestamps[i] && timestamps[i] < max_timestamp) {
-                std::cerr << i;
-                break;
-            }
+    // Caches allocated from now on use the new configuration as well
+    config.coherence = coherence;
+    config.replacer = replacer;
+    for (uint32_t i = 0; i < n_caches; i++)
+        if (caches[i])
+            caches[i]->reconfigure(new_coherence, new_replacer);
+}
 
-        // Print the remaining discrepancies
-        for (; i < MAX_N_CACHES; i++)
-            if (timestamps[i] && timestamps[i] < max_timestamp)
-                std::cerr << ", " << i;
-        std::cerr << std::endl;
-    }
+template<typename A>
+void MemorySystem<A>::checkpoint(std::ostream& out) {
+    // Which caches are allocated, followed by the state of each allocated cache
+    std::vector<uint8_t> allocated(n_caches);
+    for (uint32_t i = 0; i < n_caches; i++) allocated[i] = caches[i] != nullptr;
+    writeArray(out, allocated.data(), n_caches);
+    for (uint32_t i = 0; i < n_caches; i++)
+        if (caches[i])
+            caches[i]->checkpoint(out);
+    if (checker) checker->checkpoint(out);
 }
-#endif
+
+template<typename A>
+void MemorySystem<A>::restore(std::istream& in) {
+    std::vector<uint8_t> allocated(n_caches);
+    readArray(in, allocated.data(), n_caches);
+    for (uint32_t i = 0; i < n_caches && in; i++)
+        if (allocated[i]) {
+            if (!caches[i]) caches[i] = new Cache<A>(*this, i, config);
+            caches[i]->restore(in);
+        }
+    if (checker) checker->restore(in);
+}
+
+template class MemorySystem<uint32_t>;
+template class MemorySystem<uint64_t>;
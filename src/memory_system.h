@@ -3,22 +3,22 @@
 
 #pragma once
 
-#include "typedefs.h"
+#include "flat_map.h"
 
-/// @brief The maximum number of caches supported by the current trace format (7 bit ID = 128 ID values)
-#define MAX_N_CACHES 0b10000000
+/// @brief The maximum number of caches supported by the trace formats (version 1 traces are limited to 128 caches)
+#define MAX_N_CACHES 1024
 
 /// @brief The MemorySystem class connecting multiple caches and main memory
+/// @tparam A The address type (uint32_t or uint64_t, depending on the address width of the trace)
+template<typename A>
 class MemorySystem {
 public:
 
-#ifdef WRITE_TIMESTAMP
     /// @brief The access number of the current memory access
     size_t access_timestamp;
 
-    /// @brief The most recent timestamp of a cache block across all caches
-    size_t most_recent_sibling;
-#endif
+    /// @brief The coherence invariant checker (nullptr unless enabled)
+    CoherenceChecker<A>* checker;
 
     /// @brief Flag to indicate if copies of a cache block exist in other caches
     bool copies_exist;
@@ -26,64 +26,92 @@ public:
     /// @brief Flag to indicate if a cache flushed one of its lines
     bool flushed;
 
+    /// @brief Flag to indicate if a cache kept owning a line it flushed (O or Sm), so that it stays the responder
+    bool owned;
+
+    /// @brief The number of valid copies of a line that did not respond to a bus read
+    uint32_t silent_copies;
+
+    /// @brief The lines accessed by more than one core in the trace (nullptr unless the private line fast path is
+    /// enabled, see SharingMap)
+    FlatMap<A, uint8_t>* shared_lines;
+    /// @brief The next use distance of each record of the trace (nullptr unless a cache uses the OPT replacer, see
+    /// NextUseIndex)
+    const uint32_t* next_use;
+
     /// @brief Construct a new memory system
     /// @param config The configuration of this memory system
-    MemorySystem(cache_config& config);
+    /// @param n_caches The number of caches in this memory system (the number of cores in the trace)
+    MemorySystem(cache_config& config, uint32_t n_caches);
     virtual ~MemorySystem();
 
-    /// @brief Issue a PrWr message to a cache
+    /// @brief Issue a PrRd message to a cache
     /// @param addr The address accessed
     /// @param cache_id The cache ID of the recipient
-#ifdef WRITE_TIMESTAMP
-    /// @param read_timestamp The access number of the current read access
-#endif
-    void issuePrRd(addr_t addr, uint32_t cache_id
-#ifdef WRITE_TIMESTAMP
-        , size_t read_timestamp
-#endif
-    );
-    /// @brief Issue a PrRd message to a cache
+    /// @param timestamp The access number of the current read access
+    void issuePrRd(A addr, uint32_t cache_id, size_t timestamp);
+    /// @brief Issue a PrWr message to a cache
     /// @param addr The address accessed
     /// @param cache_id The cache ID of the recipient
-#ifdef WRITE_TIMESTAMP
-    /// @param write_timestamp The access number of the current write access
-#endif
-    void issuePrWr(addr_t addr, uint32_t cache_id
-#ifdef WRITE_TIMESTAMP
-        , size_t write_timestamp
-#endif
-    );
+    /// @param timestamp The access number of the current write access
+    void issuePrWr(A addr, uint32_t cache_id, size_t timestamp);
 
     /// @brief Issue a bus message from a cache to all other caches
     /// @param bus_msg The specific bus message
     /// @param addr The address accessed
     /// @param cache_id The cache ID of the requestor
-    virtual void issueBusMsg(bus_msg_e bus_msg, addr_t addr, uint32_t cache_id) = 0;
+    virtual void issueBusMsg(bus_msg_e bus_msg, A addr, uint32_t cache_id) = 0;
 
-    /// @brief Print simulation run statistics in CSV format (headerless)
-    void printStats();
+    /// @brief Check if other caches may hold a copy of a line, i.e. if bus messages for the line must be delivered
+    /// @param addr The address accessed
+    /// @return False if the line is private to the cache accessing it (always true without the private line fast path)
+    inline bool isLineShared(A addr) { return !shared_lines || shared_lines->find(addr >> line_offset); }
+
+    /// @brief Add the simulation run statistics of every cache to the output
+    /// @param sink The results sink collecting the output
+    void printStats(ResultsSink& sink);
+
+    /// @brief Copy the simulation run statistics of every cache
+    /// @param statistics The array to copy to ('n_caches' rows of N_STATISTICS values, 0 for caches never accessed)
+    void copyStats(size_t* statistics);
+
+    /// @brief Check that a coherence protocol can take over the lines of every cache
+    /// @param coherence The name of the coherence protocol
+    /// @return An error message, or an empty string if the protocol has the state of every valid line
+    std::string checkCoherenceSwitch(const std::string& coherence);
+    /// @brief Switch every cache to another coherence protocol and/or replacement policy, keeping the cache lines
+    /// and statistics (see Cache::reconfigure)
+    /// @param coherence The name of the coherence protocol
+    /// @param replacer The name of the replacement policy
+    void reconfigure(const std::string& coherence, const std::string& replacer);
+
+    /// @brief Write the state of every allocated cache, and of the coherence checker, to a checkpoint
+    /// @param out The checkpoint stream
+    virtual void checkpoint(std::ostream& out);
+    /// @brief Restore the state of every cache, and of the coherence checker, from a checkpoint
+    /// @param in The checkpoint stream
+    virtual void restore(std::istream& in);
 
 protected:
 
-    /// @brief Array of this memory system's caches
-    Cache* caches[MAX_N_CACHES];
+    /// @brief Array of this memory system's caches ('n_caches' entries, nullptr until a cache is first accessed)
+    Cache<A>** caches;
+    /// @brief The number of caches in this memory system
+    uint32_t n_caches;
+    /// @brief Number of bits that come before the line offset field
+    uint32_t line_offset;
 
 private:
 
     /// @brief Config for this memory system
     cache_config config;
-
-#ifdef WRITE_TIMESTAMP
-    /// @brief Check if all valid copies of a cache block have the same timestamp
-    /// @param addr The memory address in the cache block
-    /// @param write Whether the current operation is a processor write
-    /// @param current_timestamp The current access number
-    void verifyTimestamp(addr_t addr, bool write, size_t current_timestamp);
-#endif
 };
 
-/// @brief Create a mapping in 'directory_map' from a string containing the class name to a factory method for the class
-/// @param dir_prot The directory protocol type
+/// @brief Create a mapping in 'directory_map' from a string containing the class name to the factory methods for the class
+/// @param dir_prot The directory protocol class template (templated on the address type)
 #define ADD_DIRECTORY_TO_CMD_LINE(dir_prot) static int register_directory = []() { \
 if (directory_map == nullptr) directory_map = new std::map<std::string, dir_factory_t, ci_less>(); \
-(*directory_map)[#dir_prot] = [](cache_config& config) { return new dir_prot(config); }; return 0; }()
+(*directory_map)[#dir_prot] = { \
+    [](cache_config& config, uint32_t n_caches) -> MemorySystem<uint32_t>* { return new dir_prot<uint32_t>(config, n_caches); }, \
+    [](cache_config& config, uint32_t n_caches) -> MemorySystem<uint64_t>* { return new dir_prot<uint64_t>(config, n_caches); } }; \
+return 0; }()
@@ -0,0 +1,122 @@
+/// @file miss_classifier.cc
+/// @brief Implementation of the MissClassifier class
+
+#include "miss_classifier.h"
+
+/// @brief Node index representing the end of a list
+#define NIL (~(uint32_t)0)
+
+template<typename A>
+MissClassifier<A>::MissClassifier(uint32_t num_lines)
+    : num_lines(num_lines), fa_lookup(num_lines), fa_head(NIL), fa_tail(NIL), fa_free(0) {
+    fa_line = new A[num_lines];
+    fa_next = new uint32_t[num_lines];
+    fa_prev = new uint32_t[num_lines];
+
+    // Every node starts out in the free list
+    for (uint32_t i = 0; i < num_lines; i++)
+        fa_next[i] = i + 1 < num_lines ? i + 1 : NIL;
+}
+template<typename A>
+MissClassifier<A>::~MissClassifier() {
+    delete[] fa_line;
+    delete[] fa_next;
+    delete[] fa_prev;
+}
+
+template<typename A>
+statistic_e MissClassifier<A>::access(A line_addr, bool allocate) {
+    // Never accessed before: compulsory miss (the line was seen now though)
+    bool first_access;
+    bool& invalidated = seen.insert(line_addr, first_access);
+    statistic_e miss_class;
+    if (first_access) miss_class = CompulsoryMiss;
+    else if (invalidated) miss_class = CoherenceMiss;
+    else miss_class = CapacityMiss;
+    // A no-allocate miss doesn't refetch the line, so a later miss is still due to the invalidation
+    if (allocate) invalidated = false;
+
+    // Update the fully-associative LRU cache
+    uint32_t* node = fa_lookup.find(line_addr);
+    if (node) {
+        // A miss that the fully-associative cache would have avoided is a conflict miss
+        if (miss_class == CapacityMiss) miss_class = ConflictMiss;
+        unlink(*node);
+        pushFront(*node);
+    } else if (allocate) {
+        // Take a free node, or else evict the least recently used line
+        uint32_t new_node = fa_free;
+        if (new_node != NIL) fa_free = fa_next[new_node];
+        else {
+            new_node = fa_tail;
+            unlink(new_node);
+            fa_lookup.erase(fa_line[new_node]);
+        }
+        bool inserted;
+        fa_lookup.insert(line_addr, inserted) = new_node;
+        fa_line[new_node] = line_addr;
+        pushFront(new_node);
+    }
+
+    return miss_class;
+}
+
+template<typename A>
+void MissClassifier<A>::invalidate(A line_addr) {
+    bool* invalidated = seen.find(line_addr);
+    if (invalidated) *invalidated = true;
+
+    // The fully-associative cache observes invalidations too
+    uint32_t* node = fa_lookup.find(line_addr);
+    if (node) {
+        uint32_t free_node = *node;
+        unlink(free_node);
+        fa_lookup.erase(line_addr);
+        fa_next[free_node] = fa_free;
+        fa_free = free_node;
+    }
+}
+
+template<typename A>
+void MissClassifier<A>::unlink(uint32_t node) {
+    if (fa_prev[node] != NIL) fa_next[fa_prev[node]] = fa_next[node];
+    else fa_head = fa_next[node];
+    if (fa_next[node] != NIL) fa_prev[fa_next[node]] = fa_prev[node];
+    else fa_tail = fa_prev[node];
+}
+
+template<typename A>
+void MissClassifier<A>::pushFront(uint32_t node) {
+    fa_prev[node] = NIL;
+    fa_next[node] = fa_head;
+    if (fa_head != NIL) fa_prev[fa_head] = node;
+    else fa_tail = node;
+    fa_head = node;
+}
+
+template<typename A>
+void MissClassifier<A>::checkpoint(std::ostream& out) {
+    seen.checkpoint(out);
+    fa_lookup.checkpoint(out);
+    writeArray(out, fa_line, num_lines);
+    writeArray(out, fa_next, num_lines);
+    writeArray(out, fa_prev, num_lines);
+    writeValue(out, fa_head);
+    writeValue(out, fa_tail);
+    writeValue(out, fa_free);
+}
+
+template<typename A>
+void MissClassifier<A>::restore(std::istream& in) {
+    seen.restore(in);
+    fa_lookup.restore(in);
+    readArray(in, fa_line, num_lines);
+    readArray(in, fa_next, num_lines);
+    readArray(in, fa_prev, num_lines);
+    readValue(in, fa_head);
+    readValue(in, fa_tail);
+    readValue(in, fa_free);
+}
+
+template class MissClassifier<uint32_t>;
+template class MissClassifier<uint64_t>;
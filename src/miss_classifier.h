@@ -0,0 +1,70 @@
+/// @file miss_classifier.h
+/// @brief Declaration of the MissClassifier class
+
+#pragma once
+
+#include "flat_map.h"
+
+/// @brief Classifies the misses of one cache as compulsory, capacity, conflict or coherence misses
+///
+/// Two shadow structures are kept alongside the cache:
+///   - A never-evicting set of every line the cache has accessed. Its value records whether
+///     the line was invalidated by another cache since the last time it was accessed
+///   - A fully-associative LRU cache with the same number of lines as the real cache
+/// @tparam A The address type
+template<typename A>
+class MissClassifier {
+public:
+
+    /// @brief Construct a new miss classifier
+    /// @param num_lines The number of lines in the cache being shadowed
+    MissClassifier(uint32_t num_lines);
+    ~MissClassifier();
+
+    /// @brief Record an access to a line, and classify it as if it were a miss
+    /// @param line_addr The line address accessed (address without the line offset)
+    /// @param allocate Whether the access brings the line into the cache on a miss
+    /// @return The miss class to record if the access was a miss in the real cache
+    statistic_e access(A line_addr, bool allocate);
+
+    /// @brief Record that another cache invalidated a line
+    /// @param line_addr The line address invalidated (address without the line offset)
+    void invalidate(A line_addr);
+
+    /// @brief Write the shadow structures to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the shadow structures from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
+private:
+
+    /// @brief The number of lines in the cache being shadowed
+    uint32_t num_lines;
+
+    /// @brief Every line address accessed so far, mapped to whether it is awaiting a coherence miss
+    FlatMap<A, bool> seen;
+
+    /// @brief Map from line address to its node in the fully-associative LRU list
+    FlatMap<A, uint32_t> fa_lookup;
+    /// @brief The line address held by each node
+    A* fa_line;
+    /// @brief The next (less recently used) node of each node
+    uint32_t* fa_next;
+    /// @brief The previous (more recently used) node of each node
+    uint32_t* fa_prev;
+    /// @brief The most recently used node
+    uint32_t fa_head;
+    /// @brief The least recently used node
+    uint32_t fa_tail;
+    /// @brief The first node of the free node list (linked through 'fa_next')
+    uint32_t fa_free;
+
+    /// @brief Remove a node from the LRU list
+    /// @param node The node to remove
+    void unlink(uint32_t node);
+    /// @brief Insert a node at the most recently used end of the LRU list
+    /// @param node The node to insert
+    void pushFront(uint32_t node);
+};
@@ -0,0 +1,183 @@
+/// @file next_use.cc
+/// @brief Implementation of the NextUseIndex class
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "flat_map.h"
+#include "next_use.h"
+#include "trace_reader.h"
+
+/// @brief The version of the next use file format
+#define NEXT_USE_VERSION 1
+/// @brief The number of trace entries decoded at a time by the backward pass
+#define N_NEXT_USE_CHUNK 1000000
+
+template<typename A>
+NextUseIndex<A>::~NextUseIndex() {
+    for (mapped_file& mapping : mappings) munmap(mapping.addr, mapping.size);
+}
+
+template<typename A>
+std::string NextUseIndex<A>::load(const char* trace_path, const std::vector<uint32_t>& line_sizes) {
+    // The next use files are only used if they were written for the current version of the trace file
+    struct stat trace_stat;
+    if (stat(trace_path, &trace_stat) || !S_ISREG(trace_stat.st_mode))
+        return "The OPT replacer needs a trace file that can be read again";
+    TraceReader trace_reader;
+    std::string error = trace_reader.open(trace_path);
+    if (!error.empty()) return error;
+
+    std::vector<std::string> paths, headers;
+    std::vector<uint32_t> missing_sizes;
+    for (uint32_t line_size : line_sizes) {
+        std::ostringstream header;
+        header.write("CSIMNEXT", 8);
+        writeValue<uint32_t>(header, NEXT_USE_VERSION);
+        writeValue<uint32_t>(header, sizeof(A));
+        writeValue<uint32_t>(header, line_size);
+        writeValue<uint64_t>(header, trace_stat.st_size);
+        writeValue<uint64_t>(header, trace_stat.st_mtim.tv_sec * 1000000000ull + trace_stat.st_mtim.tv_nsec);
+        writeValue<uint64_t>(header, trace_reader.n_records);
+
+        std::string path = std::string(trace_path) + ".next" + std::to_string(line_size);
+        if (mapNextUseFile(path, header.str(), trace_reader.n_records, line_size)) continue;
+        paths.push_back(path);
+        headers.push_back(header.str());
+        missing_sizes.push_back(line_size);
+    }
+    if (missing_sizes.empty()) return "";
+
+    error = computeDistances(trace_path, paths, headers, missing_sizes);
+    if (!error.empty()) return error;
+    for (size_t s = 0; s < missing_sizes.size(); s++)
+        if (!distances.count(missing_sizes[s]) && !mapNextUseFile(paths[s], headers[s], trace_reader.n_records, missing_sizes[s]))
+            return "Next use file read error: " + paths[s];
+    return "";
+}
+
+template<typename A>
+bool NextUseIndex<A>::mapNextUseFile(const std::string& path, const std::string& header, uint64_t n_records, uint32_t line_size) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat file_stat;
+    size_t size = header.size() + n_records * sizeof(uint32_t);
+    void* addr = MAP_FAILED;
+    if (!fstat(fd, &file_stat) && (size_t)file_stat.st_size == size)
+        addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return false;
+
+    // A next use file of another trace, version or line size is computed again
+    if (memcmp(addr, header.data(), header.size())) {
+        munmap(addr, size);
+        return false;
+    }
+    mappings.push_back({ addr, size });
+    distances[line_size] = (const uint32_t*)((const char*)addr + header.size());
+    return true;
+}
+
+template<typename A>
+std::string NextUseIndex<A>::computeDistances(const char* trace_path, const std::vector<std::string>& paths,
+    const std::vector<std::string>& headers, const std::vector<uint32_t>& line_sizes) {
+    TraceReader trace_reader;
+    std::string error = trace_reader.open(trace_path);
+    if (!error.empty()) return error;
+    uint64_t n_records = trace_reader.n_records;
+
+    // Write to temporary files first, so that concurrent runs never map a partial next use file
+    std::vector<int> fds;
+    auto closeFiles = [&fds, &paths](bool keep) {
+        for (size_t s = 0; s < fds.size(); s++) {
+            if (fds[s] < 0) continue;
+            std::string temp_path = paths[s] + ".tmp";
+            bool closed = !close(fds[s]);
+            if (!keep || !closed || std::rename(temp_path.c_str(), paths[s].c_str())) std::remove(temp_path.c_str());
+        }
+    };
+    // If a next use file cannot be created (e.g. the trace is in a read-only directory), the distances are computed
+    // into an anonymous mapping instead, which only lasts for this run
+    std::vector<uint32_t*> in_memory(line_sizes.size(), nullptr);
+    for (size_t s = 0; s < line_sizes.size(); s++) {
+        int fd = open((paths[s] + ".tmp").c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0 && pwrite(fd, headers[s].data(), headers[s].size(), 0) != (ssize_t)headers[s].size()) {
+            close(fd);
+            std::remove((paths[s] + ".tmp").c_str());
+            fd = -1;
+        }
+        fds.push_back(fd);
+        if (fd >= 0) continue;
+
+        size_t size = std::max<size_t>(n_records * sizeof(uint32_t), 1);
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            closeFiles(false);
+            return "Next use file write error: " + paths[s] + ": " + std::strerror(errno);
+        }
+        mappings.push_back({ addr, size });
+        in_memory[s] = (uint32_t*)addr;
+    }
+
+    // The last access of each line by each core, in the part of the trace after the current chunk
+    std::vector<std::vector<std::unique_ptr<FlatMap<A, uint64_t>>>> last_uses(line_sizes.size());
+    std::vector<uint32_t> line_offsets;
+    for (size_t s = 0; s < line_sizes.size(); s++) {
+        line_offsets.push_back(__builtin_ctz(line_sizes[s]));
+        for (uint32_t i = 0; i < trace_reader.n_cores; i++) last_uses[s].push_back(std::make_unique<FlatMap<A, uint64_t>>());
+    }
+
+    // Scan the chunks from the last one to the first one, each of them backward
+    std::vector<trace_entry<A>> trace_buf(N_NEXT_USE_CHUNK);
+    std::vector<uint32_t> chunk_distances(N_NEXT_USE_CHUNK);
+    for (uint64_t chunk_end = n_records; chunk_end;) {
+        uint64_t chunk_start = chunk_end > N_NEXT_USE_CHUNK ? chunk_end - N_NEXT_USE_CHUNK : 0;
+        size_t chunk_count = chunk_end - chunk_start;
+        TraceReader chunk_reader;
+        chunk_reader.open(trace_path);
+        size_t count = 0;
+        if (chunk_reader.skip(chunk_start)) {
+            while (count < chunk_count) {
+                size_t read_count = chunk_reader.read(&trace_buf[count], chunk_count - count);
+                if (!read_count) break;
+                count += read_count;
+            }
+        }
+        if (count < chunk_count || chunk_reader.isMalformed()) {
+            closeFiles(false);
+            return "Malformed trace file";
+        }
+
+        for (size_t s = 0; s < line_sizes.size(); s++) {
+            bool inserted;
+            for (size_t i = chunk_count; i--;) {
+                uint64_t& last_use = last_uses[s][trace_buf[i].cache_id]->insert(trace_buf[i].addr >> line_offsets[s], inserted);
+                chunk_distances[i] = inserted ? NEXT_USE_NEVER : (uint32_t)std::min<uint64_t>(last_use - (chunk_start + i), NEXT_USE_NEVER);
+                last_use = chunk_start + i;
+            }
+            size_t chunk_size = chunk_count * sizeof(uint32_t);
+            if (in_memory[s]) std::copy_n(chunk_distances.data(), chunk_count, in_memory[s] + chunk_start);
+            else if (pwrite(fds[s], chunk_distances.data(), chunk_size, headers[s].size() + chunk_start * sizeof(uint32_t)) != (ssize_t)chunk_size) {
+                closeFiles(false);
+                return "Next use file write error: " + paths[s] + ": " + std::strerror(errno);
+            }
+        }
+        chunk_end = chunk_start;
+    }
+    closeFiles(true);
+    for (size_t s = 0; s < line_sizes.size(); s++)
+        if (in_memory[s]) distances[line_sizes[s]] = in_memory[s];
+    return "";
+}
+
+template class NextUseIndex<uint32_t>;
+template class NextUseIndex<uint64_t>;
@@ -0,0 +1,84 @@
+/// @file next_use.h
+/// @brief Declaration of the NextUseIndex class, which tells the next access of a core to the line of each record
+///
+/// Next use file format (native byte order, since it is a cache of the trace file on the machine that wrote it):
+/// - Magic number: the 8 characters "CSIMNEXT"
+/// - Format version (uint32_t): 1
+/// - Address width and line size (uint32_t each), and the size and modification time of the trace file and the
+///   number of records in the trace (uint64_t each, the time in nanoseconds), which must match the trace file for the
+///   next use file to be used
+/// - The next use distance of each record (uint32_t each): the number of records until the next access of the same
+///   core to the same line, or NEXT_USE_NEVER if there is none (distances that do not fit are saturated to it)
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/// @brief The next use distance of a record whose line is never accessed again by the core
+#define NEXT_USE_NEVER UINT32_MAX
+
+/// @brief The next use distances of the records of a trace, for each line size
+///
+/// The distances are computed by a backward pass over the trace, one chunk at a time from the last chunk to the
+/// first, so the pass only holds a chunk and the last access of each line in memory however long the trace is. The
+/// result is saved to a next use file next to the trace file ('<trace_file>.next<line_size>'), which is mapped into
+/// memory for the simulation (or kept in anonymous memory for the run, if the file cannot be created)
+/// @tparam A The address type
+template<typename A>
+class NextUseIndex {
+public:
+
+    NextUseIndex() {}
+    ~NextUseIndex();
+
+    NextUseIndex(const NextUseIndex&) = delete;
+    NextUseIndex& operator=(const NextUseIndex&) = delete;
+
+    /// @brief Map the next use files of a trace, computing the next use distances of the line sizes whose next use
+    /// file is missing or out of date
+    /// @param trace_path The path to the trace file (which must be a regular file)
+    /// @param line_sizes The line sizes to compute the next use distances for
+    /// @return An error message, or an empty string on success
+    std::string load(const char* trace_path, const std::vector<uint32_t>& line_sizes);
+
+    /// @brief Get the next use distances for a line size
+    /// @param line_size The line size (one of the loaded line sizes)
+    /// @return The next use distance of each record of the trace
+    const uint32_t* getDistances(uint32_t line_size) { return distances.at(line_size); }
+
+private:
+
+    /// @brief A next use file mapped into memory
+    struct mapped_file {
+        /// @brief The start of the mapping
+        void* addr;
+        /// @brief The size of the mapping
+        size_t size;
+    };
+
+    /// @brief The next use distances of each line size (pointing into the mapped files)
+    std::map<uint32_t, const uint32_t*> distances;
+    /// @brief The mapped next use files
+    std::vector<mapped_file> mappings;
+
+    /// @brief Map a next use file, if it is up to date
+    /// @param path The path to the next use file
+    /// @param header The expected header, identifying the trace file and line size
+    /// @param n_records The number of records in the trace
+    /// @param line_size The line size of the file
+    /// @return True if the file was mapped
+    bool mapNextUseFile(const std::string& path, const std::string& header, uint64_t n_records, uint32_t line_size);
+
+    /// @brief Compute the next use distances of some line sizes with a backward pass over the trace, writing a next use
+    /// file for each line size (a line size whose file cannot be created gets its distances in memory right away)
+    /// @param trace_path The path to the trace file
+    /// @param paths The path of the next use file of each line size
+    /// @param headers The header of the next use file of each line size
+    /// @param line_sizes The line sizes
+    /// @return An error message, or an empty string on success
+    std::string computeDistances(const char* trace_path, const std::vector<std::string>& paths,
+        const std::vector<std::string>& headers, const std::vector<uint32_t>& line_sizes);
+};
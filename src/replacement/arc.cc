@@ -0,0 +1,143 @@
+/// @file arc.cc
+/// @brief Implementation of the adaptive replacement cache policy
+
+#include <algorithm>
+
+#include "arc.h"
+#include "checkpoint.h"
+
+ADD_REPLACER_TO_CMD_LINE(ARC);
+
+ARC::ARC(CacheABC& cache, uint32_t num_sets, uint32_t assoc)
+    : ReplacementPolicy(cache, num_sets, assoc), clock(0) {
+    lines = new arc_line[num_sets * assoc]{};
+    sets = new arc_set[num_sets]{};
+}
+ARC::~ARC() {
+    delete[] lines;
+    delete[] sets;
+}
+
+uint32_t ARC::getVictim(uint32_t set_idx) {
+    arc_line* set = &lines[set_idx * assoc];
+    uint32_t n_t1 = 0, lru_t1 = assoc, lru_t2 = assoc;
+    for (uint32_t i = 0; i < assoc; i++) {
+        if (!cache.getLineState(set_idx, i)) {
+            notifyReplaced(set_idx, i);
+            return i;
+        }
+        if (set[i].list == ARC_T1) {
+            n_t1++;
+            if (lru_t1 == assoc || set[i].stamp < set[lru_t1].stamp) lru_t1 = i;
+        } else if (lru_t2 == assoc || set[i].stamp < set[lru_t2].stamp) lru_t2 = i;
+    }
+
+    bool from_t1 = n_t1 && (n_t1 > sets[set_idx].target || lru_t2 == assoc);
+    uint32_t victim = from_t1 ? lru_t1 : lru_t2;
+    notifyReplaced(set_idx, victim);
+    return victim;
+}
+
+void ARC::notifyReplaced(uint32_t set_idx, uint32_t way_idx) {
+    // The evicted line is remembered once the line being filled is known (an invalidated line was not replaced, so
+    // it is not remembered)
+    arc_line& line = lines[set_idx * assoc + way_idx];
+    arc_set& set_state = sets[set_idx];
+    if (!cache.getLineState(set_idx, way_idx) || line.list == ARC_NONE) set_state.evicted_list = ARC_NONE;
+    else set_state.evicted_list = line.list == ARC_T1 ? ARC_B1 : ARC_B2;
+    set_state.evicted_tag = cache.getLineTag(set_idx, way_idx);
+    line.list = ARC_NONE;
+}
+
+void ARC::touch(uint32_t set_idx, uint32_t way_idx) {
+    arc_line& line = lines[set_idx * assoc + way_idx];
+    if (line.list == ARC_NONE) fill(set_idx, way_idx);
+    else line.list = ARC_T2;
+    line.stamp = ++clock;
+}
+
+void ARC::fill(uint32_t set_idx, uint32_t way_idx) {
+    arc_line* set = &lines[set_idx * assoc];
+    arc_set& set_state = sets[set_idx];
+    uint64_t tag = cache.getLineTag(set_idx, way_idx);
+    uint32_t n_t1 = 0, n_b1 = 0, n_b2 = 0, lru_b1 = assoc, lru_b2 = assoc, ghost_idx = assoc;
+    for (uint32_t i = 0; i < assoc; i++) {
+        n_t1 += set[i].list == ARC_T1;
+        if (set[i].ghost_list == ARC_B1) {
+            n_b1++;
+            if (lru_b1 == assoc || set[i].ghost_stamp < set[lru_b1].ghost_stamp) lru_b1 = i;
+        } else if (set[i].ghost_list == ARC_B2) {
+            n_b2++;
+            if (lru_b2 == assoc || set[i].ghost_stamp < set[lru_b2].ghost_stamp) lru_b2 = i;
+        }
+        if (set[i].ghost_list != ARC_NONE && set[i].ghost_tag == tag) ghost_idx = i;
+    }
+
+    arc_list_e evicted_list = set_state.evicted_list;
+    set_state.evicted_list = ARC_NONE;
+    if (ghost_idx < assoc) {
+        // A line evicted recently goes to T2, after adapting the target of T1 to the list it was evicted from
+        if (set[ghost_idx].ghost_list == ARC_B1) {
+            set_state.target = std::min(assoc, set_state.target + std::max(n_b2 / n_b1, 1u));
+            cache.addStatistic(RecencyGhostHit);
+        } else {
+            uint32_t delta = std::max(n_b1 / n_b2, 1u);
+            set_state.target = set_state.target > delta ? set_state.target - delta : 0;
+            cache.addStatistic(FrequencyGhostHit);
+        }
+        set[ghost_idx].ghost_list = ARC_NONE;
+        set[way_idx].list = ARC_T2;
+    } else {
+        // T1 and B1 together remember at most as many lines as the set holds (an eviction from a full T1 is not
+        // remembered), and all the lists together twice as many
+        set[way_idx].list = ARC_T1;
+        uint32_t n_t1_before = n_t1 + (evicted_list == ARC_B1);
+        if (n_t1_before + n_b1 >= assoc) {
+            if (n_t1_before < assoc) set[lru_b1].ghost_list = ARC_NONE;
+            else evicted_list = ARC_NONE;
+        } else if (evicted_list != ARC_NONE && n_b1 + n_b2 >= assoc) set[lru_b2].ghost_list = ARC_NONE;
+    }
+    if (evicted_list == ARC_NONE) return;
+
+    uint32_t free_idx = 0;
+    while (free_idx < assoc - 1 && set[free_idx].ghost_list != ARC_NONE) free_idx++;
+    set[free_idx].ghost_list = evicted_list;
+    set[free_idx].ghost_tag = set_state.evicted_tag;
+    set[free_idx].ghost_stamp = ++clock;
+}
+
+void ARC::printState(uint32_t set_idx) {
+    if (set_idx >= num_sets) return;
+    static const char* const list_names[] = { "-", "T1", "T2" };
+    arc_line* set = &lines[set_idx * assoc];
+    std::cout << 'p' << sets[set_idx].target;
+    for (uint32_t i = 0; i < assoc; i++)
+        std::cout << ' ' << list_names[set[i].list];
+}
+
+void ARC::countSetRegimes(size_t& recency_sets, size_t& frequency_sets) {
+    for (uint32_t s = 0; s < num_sets; s++) {
+        if (2 * sets[s].target > assoc) {
+            recency_sets++;
+            continue;
+        }
+        // Sets that were never accessed have no regime
+        for (uint32_t i = 0; i < assoc; i++)
+            if (lines[s * assoc + i].list != ARC_NONE || lines[s * assoc + i].ghost_list != ARC_NONE) {
+                frequency_sets++;
+                break;
+            }
+    }
+}
+
+void ARC::checkpoint(std::ostream& out) {
+    writeArray(out, lines, num_sets * assoc);
+    writeArray(out, sets, num_sets);
+    writeValue(out, clock);
+}
+
+void ARC::restore(std::istream& in) {
+    readArray(in, lines, num_sets * assoc);
+    readArray(in, sets, num_sets);
+    readValue(in, clock);
+}
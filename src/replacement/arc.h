@@ -0,0 +1,115 @@
+/// @file arc.h
+/// @brief Declaration of the adaptive replacement cache policy
+
+#pragma once
+
+#include "replacement_policy.h"
+
+/// @brief The ARC replacement policy, which adapts each set between recency and frequency
+///
+/// The lines of a set are in one of two lists: T1 holds the lines accessed once since they were filled, and T2 the
+/// lines accessed again. Each set also remembers the tags of as many evicted lines as it has ways, in the ghost lists
+/// B1 (evicted from T1) and B2 (evicted from T2). A fill of a line found in B1 means that T1 was too small, so it
+/// raises the set's target size of T1, while a fill of a line found in B2 lowers it. The victim is the least recently
+/// used line of T1 while T1 is above its target, or else of T2
+/// @note The victim is chosen before the line being filled is known, so unlike the original ARC, a set whose T1 is
+/// exactly at its target evicts from T2 even if the line being filled is in B2
+class ARC : public ReplacementPolicy {
+public:
+
+    /// @brief Construct a new ARC replacement policy
+    /// @param cache The parent cache
+    /// @param num_sets The number of sets in the cache
+    /// @param assoc The associativity of the chace
+    ARC(CacheABC& cache, uint32_t num_sets, uint32_t assoc);
+    ~ARC();
+
+    /// @brief Determine which line of a range of lines to replace
+    /// @param set_idx The index of the set to choose from
+    /// @return The chosen line's index within the set (0 to assoc-1)
+    uint32_t getVictim(uint32_t set_idx);
+
+    /// @brief Notify the replacement policy that a line was just accessed
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    void touch(uint32_t set_idx, uint32_t way_idx);
+
+    /// @brief Notify the replacement policy that a line is replaced, which remembers it in a ghost list
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    void notifyReplaced(uint32_t set_idx, uint32_t way_idx);
+
+    /// @brief Determine whether touching the line touched last again leaves the replacer's state unchanged
+    /// @return False, since each access moves the line to the most recently used end of T2
+    bool isRepeatTouchIdempotent() { return false; }
+
+    /// @brief Print out the replacer's internal state
+    /// @param set_idx The index of the set
+    void printState(uint32_t set_idx);
+
+    /// @brief Count the sets by the list their T1 target favors
+    /// @param recency_sets The number of sets whose T1 target is above half the set
+    /// @param frequency_sets The number of other sets that were accessed
+    void countSetRegimes(size_t& recency_sets, size_t& frequency_sets);
+
+    /// @brief Write the lists and targets to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the lists and targets from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
+private:
+
+    /// @brief The lists of a set
+    enum arc_list_e : uint8_t {
+        /// @brief Not in a list (a line being filled, or an empty ghost entry)
+        ARC_NONE,
+        /// @brief Lines accessed once since they were filled
+        ARC_T1,
+        /// @brief Lines accessed more than once since they were filled
+        ARC_T2,
+        /// @brief Tags of the lines evicted from T1
+        ARC_B1,
+        /// @brief Tags of the lines evicted from T2
+        ARC_B2
+    };
+
+    /// @brief The replacer state of a way: its line, and one ghost entry of the set
+    struct arc_line {
+        /// @brief The time of the last access of the line
+        uint64_t stamp;
+        /// @brief The tag of the evicted line of the ghost entry
+        uint64_t ghost_tag;
+        /// @brief The time the line of the ghost entry was evicted
+        uint64_t ghost_stamp;
+        /// @brief The list of the line (ARC_NONE, ARC_T1 or ARC_T2)
+        arc_list_e list;
+        /// @brief The list of the ghost entry (ARC_NONE, ARC_B1 or ARC_B2)
+        arc_list_e ghost_list;
+    };
+
+    /// @brief The replacer state of a set
+    struct arc_set {
+        /// @brief The tag of the line evicted for the fill in progress
+        uint64_t evicted_tag;
+        /// @brief The target size of T1 (0 to assoc)
+        uint32_t target;
+        /// @brief The ghost list the line evicted for the fill in progress goes to (ARC_NONE if none was evicted)
+        arc_list_e evicted_list;
+    };
+
+    /// @brief The state of each way ('assoc' consecutive entries per set)
+    arc_line* lines;
+    /// @brief The state of each set
+    arc_set* sets;
+    /// @brief The time of the last access or eviction in the cache, which orders the lines of each list
+    uint64_t clock;
+
+    /// @brief Add a line to T1, or to T2 if it is in a ghost list, and remember the line evicted for it
+    /// @param set_idx The index of the set
+    /// @param way_idx The way the line was filled into
+    /// @note The ghost lists are only updated once the line being filled is known, so that the ghost it hits is never
+    /// dropped to make room for the evicted line
+    void fill(uint32_t set_idx, uint32_t way_idx);
+};
@@ -0,0 +1,105 @@
+/// @file duel.cc
+/// @brief Implementation of the set dueling replacement policy
+
+#include <algorithm>
+#include <cstring>
+#include <strings.h>
+
+#include "checkpoint.h"
+#include "duel.h"
+
+/// @brief The largest value of the policy selection counter
+#define DUEL_PSEL_MAX ((1u << DUEL_PSEL_BITS) - 1)
+
+Duel::Duel(CacheABC& cache, uint32_t num_sets, uint32_t assoc, const rep_factory_t& factory_a, const rep_factory_t& factory_b)
+    : ReplacementPolicy(cache, num_sets, assoc), views{ DuelCache(cache), DuelCache(cache) }, psel(DUEL_PSEL_MAX >> 1) {
+    policies[0] = factory_a(views[0], num_sets, assoc);
+    policies[1] = factory_b(views[1], num_sets, assoc);
+
+    // Each policy leads one set of every stretch of sets, the leaders of B halfway between those of A
+    roles = new duel_role_e[num_sets]{};
+    uint32_t n_leaders = std::min<uint32_t>(DUEL_LEADER_SETS, num_sets / 2);
+    for (uint32_t i = 0; i < n_leaders; i++) {
+        uint32_t stretch = num_sets / n_leaders;
+        roles[i * stretch] = DUEL_LEADER_A;
+        roles[i * stretch + stretch / 2] = DUEL_LEADER_B;
+    }
+}
+Duel::~Duel() {
+    delete policies[0];
+    delete policies[1];
+    delete[] roles;
+}
+
+std::string Duel::registerDuel(const std::string& name) {
+    // Only names with the prefix are duels, and each duel only needs to be registered once
+    size_t prefix_len = std::strlen(DUEL_REPLACER_PREFIX);
+    if (name.length() <= prefix_len || strncasecmp(name.c_str(), DUEL_REPLACER_PREFIX, prefix_len) || replacement_map->count(name))
+        return "";
+
+    size_t colon = name.find(':', prefix_len);
+    if (colon == std::string::npos || name.find(':', colon + 1) != std::string::npos)
+        return std::string("Expected two replacement policies: ") + DUEL_REPLACER_PREFIX + "<policy>:<policy>";
+    std::string names[2] = { name.substr(prefix_len, colon - prefix_len), name.substr(colon + 1) };
+    for (const std::string& policy : names) {
+        if (!replacement_map->count(policy)) return "Replacement policy not found: " + policy;
+        if (!strcasecmp(policy.c_str(), "OPT")) return "The OPT replacer cannot duel, since it needs the next uses of the trace";
+    }
+
+    rep_factory_t factory_a = (*replacement_map)[names[0]], factory_b = (*replacement_map)[names[1]];
+    (*replacement_map)[name] = [factory_a, factory_b](CacheABC& cache, uint32_t num_sets, uint32_t assoc) {
+        return new Duel(cache, num_sets, assoc, factory_a, factory_b);
+    };
+    return "";
+}
+
+uint32_t Duel::getVictim(uint32_t set_idx) {
+    // A miss in a leader set counts against its policy
+    if (roles[set_idx] == DUEL_LEADER_A && psel < DUEL_PSEL_MAX) psel++;
+    else if (roles[set_idx] == DUEL_LEADER_B && psel) psel--;
+
+    uint32_t policy = selectPolicy(set_idx);
+    uint32_t victim = policies[policy]->getVictim(set_idx);
+    if (roles[set_idx] == DUEL_FOLLOWER) policies[!policy]->notifyReplaced(set_idx, victim);
+    return victim;
+}
+
+void Duel::touch(uint32_t set_idx, uint32_t way_idx) {
+    // A leader set only ever uses its own policy
+    uint32_t policy = selectPolicy(set_idx);
+    policies[policy]->touch(set_idx, way_idx);
+    if (roles[set_idx] == DUEL_FOLLOWER) policies[!policy]->touch(set_idx, way_idx);
+}
+
+void Duel::notifyReplaced(uint32_t set_idx, uint32_t way_idx) {
+    uint32_t policy = selectPolicy(set_idx);
+    policies[policy]->notifyReplaced(set_idx, way_idx);
+    if (roles[set_idx] == DUEL_FOLLOWER) policies[!policy]->notifyReplaced(set_idx, way_idx);
+}
+
+bool Duel::isRepeatTouchIdempotent() {
+    return policies[0]->isRepeatTouchIdempotent() && policies[1]->isRepeatTouchIdempotent();
+}
+
+void Duel::printState(uint32_t set_idx) {
+    if (set_idx >= num_sets) return;
+    uint32_t policy = selectPolicy(set_idx);
+    std::cout << (policy ? 'B' : 'A') << ' ';
+    policies[policy]->printState(set_idx);
+}
+
+void Duel::countSetRegimes(size_t& recency_sets, size_t& frequency_sets) {
+    policies[psel >> (DUEL_PSEL_BITS - 1)]->countSetRegimes(recency_sets, frequency_sets);
+}
+
+void Duel::checkpoint(std::ostream& out) {
+    writeValue(out, psel);
+    policies[0]->checkpoint(out);
+    policies[1]->checkpoint(out);
+}
+
+void Duel::restore(std::istream& in) {
+    readValue(in, psel);
+    policies[0]->restore(in);
+    policies[1]->restore(in);
+}
@@ -0,0 +1,140 @@
+/// @file duel.h
+/// @brief Declaration of the set dueling replacement policy
+
+#pragma once
+
+#include <string>
+
+#include "replacement_policy.h"
+
+/// @brief The prefix of the name of a set dueling replacement policy, followed by the names of the two dueling
+/// policies separated by a colon (e.g. "Duel:LRU:FIFO")
+#define DUEL_REPLACER_PREFIX "Duel:"
+
+#ifndef DUEL_LEADER_SETS
+/// @brief The number of leader sets of each dueling policy (at most half the sets of the cache each)
+#define DUEL_LEADER_SETS 32
+#endif
+
+#ifndef DUEL_PSEL_BITS
+/// @brief The number of bits of the saturating policy selection counter
+#define DUEL_PSEL_BITS 10
+#endif
+
+/// @brief The set dueling replacement policy, which adapts a cache between two other replacement policies
+///
+/// A few leader sets, spread over the cache, always use the first policy (A), and as many always use the second one
+/// (B). A miss that replaces a line in a leader set of A counts the policy selection counter (PSEL) up, and one in a
+/// leader set of B counts it down, so the other sets follow B while the most significant bit of PSEL is set, and A
+/// otherwise. Both policies are told about the accesses of the follower sets, so that the winner's state is up to date
+/// when the followers switch to it
+/// @note A cache with a single set has no leader sets, so it always uses A
+class Duel : public ReplacementPolicy {
+public:
+
+    /// @brief Construct a new set dueling replacement policy
+    /// @param cache The parent cache
+    /// @param num_sets The number of sets in the cache
+    /// @param assoc The associativity of the chace
+    /// @param factory_a The factory of the first policy
+    /// @param factory_b The factory of the second policy
+    Duel(CacheABC& cache, uint32_t num_sets, uint32_t assoc, const rep_factory_t& factory_a, const rep_factory_t& factory_b);
+    ~Duel();
+
+    /// @brief Register a set dueling replacement policy in 'replacement_map', if the name refers to one
+    /// @param name The name of the replacement policy, DUEL_REPLACER_PREFIX followed by the names of two policies
+    /// separated by a colon
+    /// @return An error message, or an empty string if the policy was registered (or the name is not a duel)
+    static std::string registerDuel(const std::string& name);
+
+    /// @brief Determine which line of a range of lines to replace
+    /// @param set_idx The index of the set to choose from
+    /// @return The chosen line's index within the set (0 to assoc-1)
+    uint32_t getVictim(uint32_t set_idx);
+
+    /// @brief Notify the replacement policy that a line was just accessed
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    void touch(uint32_t set_idx, uint32_t way_idx);
+
+    /// @brief Notify the replacement policy that a line is replaced by a victim it was not asked for
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    void notifyReplaced(uint32_t set_idx, uint32_t way_idx);
+
+    /// @brief Determine whether touching the line touched last again leaves the replacer's state unchanged
+    /// @return True if it does for both policies
+    bool isRepeatTouchIdempotent();
+
+    /// @brief Print out the replacer's internal state
+    /// @param set_idx The index of the set
+    void printState(uint32_t set_idx);
+
+    /// @brief Count the sets by the regime the policy the follower sets use runs them in
+    /// @param recency_sets The number of sets that favor recency
+    /// @param frequency_sets The number of sets that favor frequency
+    void countSetRegimes(size_t& recency_sets, size_t& frequency_sets);
+
+    /// @brief Write the policy selection counter and the state of both policies to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the policy selection counter and the state of both policies from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
+private:
+
+    /// @brief The role of a set in the duel
+    enum duel_role_e : uint8_t {
+        /// @brief The set uses the policy winning the duel
+        DUEL_FOLLOWER,
+        /// @brief The set always uses the first policy
+        DUEL_LEADER_A,
+        /// @brief The set always uses the second policy
+        DUEL_LEADER_B
+    };
+
+    /// @brief The view of the cache of a dueling policy, which only counts the events the policy detects while it
+    /// chooses the victims of the set being accessed
+    class DuelCache : public CacheABC {
+    public:
+
+        /// @brief Construct a new view of a cache
+        /// @param cache The cache
+        DuelCache(CacheABC& cache) : cache(cache), counting(true) {}
+
+        bool issueBusMsg(bus_msg_e bus_msg) { return cache.issueBusMsg(bus_msg); }
+        bool isOwnedElsewhere() { return cache.isOwnedElsewhere(); }
+        void addStatistic(statistic_e stat) { if (counting) cache.addStatistic(stat); }
+        state_e getLineState(uint32_t set_idx, uint32_t way_idx) { return cache.getLineState(set_idx, way_idx); }
+        uint32_t getNumLines() { return cache.getNumLines(); }
+        uint32_t getLineIndex(const cache_line* line) { return cache.getLineIndex(line); }
+        uint64_t getLineTag(uint32_t set_idx, uint32_t way_idx) { return cache.getLineTag(set_idx, way_idx); }
+        uint64_t getNextUse() { return cache.getNextUse(); }
+        uint64_t getRandomSeed() { return cache.getRandomSeed(); }
+
+        /// @brief The cache
+        CacheABC& cache;
+        /// @brief Whether the events the policy detects are counted
+        bool counting;
+    };
+
+    /// @brief The view of the cache of each dueling policy
+    DuelCache views[2];
+    /// @brief The dueling policies (A and B)
+    ReplacementPolicy* policies[2];
+    /// @brief The role of each set
+    duel_role_e* roles;
+    /// @brief The policy selection counter, whose most significant bit selects the policy of the follower sets
+    uint32_t psel;
+
+    /// @brief Select the policy that chooses the victims of a set, which is the only one whose events are counted
+    /// @param set_idx The index of the set
+    /// @return The index of the policy (0 for A, 1 for B)
+    inline uint32_t selectPolicy(uint32_t set_idx) {
+        uint32_t policy = roles[set_idx] == DUEL_FOLLOWER ? psel >> (DUEL_PSEL_BITS - 1) : roles[set_idx] - DUEL_LEADER_A;
+        views[policy].counting = true;
+        views[!policy].counting = false;
+        return policy;
+    }
+};
@@ -1,28 +1,57 @@
 /// @file fifo.cc
 /// @brief Implementation of the FIFO replacement policy
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "checkpoint.h"
 #include "fifo.h"
 
 ADD_REPLACER_TO_CMD_LINE(FIFO);
 
 FIFO::FIFO(CacheABC& cache, uint32_t num_sets, uint32_t assoc)
     : ReplacementPolicy(cache, num_sets, assoc) {
-    up_next = new uint32_t[num_sets]{};
+    age = new uint32_t[num_sets * assoc]{};
 }
 FIFO::~FIFO() {
-    delete[] up_next;
+    delete[] age;
 }
 
 uint32_t FIFO::getVictim(uint32_t set_idx) {
-    uint32_t next = up_next[set_idx];
-    up_next[set_idx] = (up_next[set_idx] + 1) % assoc;
-    return next;
+    // The first of the oldest lines, which is way 0 while the set is empty
+    uint32_t* set = &age[set_idx * assoc];
+    uint32_t max_idx = 0;
+    for (uint32_t i = 1; i < assoc; i++)
+        if (set[i] > set[max_idx]) max_idx = i;
+    notifyReplaced(set_idx, max_idx);
+    return max_idx;
+}
+
+void FIFO::notifyReplaced(uint32_t set_idx, uint32_t way_idx) {
+    uint32_t* set = &age[set_idx * assoc];
+    uint32_t line_age = set[way_idx];
+    for (uint32_t i = 0; i < assoc; i++)
+        if (set[i] <= line_age) set[i]++;
+    set[way_idx] = 0;
 }
 
 void FIFO::printState(uint32_t set_idx) {
+    // The ways from the next to evict to the last filled
     if (set_idx >= num_sets) return;
-    uint32_t next = up_next[set_idx];
-    std::cout << next;
+    uint32_t* set = &age[set_idx * assoc];
+    std::vector<uint32_t> ways(assoc);
+    std::iota(ways.begin(), ways.end(), 0);
+    std::stable_sort(ways.begin(), ways.end(), [set](uint32_t a, uint32_t b) { return set[a] > set[b]; });
+    std::cout << ways[0];
     for (uint32_t i = 1; i < assoc; i++)
-        std::cout << ' ' << (next + i) % assoc;
+        std::cout << ' ' << ways[i];
+}
+
+void FIFO::checkpoint(std::ostream& out) {
+    writeArray(out, age, num_sets * assoc);
+}
+
+void FIFO::restore(std::istream& in) {
+    readArray(in, age, num_sets * assoc);
 }
@@ -5,7 +5,11 @@
 
 #include "replacement_policy.h"
 
-/// @brief The FIFO replacement policy
+/// @brief The FIFO replacement policy, which evicts the line filled the longest ago
+///
+/// Each line has an age counted in fills of its set, so that a fill the policy did not choose (see notifyReplaced)
+/// still moves the line to the back of the queue. Lines are evicted in the order they were filled, whether they are
+/// valid or not, so an empty set is filled from its first way to its last
 class FIFO : public ReplacementPolicy {
 public:
 
@@ -21,12 +25,24 @@ public:
     /// @return The chosen line's index within the set (0 to assoc-1)
     uint32_t getVictim(uint32_t set_idx);
 
+    /// @brief Notify the replacement policy that a line is replaced, which moves it to the back of the queue
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    void notifyReplaced(uint32_t set_idx, uint32_t way_idx);
+
     /// @brief Print out the replacer's internal state
     /// @param set_idx The index of the set
     void printState(uint32_t set_idx);
 
+    /// @brief Write the line ages to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the line ages from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
 private:
 
-    /// @brief The index of the next line to evict
-    uint32_t* up_next;
+    /// @brief Line age, in set fills since the line was filled ('assoc' consecutive entries per set)
+    uint32_t* age;
 };
@@ -0,0 +1,83 @@
+/// @file lfru.cc
+/// @brief Implementation of the least frequently recently used replacement policy
+
+#include "checkpoint.h"
+#include "lfru.h"
+
+ADD_REPLACER_TO_CMD_LINE(LFRU);
+
+LFRU::LFRU(CacheABC& cache, uint32_t num_sets, uint32_t assoc)
+    : ReplacementPolicy(cache, num_sets, assoc), privileged_ways(assoc / 2) {
+    lines = new lfru_line[num_sets * assoc]{};
+}
+LFRU::~LFRU() {
+    delete[] lines;
+}
+
+uint32_t LFRU::getVictim(uint32_t set_idx) {
+    lfru_line* set = &lines[set_idx * assoc];
+    // The privileged partition is at most half the set, so a full set always has an unprivileged line
+    uint32_t victim = assoc;
+    for (uint32_t i = 0; i < assoc; i++) {
+        if (!cache.getLineState(set_idx, i)) {
+            victim = i;
+            break;
+        }
+        if (set[i].privileged) continue;
+        if (victim == assoc || set[i].count < set[victim].count ||
+            (set[i].count == set[victim].count && set[i].age > set[victim].age))
+            victim = i;
+    }
+    notifyReplaced(set_idx, victim);
+    return victim;
+}
+
+void LFRU::notifyReplaced(uint32_t set_idx, uint32_t way_idx) {
+    // The way is filled next, which the touch that follows tells apart from a hit by the cleared counter
+    lines[set_idx * assoc + way_idx].count = 0;
+    lines[set_idx * assoc + way_idx].privileged = false;
+}
+
+void LFRU::touch(uint32_t set_idx, uint32_t way_idx) {
+    lfru_line* set = &lines[set_idx * assoc];
+    lfru_line& line = set[way_idx];
+    if (line.count && !line.privileged && privileged_ways) {
+        // Make room in the privileged partition by demoting its least recently used line
+        uint32_t n_privileged = 0, lru_idx = assoc;
+        for (uint32_t i = 0; i < assoc; i++) {
+            if (!set[i].privileged) continue;
+            n_privileged++;
+            if (lru_idx == assoc || set[i].age > set[lru_idx].age) lru_idx = i;
+        }
+        if (n_privileged == privileged_ways) set[lru_idx].privileged = false;
+        line.privileged = true;
+    }
+
+    if (line.count == LFU_COUNTER_MAX) {
+        for (uint32_t i = 0; i < assoc; i++) set[i].count = (set[i].count + 1) >> 1;
+        cache.addStatistic(CounterAging);
+    }
+    line.count++;
+
+    uint32_t line_age = line.age;
+    for (uint32_t i = 0; i < assoc; i++)
+        if (set[i].age <= line_age) set[i].age++;
+    line.age = 0;
+}
+
+void LFRU::printState(uint32_t set_idx) {
+    if (set_idx >= num_sets) return;
+    lfru_line* set = &lines[set_idx * assoc];
+    for (uint32_t i = 0; i < assoc; i++) {
+        if (i) std::cout << ' ';
+        std::cout << (uint32_t)set[i].count << (set[i].privileged ? "*" : "");
+    }
+}
+
+void LFRU::checkpoint(std::ostream& out) {
+    writeArray(out, lines, num_sets * assoc);
+}
+
+void LFRU::restore(std::istream& in) {
+    readArray(in, lines, num_sets * assoc);
+}
@@ -0,0 +1,71 @@
+/// @file lfru.h
+/// @brief Declaration of the least frequently recently used replacement policy
+
+#pragma once
+
+#include "lfu.h"
+
+/// @brief The LFRU replacement policy, which splits each set into a privileged partition managed by LRU and an
+/// unprivileged partition managed by LFU
+///
+/// A line is filled into the unprivileged partition, and moves to the privileged partition when it is accessed again,
+/// which demotes the least recently used privileged line once the privileged partition is full. Only unprivileged
+/// lines are evicted, so lines that are reused stay in the cache while a scan goes through the unprivileged partition.
+/// The access counters saturate and age as in LFU
+class LFRU : public ReplacementPolicy {
+public:
+
+    /// @brief Construct a new LFRU replacement policy
+    /// @param cache The parent cache
+    /// @param num_sets The number of sets in the cache
+    /// @param assoc The associativity of the chace
+    LFRU(CacheABC& cache, uint32_t num_sets, uint32_t assoc);
+    ~LFRU();
+
+    /// @brief Determine which line of a range of lines to replace
+    /// @param set_idx The index of the set to choose from
+    /// @return The chosen line's index within the set (0 to assoc-1)
+    uint32_t getVictim(uint32_t set_idx);
+
+    /// @brief Notify the replacement policy that a line was just accessed
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    void touch(uint32_t set_idx, uint32_t way_idx);
+
+    /// @brief Notify the replacement policy that a line is replaced, which clears its counter and partition
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    void notifyReplaced(uint32_t set_idx, uint32_t way_idx);
+
+    /// @brief Determine whether touching the line touched last again leaves the replacer's state unchanged
+    /// @return False, since each access counts towards the line's frequency
+    bool isRepeatTouchIdempotent() { return false; }
+
+    /// @brief Print out the replacer's internal state
+    /// @param set_idx The index of the set
+    void printState(uint32_t set_idx);
+
+    /// @brief Write the line counters, ages and partitions to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the line counters, ages and partitions from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
+private:
+
+    /// @brief The replacer state of a line
+    struct lfru_line {
+        /// @brief Line age, in set accesses since last line access
+        uint32_t age;
+        /// @brief The number of accesses since the line was filled, halved by each aging (0 until it is filled)
+        uint8_t count;
+        /// @brief Whether the line is in the privileged partition
+        bool privileged;
+    };
+
+    /// @brief The state of each line ('assoc' consecutive entries per set)
+    lfru_line* lines;
+    /// @brief The number of lines of the privileged partition of each set (half the set)
+    uint32_t privileged_ways;
+};
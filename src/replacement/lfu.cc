@@ -0,0 +1,66 @@
+/// @file lfu.cc
+/// @brief Implementation of the least frequently used replacement policy
+
+#include "checkpoint.h"
+#include "lfu.h"
+
+ADD_REPLACER_TO_CMD_LINE(LFU);
+
+LFU::LFU(CacheABC& cache, uint32_t num_sets, uint32_t assoc)
+    : ReplacementPolicy(cache, num_sets, assoc) {
+    lines = new lfu_line[num_sets * assoc]{};
+}
+LFU::~LFU() {
+    delete[] lines;
+}
+
+uint32_t LFU::getVictim(uint32_t set_idx) {
+    lfu_line* set = &lines[set_idx * assoc];
+    uint32_t victim = 0;
+    for (uint32_t i = 0; i < assoc; i++) {
+        if (!cache.getLineState(set_idx, i)) {
+            victim = i;
+            break;
+        }
+        if (set[i].count < set[victim].count || (set[i].count == set[victim].count && set[i].age > set[victim].age))
+            victim = i;
+    }
+    notifyReplaced(set_idx, victim);
+    return victim;
+}
+
+void LFU::notifyReplaced(uint32_t set_idx, uint32_t way_idx) {
+    // The way is filled next, which the touch that follows tells apart from a hit by the cleared counter
+    lines[set_idx * assoc + way_idx].count = 0;
+}
+
+void LFU::touch(uint32_t set_idx, uint32_t way_idx) {
+    lfu_line* set = &lines[set_idx * assoc];
+    lfu_line& line = set[way_idx];
+    if (line.count == LFU_COUNTER_MAX) {
+        for (uint32_t i = 0; i < assoc; i++) set[i].count = (set[i].count + 1) >> 1;
+        cache.addStatistic(CounterAging);
+    }
+    line.count++;
+
+    uint32_t line_age = line.age;
+    for (uint32_t i = 0; i < assoc; i++)
+        if (set[i].age <= line_age) set[i].age++;
+    line.age = 0;
+}
+
+void LFU::printState(uint32_t set_idx) {
+    if (set_idx >= num_sets) return;
+    lfu_line* set = &lines[set_idx * assoc];
+    std::cout << (uint32_t)set[0].count;
+    for (uint32_t i = 1; i < assoc; i++)
+        std::cout << ' ' << (uint32_t)set[i].count;
+}
+
+void LFU::checkpoint(std::ostream& out) {
+    writeArray(out, lines, num_sets * assoc);
+}
+
+void LFU::restore(std::istream& in) {
+    readArray(in, lines, num_sets * assoc);
+}
@@ -0,0 +1,70 @@
+/// @file lfu.h
+/// @brief Declaration of the least frequently used replacement policy
+
+#pragma once
+
+#include "replacement_policy.h"
+
+#ifndef LFU_COUNTER_MAX
+/// @brief The value at which the access counters of the LFU and LFRU replacers saturate (at most 255)
+#define LFU_COUNTER_MAX 15
+#endif
+
+/// @brief The LFU replacement policy, which evicts the line accessed the fewest times since it was filled (the least
+/// recently used of those on a tie)
+///
+/// Each line has a saturating access counter. A touch of a line whose counter is saturated ages the set instead,
+/// halving every counter of the set, so that lines that were hot long ago do not stay in the cache forever
+class LFU : public ReplacementPolicy {
+public:
+
+    /// @brief Construct a new LFU replacement policy
+    /// @param cache The parent cache
+    /// @param num_sets The number of sets in the cache
+    /// @param assoc The associativity of the chace
+    LFU(CacheABC& cache, uint32_t num_sets, uint32_t assoc);
+    ~LFU();
+
+    /// @brief Determine which line of a range of lines to replace
+    /// @param set_idx The index of the set to choose from
+    /// @return The chosen line's index within the set (0 to assoc-1)
+    uint32_t getVictim(uint32_t set_idx);
+
+    /// @brief Notify the replacement policy that a line was just accessed
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    void touch(uint32_t set_idx, uint32_t way_idx);
+
+    /// @brief Notify the replacement policy that a line is replaced, which clears its counter
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    void notifyReplaced(uint32_t set_idx, uint32_t way_idx);
+
+    /// @brief Determine whether touching the line touched last again leaves the replacer's state unchanged
+    /// @return False, since each access counts towards the line's frequency
+    bool isRepeatTouchIdempotent() { return false; }
+
+    /// @brief Print out the replacer's internal state
+    /// @param set_idx The index of the set
+    void printState(uint32_t set_idx);
+
+    /// @brief Write the line counters and ages to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the line counters and ages from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
+private:
+
+    /// @brief The replacer state of a line
+    struct lfu_line {
+        /// @brief Line age, in set accesses since last line access
+        uint32_t age;
+        /// @brief The number of accesses since the line was filled, halved by each aging (0 until it is filled)
+        uint8_t count;
+    };
+
+    /// @brief The state of each line ('assoc' consecutive entries per set)
+    lfu_line* lines;
+};
@@ -1,24 +1,21 @@
 /// @file lru.cc
 /// @brief Implementation of the least recently used replacement policy
 
+#include "checkpoint.h"
 #include "lru.h"
 
 ADD_REPLACER_TO_CMD_LINE(LRU);
 
 LRU::LRU(CacheABC& cache, uint32_t num_sets, uint32_t assoc)
     : ReplacementPolicy(cache, num_sets, assoc) {
-    age = new uint32_t * [num_sets];
-    for (uint32_t i = 0; i < num_sets; i++)
-        age[i] = new uint32_t[assoc]{};
+    age = new uint32_t[num_sets * assoc]{};
 }
 LRU::~LRU() {
-    for (uint32_t i = 0; i < num_sets; i++)
-        delete[] age[i];
     delete[] age;
 }
 
 uint32_t LRU::getVictim(uint32_t set_idx) {
-    uint32_t* set = age[set_idx];
+    uint32_t* set = &age[set_idx * assoc];
     uint32_t max_idx = 0, max = 0;
     for (uint32_t i = 0; i < assoc; i++) {
         if (!cache.getLineState(set_idx, i)) return i;
@@ -31,7 +28,7 @@ uint32_t LRU::getVictim(uint32_t set_idx) {
 }
 
 void LRU::touch(uint32_t set_idx, uint32_t way_idx) {
-    uint32_t* set = age[set_idx];
+    uint32_t* set = &age[set_idx * assoc];
     uint32_t line_age = set[way_idx];
     for (uint32_t i = 0; i < assoc; i++)
         if (set[i] <= line_age) set[i]++;
@@ -40,8 +37,16 @@ void LRU::touch(uint32_t set_idx, uint32_t way_idx) {
 
 void LRU::printState(uint32_t set_idx) {
     if (set_idx >= num_sets) return;
-    uint32_t* set = age[set_idx];
+    uint32_t* set = &age[set_idx * assoc];
     std::cout << set[0];
     for (uint32_t i = 1; i < assoc; i++)
         std::cout << ' ' << set[i];
 }
+
+void LRU::checkpoint(std::ostream& out) {
+    writeArray(out, age, num_sets * assoc);
+}
+
+void LRU::restore(std::istream& in) {
+    readArray(in, age, num_sets * assoc);
+}
@@ -30,8 +30,15 @@ public:
     /// @param set_idx The index of the set
     void printState(uint32_t set_idx);
 
+    /// @brief Write the line ages to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the line ages from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
 private:
 
-    /// @brief Line age, in set accesses since last line access
-    uint32_t** age;
+    /// @brief Line age, in set accesses since last line access ('assoc' consecutive entries per set)
+    uint32_t* age;
 };
@@ -0,0 +1,47 @@
+/// @file opt.cc
+/// @brief Implementation of the optimal (Belady) replacement policy
+
+#include "checkpoint.h"
+#include "opt.h"
+
+ADD_REPLACER_TO_CMD_LINE(OPT);
+
+OPT::OPT(CacheABC& cache, uint32_t num_sets, uint32_t assoc)
+    : ReplacementPolicy(cache, num_sets, assoc) {
+    next_use = new uint64_t[num_sets * assoc]{};
+}
+OPT::~OPT() {
+    delete[] next_use;
+}
+
+uint32_t OPT::getVictim(uint32_t set_idx) {
+    uint64_t* set = &next_use[set_idx * assoc];
+    uint32_t max_idx = 0;
+    for (uint32_t i = 0; i < assoc; i++) {
+        if (!cache.getLineState(set_idx, i)) return i;
+        if (set[i] > set[max_idx]) max_idx = i;
+    }
+    return max_idx;
+}
+
+void OPT::touch(uint32_t set_idx, uint32_t way_idx) {
+    next_use[set_idx * assoc + way_idx] = cache.getNextUse();
+}
+
+void OPT::printState(uint32_t set_idx) {
+    if (set_idx >= num_sets) return;
+    uint64_t* set = &next_use[set_idx * assoc];
+    for (uint32_t i = 0; i < assoc; i++) {
+        if (i) std::cout << ' ';
+        if (set[i] == UINT64_MAX) std::cout << '-';
+        else std::cout << set[i];
+    }
+}
+
+void OPT::checkpoint(std::ostream& out) {
+    writeArray(out, next_use, num_sets * assoc);
+}
+
+void OPT::restore(std::istream& in) {
+    readArray(in, next_use, num_sets * assoc);
+}
@@ -0,0 +1,51 @@
+/// @file opt.h
+/// @brief Declaration of the optimal (Belady) replacement policy
+
+#pragma once
+
+#include "replacement_policy.h"
+
+/// @brief The OPT replacement policy, which evicts the line whose next access is furthest in the future
+/// @note The next accesses come from the next use index of the trace (see NextUseIndex), so OPT is an upper bound on
+/// the hit rate of any replacement policy rather than a realizable one
+class OPT : public ReplacementPolicy {
+public:
+
+    /// @brief Construct a new OPT replacement policy
+    /// @param cache The parent cache
+    /// @param num_sets The number of sets in the cache
+    /// @param assoc The associativity of the chace
+    OPT(CacheABC& cache, uint32_t num_sets, uint32_t assoc);
+    ~OPT();
+
+    /// @brief Determine which line of a range of lines to replace
+    /// @param set_idx The index of the set to choose from
+    /// @return The chosen line's index within the set (0 to assoc-1)
+    uint32_t getVictim(uint32_t set_idx);
+
+    /// @brief Notify the replacement policy that a line was just accessed
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    void touch(uint32_t set_idx, uint32_t way_idx);
+
+    /// @brief Determine whether touching the line touched last again leaves the replacer's state unchanged
+    /// @return False, since each access moves the next use of the line
+    bool isRepeatTouchIdempotent() { return false; }
+
+    /// @brief Print out the replacer's internal state
+    /// @param set_idx The index of the set
+    void printState(uint32_t set_idx);
+
+    /// @brief Write the next uses to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the next uses from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
+private:
+
+    /// @brief The trace record index of the next access to each line ('assoc' consecutive entries per set, UINT64_MAX
+    /// for never)
+    uint64_t* next_use;
+};
@@ -27,10 +27,34 @@ public:
     /// @param way_idx The index of the way containing the line (0 to assoc-1)
     virtual void touch(uint32_t set_idx, uint32_t way_idx) {}
 
+    /// @brief Notify the replacement policy that a line is replaced by a victim it was not asked for (when another
+    /// policy chooses the victims of the set, see Duel), so that it can update its state as getVictim would
+    /// @param set_idx The index of the set containing the line
+    /// @param way_idx The index of the way containing the line (0 to assoc-1)
+    virtual void notifyReplaced(uint32_t set_idx, uint32_t way_idx) {}
+
+    /// @brief Determine whether touching the line touched last again leaves the replacer's state unchanged, which
+    /// lets the cache coalesce repeated accesses to a line (see Cache::receivePrRd)
+    /// @return True if a repeated touch has no effect
+    virtual bool isRepeatTouchIdempotent() { return true; }
+
     /// @brief Print out the replacer's internal state
     /// @param set_idx The index of the set
     virtual void printState(uint32_t set_idx) {}
 
+    /// @brief Count the sets by the regime an adaptive replacer runs them in
+    /// @param recency_sets The number of sets that favor recency
+    /// @param frequency_sets The number of sets that favor frequency
+    /// @note Both stay 0 for replacers that do not adapt
+    virtual void countSetRegimes(size_t& recency_sets, size_t& frequency_sets) {}
+
+    /// @brief Write the replacer's internal state (if any) to a checkpoint
+    /// @param out The checkpoint stream
+    virtual void checkpoint(std::ostream& out) {}
+    /// @brief Restore the replacer's internal state (if any) from a checkpoint
+    /// @param in The checkpoint stream
+    virtual void restore(std::istream& in) {}
+
 protected:
 
     /// @brief The parent cache
@@ -1,17 +1,44 @@
 /// @file rr.cc
 /// @brief Implementation of the random replacement policy
 
-#include <cstdlib>
-
+#include "checkpoint.h"
 #include "rr.h"
 
 ADD_REPLACER_TO_CMD_LINE(RR);
 
+/// @brief The SplitMix64 finalizer, which turns consecutive inputs into independent pseudo-random outputs
+/// @param x The input
+/// @return The hash of the input
+static inline uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
 RR::RR(CacheABC& cache, uint32_t num_sets, uint32_t assoc)
-    : ReplacementPolicy(cache, num_sets, assoc) {
-    std::srand(num_sets * assoc);
+    : ReplacementPolicy(cache, num_sets, assoc), seed(mix64(cache.getRandomSeed())) {
+    draws = new uint32_t[num_sets]{};
+}
+RR::~RR() {
+    delete[] draws;
 }
 
 uint32_t RR::getVictim(uint32_t set_idx) {
-    return std::rand() % assoc;
+    // The counter of the set selects the draw, spaced by the golden ratio as in SplitMix64
+    uint64_t random = mix64(seed + ((uint64_t)set_idx << 32 | draws[set_idx]++) * 0x9E3779B97F4A7C15ull);
+    // Scale to the associativity with a multiplication rather than a division
+    return ((unsigned __int128)random * assoc) >> 64;
+}
+
+void RR::printState(uint32_t set_idx) {
+    if (set_idx >= num_sets) return;
+    std::cout << draws[set_idx];
+}
+
+void RR::checkpoint(std::ostream& out) {
+    writeArray(out, draws, num_sets);
+}
+
+void RR::restore(std::istream& in) {
+    readArray(in, draws, num_sets);
 }
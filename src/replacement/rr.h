@@ -6,6 +6,10 @@
 #include "replacement_policy.h"
 
 /// @brief The RR replacement policy
+///
+/// The victims are drawn from a counter-based generator: the n-th victim of a set is a hash of the cache's seed, the
+/// set index and n. So the choices in a set do not depend on the order of the evictions in the other sets, and the
+/// results are the same however the caches are spread over threads
 class RR : public ReplacementPolicy {
 public:
 
@@ -14,9 +18,28 @@ public:
     /// @param num_sets The number of sets in the cache
     /// @param assoc The associativity of the chace
     RR(CacheABC& cache, uint32_t num_sets, uint32_t assoc);
+    ~RR();
 
     /// @brief Determine which line of a range of lines to replace
     /// @param set_idx The index of the set to choose from
     /// @return The chosen line's index within the set (0 to assoc-1)
     uint32_t getVictim(uint32_t set_idx);
+
+    /// @brief Print out the replacer's internal state
+    /// @param set_idx The index of the set
+    void printState(uint32_t set_idx);
+
+    /// @brief Write the number of victims drawn in each set to a checkpoint
+    /// @param out The checkpoint stream
+    void checkpoint(std::ostream& out);
+    /// @brief Restore the number of victims drawn in each set from a checkpoint
+    /// @param in The checkpoint stream
+    void restore(std::istream& in);
+
+private:
+
+    /// @brief The seed of the generator, mixed from the seed of the cache
+    uint64_t seed;
+    /// @brief The number of victims drawn in each set
+    uint32_t* draws;
 };
@@ -0,0 +1,227 @@
+/// @file results_sink.cc
+/// @brief Implementation of the ResultsSink class
+///
+/// Binary output format (all values little endian):
+/// - Magic number: the 8 characters "CSIMRSLT"
+/// - Format version (uint32_t): 1
+/// - Number of columns (uint32_t)
+/// - Number of rows (uint64_t)
+/// - For each column: the column type (uint8_t: 0 = uint32_t, 1 = double, 2 = uint64_t), followed by the
+///   length of the column name (uint8_t) and the column name (not null terminated)
+/// - For each column, in the same order: the value of every row
+///
+/// The columns are those of the CSV output, in the same order
+
+#include <algorithm>
+#include <charconv>
+
+#include "results_sink.h"
+#include "results_store.h"
+
+/// @brief The version of the binary output format
+#define RESULTS_BIN_VERSION 1
+/// @brief Enough characters for the longest CSV row
+#define MAX_ROW_CHARS (NUM_COLUMNS * 21)
+
+/// @brief Column types of the binary output format
+enum column_type_e {
+    COLUMN_U32,
+    COLUMN_F64,
+    COLUMN_U64
+};
+
+const char* const stat_names[NUM_COLUMNS] = {
+    "config", "core", "miss rate",
+    "processor reads", "processor writes",
+    "bus reads", "bus readxs", "bus updates", "bus upgrades", "bus writes",
+    "read misses", "write misses",
+    "line flushes", "line fetches", "c2c transfers", "write backs", "memory writes",
+    "evictions",
+    "exclusions", "interventions", "invalidations",
+    "compulsory misses", "capacity misses", "conflict misses", "coherence misses",
+    "redundant responders avoided",
+    "migratory predictions", "correct migratory predictions",
+    "snoop filter probes", "snoop lookups avoided", "snoop filter false positives",
+    "recency ghost hits", "frequency ghost hits", "counter agings", "recency sets", "frequency sets"
+};
+
+/// @brief The block of rows being built by the current thread
+static thread_local results_block* current_block = nullptr;
+
+/// @brief Compute the miss rate of a cache
+/// @param statistics The cache's runtime statistics
+/// @return The miss rate
+template<typename T>
+static inline double missRate(const T* statistics) {
+    return ((double)statistics[ReadMiss] + (double)statistics[WriteMiss]) / ((double)statistics[ProcRead] + (double)statistics[ProcWrite]);
+}
+
+ResultsSink::ResultsSink(output_format_e format, std::ostream& out) : format(format), out(out), head(nullptr) {
+    // The header is written before any row can arrive
+    if (format == FORMAT_CSV) {
+        out << stat_names[0];
+        for (uint32_t i = 1; i < NUM_COLUMNS; i++) out << ',' << stat_names[i];
+        out << '\n';
+    }
+    writer = std::thread(&ResultsSink::drain, this);
+}
+
+ResultsSink::~ResultsSink() {
+    submit();
+    push(&end_of_output);
+    writer.join();
+    if (format == FORMAT_BIN) writeColumns();
+    else if (format == FORMAT_COL) writeStore();
+    out.flush();
+}
+
+void ResultsSink::addRow(const cache_config& config, uint32_t cache_id, const size_t* statistics) {
+    if (!current_block) current_block = new results_block();
+    uint32_t config_id = config.id;
+
+    if (format != FORMAT_CSV) {
+        if (format == FORMAT_COL && (current_block->configs.empty() || current_block->configs.back().id != config_id))
+            current_block->configs.push_back(config);
+        current_block->config_ids.push_back(config_id);
+        current_block->cache_ids.push_back(cache_id);
+        current_block->statistics.insert(current_block->statistics.end(), statistics, statistics + N_STATISTICS);
+        return;
+    }
+
+    // Format the row straight into the block's text
+    std::string& text = current_block->text;
+    size_t length = text.size();
+    text.resize(length + MAX_ROW_CHARS);
+    char* first = text.data() + length;
+    char* last = text.data() + text.size();
+    first = std::to_chars(first, last, config_id).ptr;
+    *first++ = ',';
+    first = std::to_chars(first, last, cache_id).ptr;
+    *first++ = ',';
+    first = std::to_chars(first, last, missRate(statistics), std::chars_format::general, 6).ptr; // Same as std::ostream
+    for (uint32_t i = 0; i < N_STATISTICS; i++) {
+        *first++ = ',';
+        first = std::to_chars(first, last, statistics[i]).ptr;
+    }
+    *first++ = '\n';
+    text.resize(first - text.data());
+}
+
+void ResultsSink::submit() {
+    if (!current_block) return;
+    push(current_block);
+    current_block = nullptr;
+}
+
+void ResultsSink::push(results_block* block) {
+    block->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed));
+    head.notify_one();
+}
+
+void ResultsSink::drain() {
+    while (true) {
+        // Sleep until a block arrives, then take every queued block at once
+        head.wait(nullptr, std::memory_order_acquire);
+        results_block* block = head.exchange(nullptr, std::memory_order_acquire);
+
+        // The queue is a stack, so reverse it to write the blocks in the order they were submitted
+        results_block* ordered = nullptr;
+        while (block) {
+            results_block* next = block->next;
+            block->next = ordered;
+            ordered = block;
+            block = next;
+        }
+
+        // Write each block (the end of output block is always the last one submitted)
+        while (ordered) {
+            if (ordered == &end_of_output) return;
+            block = ordered->next;
+            write(ordered);
+            delete ordered;
+            ordered = block;
+        }
+    }
+}
+
+void ResultsSink::write(results_block* block) {
+    if (format == FORMAT_CSV) {
+        out.write(block->text.data(), block->text.size());
+        return;
+    }
+    for (cache_config& config : block->configs) configs.try_emplace(config.id, config);
+    columns.config_ids.insert(columns.config_ids.end(), block->config_ids.begin(), block->config_ids.end());
+    columns.cache_ids.insert(columns.cache_ids.end(), block->cache_ids.begin(), block->cache_ids.end());
+    columns.statistics.insert(columns.statistics.end(), block->statistics.begin(), block->statistics.end());
+}
+
+void ResultsSink::writeColumns() {
+    uint64_t n_rows = columns.config_ids.size();
+
+    // Header
+    out.write("CSIMRSLT", 8);
+    writeLE<uint32_t>(out, RESULTS_BIN_VERSION);
+    writeLE<uint32_t>(out, NUM_COLUMNS);
+    writeLE<uint64_t>(out, n_rows);
+    for (uint32_t i = 0; i < NUM_COLUMNS; i++) {
+        writeLE<uint8_t>(out, i < 2 ? COLUMN_U32 : i == 2 ? COLUMN_F64 : COLUMN_U64);
+        writeLE<uint8_t>(out, strlen(stat_names[i]));
+        out << stat_names[i];
+    }
+
+    // Columns
+    for (uint32_t id : columns.config_ids) writeLE<uint32_t>(out, id);
+    for (uint32_t id : columns.cache_ids) writeLE<uint32_t>(out, id);
+    for (uint64_t row = 0; row < n_rows; row++) {
+        double miss_rate = missRate(&columns.statistics[row * N_STATISTICS]);
+        uint64_t bits;
+        memcpy(&bits, &miss_rate, sizeof(bits));
+        writeLE<uint64_t>(out, bits);
+    }
+    for (uint32_t i = 0; i < N_STATISTICS; i++)
+        for (uint64_t row = 0; row < n_rows; row++) writeLE<uint64_t>(out, columns.statistics[row * N_STATISTICS + i]);
+}
+
+void ResultsSink::writeStore() {
+    uint64_t n_rows = columns.config_ids.size();
+
+    // Sort the rows by configuration and core, so that neighbouring values are similar
+    std::vector<uint64_t> order(n_rows);
+    for (uint64_t row = 0; row < n_rows; row++) order[row] = row;
+    std::sort(order.begin(), order.end(), [this](uint64_t a, uint64_t b) {
+        return std::make_pair(columns.config_ids[a], columns.cache_ids[a]) < std::make_pair(columns.config_ids[b], columns.cache_ids[b]);
+        });
+
+    // The CSV columns (except the miss rate, which is derived from the others), followed by the configuration
+    std::vector<std::string> names = { stat_names[0], stat_names[1] };
+    std::vector<column_encoding_e> encodings(N_STATISTICS + 2, ENCODING_INTEGER);
+    for (uint32_t i = 0; i < N_STATISTICS; i++) names.push_back(stat_names[i + 3]);
+    for (const char* name : { "cache size", "line size", "associativity", "coherence", "replacer", "directory" }) {
+        names.push_back(name);
+        encodings.push_back(ENCODING_DICTIONARY);
+    }
+    writeStoreHeader(out, n_rows, names, encodings);
+
+    std::vector<uint64_t> values(n_rows);
+    for (uint64_t row = 0; row < n_rows; row++) values[row] = columns.config_ids[order[row]];
+    writeIntegerColumn(out, values);
+    for (uint64_t row = 0; row < n_rows; row++) values[row] = columns.cache_ids[order[row]];
+    writeIntegerColumn(out, values);
+    for (uint32_t i = 0; i < N_STATISTICS; i++) {
+        for (uint64_t row = 0; row < n_rows; row++) values[row] = columns.statistics[order[row] * N_STATISTICS + i];
+        writeIntegerColumn(out, values);
+    }
+
+    std::vector<std::string> strings(n_rows);
+    auto writeConfigColumn = [&](auto field) {
+        for (uint64_t row = 0; row < n_rows; row++) strings[row] = field(configs[columns.config_ids[order[row]]]);
+        writeDictionaryColumn(out, strings);
+        };
+    writeConfigColumn([](cache_config& config) { return std::to_string(config.cache_size); });
+    writeConfigColumn([](cache_config& config) { return std::to_string(config.line_size); });
+    writeConfigColumn([](cache_config& config) { return std::to_string(config.assoc); });
+    writeConfigColumn([](cache_config& config) { return config.coherence; });
+    writeConfigColumn([](cache_config& config) { return config.replacer; });
+    writeConfigColumn([](cache_config& config) { return config.directory; });
+}
@@ -0,0 +1,94 @@
+/// @file results_sink.h
+/// @brief Declaration of the ResultsSink class
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "typedefs.h"
+
+/// @brief The number of columns that appear in the output statistics
+#define NUM_COLUMNS (N_STATISTICS + 3)
+
+/// @brief Output-friendly names for cache runtime statistics. Make sure these match up with 'bus_msg_e' and 'statistic_e'
+extern const char* const stat_names[NUM_COLUMNS];
+
+/// @brief A batch of output rows submitted to the results sink by one thread
+struct results_block {
+    /// @brief The next block in the queue
+    results_block* next;
+    /// @brief The rows formatted as CSV (CSV output only)
+    std::string text;
+    /// @brief The configuration of the rows, once per configuration (columnar output only)
+    std::vector<cache_config> configs;
+    /// @brief The config ID of each row (binary output only)
+    std::vector<uint32_t> config_ids;
+    /// @brief The cache ID of each row (binary output only)
+    std::vector<uint32_t> cache_ids;
+    /// @brief The statistics of each row, N_STATISTICS values per row (binary output only)
+    std::vector<uint64_t> statistics;
+};
+
+/// @brief Collects the statistics of every cache and writes them to the output from a dedicated writer thread
+///
+/// Rows are added to a thread-local block, which is handed to the writer thread through a lock-free
+/// multi-producer single-consumer queue when the thread calls 'submit'. Worker threads therefore never
+/// wait on each other or on the output stream
+class ResultsSink {
+public:
+
+    /// @brief Construct a new results sink and start its writer thread
+    /// @param format The output format
+    /// @param out The output stream
+    ResultsSink(output_format_e format, std::ostream& out);
+    /// @brief Write any remaining output and stop the writer thread
+    ~ResultsSink();
+
+    /// @brief Add a row of statistics to the current thread's block
+    /// @param config The configuration of the memory system
+    /// @param cache_id The ID of the cache
+    /// @param statistics The cache's runtime statistics (N_STATISTICS values)
+    void addRow(const cache_config& config, uint32_t cache_id, const size_t* statistics);
+
+    /// @brief Hand the current thread's block of rows to the writer thread
+    void submit();
+
+private:
+
+    /// @brief The output format
+    output_format_e format;
+    /// @brief The output stream
+    std::ostream& out;
+    /// @brief The most recently submitted block (the queue is a stack, reversed by the writer thread)
+    std::atomic<results_block*> head;
+    /// @brief The writer thread
+    std::thread writer;
+
+    /// @brief Columns of the binary and columnar output, accumulated until the sink is destroyed
+    results_block columns;
+    /// @brief The configuration of every memory system in the columnar output
+    std::map<uint32_t, cache_config> configs;
+    /// @brief Marks the end of the output when pushed onto the queue
+    results_block end_of_output;
+
+    /// @brief Push a block onto the queue
+    /// @param block The block to hand to the writer thread
+    void push(results_block* block);
+
+    /// @brief Writer thread task: drain the queue until the end of output block arrives
+    void drain();
+
+    /// @brief Write a block to the output
+    /// @param block The block to write
+    void write(results_block* block);
+
+    /// @brief Write the accumulated columns in the binary format
+    void writeColumns();
+
+    /// @brief Write the accumulated columns in the compressed columnar format (see results_store.h)
+    void writeStore();
+};
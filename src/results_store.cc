@@ -0,0 +1,140 @@
+/// @file results_store.cc
+/// @brief Implementation of the compressed columnar results store encoder and decoder
+
+#include <map>
+
+#include "results_store.h"
+
+/// @brief The version of the results store format
+#define STORE_VERSION 2
+
+/// @brief Write a length-prefixed string to a stream
+/// @param out The output stream
+/// @param str The string to write
+static inline void writeString(std::ostream& out, const std::string& str) {
+    writeLE<uint32_t>(out, str.size());
+    out.write(str.data(), str.size());
+}
+
+/// @brief Read a length-prefixed string from a stream
+/// @param in The input stream
+/// @return The string read
+static inline std::string readString(std::istream& in) {
+    std::string str(readLE<uint32_t>(in), '\0');
+    in.read(str.data(), str.size());
+    return str;
+}
+
+void writeStoreHeader(std::ostream& out, uint64_t n_rows, const std::vector<std::string>& names, const std::vector<column_encoding_e>& encodings) {
+    out.write("CSIMRCOL", 8);
+    writeLE<uint32_t>(out, STORE_VERSION);
+    writeLE<uint32_t>(out, names.size());
+    writeLE<uint64_t>(out, n_rows);
+    for (uint32_t i = 0; i < names.size(); i++) {
+        writeLE<uint8_t>(out, encodings[i]);
+        writeString(out, names[i]);
+    }
+}
+
+void writeIntegerColumn(std::ostream& out, const std::vector<uint64_t>& values) {
+    uint64_t prev = 0;
+    uint64_t zigzag[STORE_BLOCK_LEN];
+    uint64_t words[STORE_BLOCK_LEN];
+    for (size_t block = 0; block < values.size(); block += STORE_BLOCK_LEN) {
+        uint32_t n = std::min<size_t>(STORE_BLOCK_LEN, values.size() - block);
+
+        // Zigzag encode the differences, so small negative differences also need few bits
+        uint64_t all_bits = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            uint64_t delta = values[block + i] - prev;
+            zigzag[i] = (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+            all_bits |= zigzag[i];
+            prev = values[block + i];
+        }
+        uint32_t width = all_bits ? 64 - __builtin_clzll(all_bits) : 0;
+
+        // Bitpack the differences
+        uint32_t n_words = (n * width + 63) / 64;
+        memset(words, 0, n_words * sizeof(uint64_t));
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t bit = i * width;
+            words[bit / 64] |= zigzag[i] << bit % 64;
+            if (bit % 64 + width > 64) words[bit / 64 + 1] |= zigzag[i] >> (64 - bit % 64);
+        }
+
+        writeLE<uint8_t>(out, width);
+        for (uint32_t i = 0; i < n_words; i++) writeLE<uint64_t>(out, words[i]);
+    }
+}
+
+void writeDictionaryColumn(std::ostream& out, const std::vector<std::string>& values) {
+    // Assign indices in order of first appearance
+    std::map<std::string, uint64_t> index_of;
+    std::vector<uint64_t> indices;
+    indices.reserve(values.size());
+    for (const std::string& value : values)
+        indices.push_back(index_of.try_emplace(value, index_of.size()).first->second);
+
+    std::vector<const std::string*> dictionary(index_of.size());
+    for (auto& [value, index] : index_of) dictionary[index] = &value;
+    writeLE<uint32_t>(out, dictionary.size());
+    for (const std::string* value : dictionary) writeString(out, *value);
+    writeIntegerColumn(out, indices);
+}
+
+/// @brief Read and decode a delta + bitpacking encoded integer column
+/// @param in The input stream
+/// @param n_rows The number of rows in the column
+/// @param values The vector to contain the value of each row
+/// @return False if the column is malformed
+static bool readIntegerColumn(std::istream& in, uint64_t n_rows, std::vector<uint64_t>& values) {
+    uint64_t prev = 0;
+    uint64_t words[STORE_BLOCK_LEN];
+    values.resize(n_rows);
+    for (uint64_t block = 0; block < n_rows; block += STORE_BLOCK_LEN) {
+        uint32_t n = std::min<uint64_t>(STORE_BLOCK_LEN, n_rows - block);
+        uint32_t width = readLE<uint8_t>(in);
+        if (width > 64) return false;
+        uint32_t n_words = (n * width + 63) / 64;
+        for (uint32_t i = 0; i < n_words; i++) words[i] = readLE<uint64_t>(in);
+
+        uint64_t mask = width == 64 ? ~0ull : (1ull << width) - 1;
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t bit = i * width;
+            uint64_t zigzag = width ? words[bit / 64] >> bit % 64 : 0;
+            if (bit % 64 + width > 64) zigzag |= words[bit / 64 + 1] << (64 - bit % 64);
+            zigzag &= mask;
+            prev += (zigzag >> 1) ^ -(zigzag & 1);
+            values[block + i] = prev;
+        }
+    }
+    return (bool)in;
+}
+
+int64_t readStore(std::istream& in, std::vector<store_column>& columns) {
+    // Header
+    char magic[8] = { 0 };
+    in.read(magic, sizeof(magic));
+    if (memcmp(magic, "CSIMRCOL", sizeof(magic)) || readLE<uint32_t>(in) != STORE_VERSION) return -1;
+    uint32_t n_columns = readLE<uint32_t>(in);
+    uint64_t n_rows = readLE<uint64_t>(in);
+    columns.resize(n_columns);
+    for (store_column& column : columns) {
+        column.encoding = (column_encoding_e)readLE<uint8_t>(in);
+        column.name = readString(in);
+        if (column.encoding != ENCODING_INTEGER && column.encoding != ENCODING_DICTIONARY) return -1;
+    }
+
+    // Columns
+    for (store_column& column : columns) {
+        if (column.encoding == ENCODING_DICTIONARY) {
+            column.dictionary.resize(readLE<uint32_t>(in));
+            for (std::string& value : column.dictionary) value = readString(in);
+        }
+        if (!readIntegerColumn(in, n_rows, column.values)) return -1;
+        if (column.encoding == ENCODING_DICTIONARY)
+            for (uint64_t index : column.values)
+                if (index >= column.dictionary.size()) return -1;
+    }
+    return n_rows;
+}
@@ -0,0 +1,105 @@
+/// @file results_store.h
+/// @brief Declaration of the compressed columnar results store encoder and decoder
+///
+/// Store format (all values little endian):
+/// - Magic number: the 8 characters "CSIMRCOL"
+/// - Format version (uint32_t): 2
+/// - Number of columns (uint32_t)
+/// - Number of rows (uint64_t)
+/// - For each column: the column encoding (uint8_t, see 'column_encoding_e'), followed by the length of
+///   the column name (uint32_t) and the column name (not null terminated)
+/// - For each column, in the same order, the encoded column:
+///   - Integer columns are split into blocks of 'STORE_BLOCK_LEN' rows (the last block may be shorter).
+///     Each value is stored as the zigzag encoded difference to the previous value (the first previous
+///     value being 0). Every block starts with the bit width of its widest difference (uint8_t), followed
+///     by the differences bitpacked into ceil(rows * width / 64) uint64_t words, least significant bit first
+///   - Dictionary columns start with the number of distinct values (uint32_t), followed by each value
+///     as its length (uint32_t) and characters. The dictionary index of each row follows as an integer column
+
+#pragma once
+
+#include <endian.h>
+#include <string>
+#include <vector>
+
+#include "typedefs.h"
+
+/// @brief The number of rows in each bitpacked block of an integer column
+#define STORE_BLOCK_LEN 128
+
+/// @brief Column encodings of the results store
+enum column_encoding_e {
+    /// @brief Delta + bitpacking encoded unsigned integers
+    ENCODING_INTEGER,
+    /// @brief Dictionary encoded strings
+    ENCODING_DICTIONARY
+};
+
+/// @brief A decoded column of the results store
+struct store_column {
+    /// @brief The name of the column
+    std::string name;
+    /// @brief The encoding of the column
+    column_encoding_e encoding;
+    /// @brief The value of each row (the dictionary index of each row for dictionary columns)
+    std::vector<uint64_t> values;
+    /// @brief The distinct values of a dictionary column
+    std::vector<std::string> dictionary;
+};
+
+/// @brief Write a little endian value to a stream
+/// @param out The output stream
+/// @param value The value to write
+template<typename T>
+inline void writeLE(std::ostream& out, T value) {
+    if constexpr (sizeof(T) == 1) out.put(value);
+    else if constexpr (sizeof(T) == 4) {
+        uint32_t le = htole32(value);
+        out.write((char*)&le, sizeof(le));
+    }
+    else {
+        uint64_t le = htole64(value);
+        out.write((char*)&le, sizeof(le));
+    }
+}
+
+/// @brief Read a little endian value from a stream
+/// @param in The input stream
+/// @return The value read (0 past the end of the stream)
+template<typename T>
+inline T readLE(std::istream& in) {
+    if constexpr (sizeof(T) == 1) return in.get();
+    else if constexpr (sizeof(T) == 4) {
+        uint32_t le = 0;
+        in.read((char*)&le, sizeof(le));
+        return le32toh(le);
+    }
+    else {
+        uint64_t le = 0;
+        in.read((char*)&le, sizeof(le));
+        return le64toh(le);
+    }
+}
+
+/// @brief Write the header of a results store
+/// @param out The output stream
+/// @param n_rows The number of rows in the store
+/// @param names The name of each column
+/// @param encodings The encoding of each column
+void writeStoreHeader(std::ostream& out, uint64_t n_rows, const std::vector<std::string>& names, const std::vector<column_encoding_e>& encodings);
+
+/// @brief Write a delta + bitpacking encoded integer column
+/// @param out The output stream
+/// @param values The value of each row
+void writeIntegerColumn(std::ostream& out, const std::vector<uint64_t>& values);
+
+/// @brief Write a dictionary encoded column
+/// @param out The output stream
+/// @param values The value of each row
+void writeDictionaryColumn(std::ostream& out, const std::vector<std::string>& values);
+
+/// @brief Read and decode an entire results store
+/// @param in The input stream
+/// @param columns The vector to contain the decoded columns
+/// @return The number of rows, or -1 if the input is not a valid results store
+int64_t readStore(std::istream& in, std::vector<store_column>& columns);
@@ -3,146 +3,442 @@
 
 #include <barrier>
 #include <csignal>
-#include <fstream>
-#include <mutex>
 #include <thread>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
+#include "checkpoint.h"
+#include "instrumentation.h"
 #include "main.h"
 #include "memory_system.h"
+#include "next_use.h"
+#include "results_sink.h"
+#include "sharing_map.h"
+#include "trace_reader.h"
 #include "interactive_mode_coherence.h"
 #include "interactive_mode_replacer.h"
+#include "duel.h"
+#include "table_protocol.h"
 
 /// @brief The number of traces to buffer at a time
 #define N_TRACE_BUF 1000000
 
-void runBatchMetrics(int argc, char* argv[]) {
-    // Configurations vector
-    std::vector<cache_config> configs;
-    readConfigurations(configs, argv[ARG_CONFIG]);
+/// @brief Create the memory system of each configuration, restoring their state if a run is being resumed
+/// @tparam A The address type of the trace
+/// @param configs The configurations
+/// @param trace_reader The trace reader, which is moved past the records processed before the checkpoint
+/// @param memory_systems The vector to contain the memory systems
+/// @param arg_trace_file The index of the trace file argument
+/// @return The number of trace records processed before the checkpoint (0 if not resuming)
+template<typename A>
+static uint64_t createMemorySystems(std::vector<cache_config>& configs, TraceReader& trace_reader, std::vector<MemorySystem<A>*>& memory_systems, uint32_t arg_trace_file) {
+    for (cache_config& config : configs)
+        memory_systems.push_back((*directory_map)[config.directory].create<A>(config, trace_reader.n_cores));
+    if (!options.resume_file) return 0;
 
-    // Get trace file, trace limit, and trace file buffers
-    std::ifstream trace_file;
-    size_t trace_limit = getTrace(argc, argv, trace_file, ARG_M_COUNT);
+    uint64_t trace_offset;
+    std::string error = readCheckpoint(options.resume_file, trace_reader, configs, memory_systems, trace_offset);
+    if (!error.empty()) {
+        std::cerr << error << std::endl;
+        exit(-1);
+    }
+    exitIf(!trace_reader.skip(trace_offset), "Malformed trace file", 0, arg_trace_file);
+    return trace_offset;
+}
+
+/// @brief Enable the private line fast path of every memory system if the option is set, classifying the lines of
+/// the trace with a pre-pass unless the sharing file of the trace is up to date
+/// @tparam A The address type of the trace
+/// @param sharing_map The sharing map to load (which must outlive the memory systems)
+/// @param configs The configurations
+/// @param memory_systems The memory system of each configuration
+/// @param trace_file The path to the trace file
+/// @param arg_trace_file The index of the trace file argument
+template<typename A>
+static void enablePrivateLines(SharingMap<A>& sharing_map, std::vector<cache_config>& configs, std::vector<MemorySystem<A>*>& memory_systems, const char* trace_file, uint32_t arg_trace_file) {
+    if (!options.private_lines) return;
+    std::vector<uint32_t> line_sizes;
+    for (cache_config& config : configs)
+        if (std::find(line_sizes.begin(), line_sizes.end(), config.line_size) == line_sizes.end()) line_sizes.push_back(config.line_size);
+    std::string error = sharing_map.load(trace_file, line_sizes);
+    exitIf(!error.empty(), error, 0, arg_trace_file);
+    for (uint32_t i = 0; i < configs.size(); i++) memory_systems[i]->shared_lines = sharing_map.getSharedLines(configs[i].line_size);
+}
+
+/// @brief Map the next use index of the trace for the memory systems whose caches use the OPT replacer, computing it
+/// with a backward pass over the trace unless the next use files of the trace are up to date
+/// @tparam A The address type of the trace
+/// @param next_use_index The next use index to load (which must outlive the memory systems)
+/// @param configs The configurations
+/// @param memory_systems The memory system of each configuration
+/// @param trace_file The path to the trace file
+/// @param arg_trace_file The index of the trace file argument
+/// @param force Whether every memory system needs the index (e.g. when a variant forked from it uses OPT)
+template<typename A>
+static void enableNextUse(NextUseIndex<A>& next_use_index, std::vector<cache_config>& configs, std::vector<MemorySystem<A>*>& memory_systems, const char* trace_file, uint32_t arg_trace_file, bool force = false) {
+    std::vector<uint32_t> line_sizes;
+    for (cache_config& config : configs)
+        if ((force || needsNextUse(config)) && std::find(line_sizes.begin(), line_sizes.end(), config.line_size) == line_sizes.end())
+            line_sizes.push_back(config.line_size);
+    if (line_sizes.empty()) return;
+    std::string error = next_use_index.load(trace_file, line_sizes);
+    exitIf(!error.empty(), error, 0, arg_trace_file);
+    for (uint32_t i = 0; i < configs.size(); i++)
+        if (force || needsNextUse(configs[i])) memory_systems[i]->next_use = next_use_index.getDistances(configs[i].line_size);
+}
+
+/// @brief Write a checkpoint if checkpoints are enabled and one is due
+/// @tparam A The address type of the trace
+/// @param n_chunks The number of trace chunks processed so far
+/// @param configs The configurations
+/// @param trace_reader The trace reader
+/// @param memory_systems The memory systems, which must not be processing traces
+/// @param trace_offset The number of trace records processed by every memory system
+template<typename A>
+static void checkpointIfDue(size_t n_chunks, std::vector<cache_config>& configs, TraceReader& trace_reader, std::vector<MemorySystem<A>*>& memory_systems, uint64_t trace_offset) {
+    if (!options.checkpoint_file || n_chunks % options.checkpoint_interval) return;
+    // A failed checkpoint only loses the ability to resume, so the run carries on
+    std::string error = writeCheckpoint(options.checkpoint_file, trace_reader, configs, memory_systems, trace_offset);
+    if (!error.empty()) std::cerr << error << std::endl;
+}
+
+/// @brief Process the trace with every configuration, each in its own thread
+/// @tparam A The address type of the trace
+/// @param configs The configurations
+/// @param trace_reader The trace reader
+/// @param trace_file The path to the trace file
+/// @param trace_limit The maximum number of trace entries to process (0 for no limit)
+template<typename A>
+static void batchMetrics(std::vector<cache_config>& configs, TraceReader& trace_reader, const char* trace_file, size_t trace_limit) {
+    // Create (or restore) the memory systems
+    std::vector<MemorySystem<A>*> memory_systems;
+    uint64_t trace_offset = createMemorySystems(configs, trace_reader, memory_systems, ARG_M_TRACE_FILE);
+    SharingMap<A> sharing_map;
+    enablePrivateLines(sharing_map, configs, memory_systems, trace_file, ARG_M_TRACE_FILE);
+    NextUseIndex<A> next_use_index;
+    enableNextUse(next_use_index, configs, memory_systems, trace_file, ARG_M_TRACE_FILE);
 
     // The trace file chunks will be "double buffered" to allow for simultaneous reading and processing
-    trace_t* trace_swap = new trace_t[N_TRACE_BUF];
-    trace_t* trace_buf = new trace_t[N_TRACE_BUF];
-    uint32_t bytes_read;
+    trace_entry<A>* trace_swap = new trace_entry<A>[N_TRACE_BUF];
+    trace_entry<A>* trace_buf = new trace_entry<A>[N_TRACE_BUF];
+    size_t swap_count;
+    size_t trace_count;
+    size_t n_chunks = 0;
 
     // Setup synchronization objects
     auto sync_point_task = [&]() {
+        // Every worker is waiting here, so the memory systems can be checkpointed
+        trace_offset += trace_count;
+        checkpointIfDue(++n_chunks, configs, trace_reader, memory_systems, trace_offset);
+
         // Switch to the new chunk
         std::swap(trace_buf, trace_swap);
-        bytes_read = trace_file.gcount();
+        trace_count = swap_count;
         };
     std::barrier sync_point(configs.size() + 1, sync_point_task);
-    std::mutex stats_print_mutex;
+    ResultsSink results_sink(options.output_format, std::cout);
 
     // Set up worker threads
-    auto batch_metrics_task = [&](cache_config config) {
-        // Create memory system
-        MemorySystem* memory_system = (*directory_map)[config.directory](config);
+    auto batch_metrics_task = [&](MemorySystem<A>* memory_system, uint32_t config_id) {
+        INSTRUMENT_THREAD("config " + std::to_string(config_id));
 
         // Process each block as it arrives
-        size_t line_count = 0;
-        while (bytes_read) {
-            uint32_t trace_count = bytes_read / 5;
-            // Execute traces in current block
-            for (uint32_t i = 0; i < trace_count; i++) {
-                uint8_t op = trace_buf[i].op;
-                addr_t addr = trace_buf[i].addr;
-                if (op & 1) memory_system->issuePrWr(le32toh(addr), op >> 1
-#ifdef WRITE_TIMESTAMP
-                    , line_count
-#endif
-                );
-                else memory_system->issuePrRd(le32toh(addr), op >> 1
-#ifdef WRITE_TIMESTAMP
-                    , line_count
-#endif
-                );
-                line_count++;
-
-                // Exit the while loop if trace limit is reached
-                if (trace_limit && line_count == trace_limit) goto print_stats;
+        size_t line_count = trace_offset;
+        while (trace_count) {
+            {
+                INSTRUMENT_PHASE(PHASE_CONFIG_PROCESSING);
+                // Execute traces in current block
+                for (size_t i = 0; i < trace_count; i++) {
+                    trace_entry<A>& entry = trace_buf[i];
+                    if (entry.write) memory_system->issuePrWr(entry.addr, entry.cache_id, line_count);
+                    else memory_system->issuePrRd(entry.addr, entry.cache_id, line_count);
+                    line_count++;
+
+                    // Exit the while loop if trace limit is reached
+                    if (trace_limit && line_count == trace_limit) goto print_stats;
+                }
             }
 
             // Wait for the next block to be read in
+            INSTRUMENT_PHASE(PHASE_BARRIER_WAIT);
             sync_point.arrive_and_wait();
         }
 
-        // Print statistics (Note the mutex is automatically released as part of the implicit destructor call)
+        // Hand the statistics to the results sink
     print_stats:
-        std::lock_guard guard(stats_print_mutex);
-        memory_system->printStats();
+        memory_system->printStats(results_sink);
+        results_sink.submit();
         };
     std::vector<std::thread> workers;
     workers.reserve(configs.size());
 
-    // Read first chunk
-    trace_file.read((char*)trace_buf, N_TRACE_BUF * sizeof(trace_t));
-    bytes_read = trace_file.gcount();
+    // Read first chunk (nothing is left to process if the run was resumed past the trace limit)
+    INSTRUMENT_THREAD("reader");
+    {
+        INSTRUMENT_PHASE(PHASE_TRACE_READ);
+        trace_count = trace_limit && trace_offset >= trace_limit ? 0 : trace_reader.read(trace_buf, N_TRACE_BUF);
+        exitIf(trace_reader.isMalformed(), "Malformed trace file", 0, ARG_M_TRACE_FILE);
+    }
 
     // Start each worker thread
-    printStatsHeader(); // Ensure CSV header prints first
-    for (cache_config& config : configs)
-        workers.emplace_back(batch_metrics_task, config);
+    for (uint32_t i = 0; i < configs.size(); i++)
+        workers.emplace_back(batch_metrics_task, memory_systems[i], configs[i].id);
 
     // Read each subsequent chunk while the worker threads process the current one
-    size_t line_count = bytes_read / 5;
-    while (bytes_read && !(trace_limit && line_count >= trace_limit)) {
-        trace_file.read((char*)trace_swap, N_TRACE_BUF * sizeof(trace_t));
+    size_t line_count = trace_offset + trace_count;
+    while (trace_count && !(trace_limit && line_count >= trace_limit)) {
+        {
+            INSTRUMENT_PHASE(PHASE_TRACE_READ);
+            swap_count = trace_reader.read(trace_swap, N_TRACE_BUF);
+            exitIf(trace_reader.isMalformed(), "Malformed trace file", 0, ARG_M_TRACE_FILE);
+        }
+        INSTRUMENT_PHASE(PHASE_BARRIER_WAIT);
         sync_point.arrive_and_wait();
-        line_count += bytes_read / 5;
+        line_count += trace_count;
     }
 
     // Wait for worker threads
     for (std::thread& worker : workers)
         worker.join();
+    INSTRUMENT_REPORT();
 
     // Cleanup
+    for (MemorySystem<A>* memory_system : memory_systems)
+        delete memory_system;
     delete[] trace_buf;
     delete[] trace_swap;
 }
 
+void runBatchMetrics(int argc, char* argv[]) {
+    if (options.variants_file) {
+        std::cerr << "Forking variants requires a single configuration" << std::endl;
+        exit(-1);
+    }
+
+    // Configurations vector
+    std::vector<cache_config> configs;
+    readConfigurations(configs, argv[ARG_CONFIG]);
+
+    // Get trace file and trace limit
+    TraceReader trace_reader;
+    size_t trace_limit = getTrace(argc, argv, trace_reader, ARG_M_COUNT);
+
+    // The address width of the trace selects the memory system types
+    if (trace_reader.addr_width == sizeof(uint64_t)) batchMetrics<uint64_t>(configs, trace_reader, argv[ARG_M_TRACE_FILE], trace_limit);
+    else batchMetrics<uint32_t>(configs, trace_reader, argv[ARG_M_TRACE_FILE], trace_limit);
+}
+
+/// @brief Read the next chunk of the trace and process it with a memory system
+/// @tparam A The address type of the trace
+/// @param memory_system The memory system
+/// @param trace_reader The trace reader
+/// @param trace_buf The buffer to read the chunk into (N_TRACE_BUF entries)
+/// @param line_count The number of trace entries processed so far, advanced past the chunk
+/// @param trace_limit The maximum number of trace entries to process (0 for no limit)
+/// @param arg_trace_file The index of the trace file argument
+/// @return The number of trace entries processed (0 at the end of the trace or at the trace limit)
+template<typename A>
+static size_t processChunk(MemorySystem<A>* memory_system, TraceReader& trace_reader, trace_entry<A>* trace_buf, size_t& line_count, size_t trace_limit, uint32_t arg_trace_file) {
+    if (trace_limit && line_count >= trace_limit) return 0;
+    size_t trace_count;
+    {
+        INSTRUMENT_PHASE(PHASE_TRACE_READ);
+        trace_count = trace_reader.read(trace_buf, trace_limit ? std::min<size_t>(N_TRACE_BUF, trace_limit - line_count) : N_TRACE_BUF);
+        exitIf(trace_reader.isMalformed(), "Malformed trace file", 0, arg_trace_file);
+    }
+
+    INSTRUMENT_PHASE(PHASE_CONFIG_PROCESSING);
+    for (size_t i = 0; i < trace_count; i++, line_count++) {
+        trace_entry<A>& entry = trace_buf[i];
+        if (entry.write) memory_system->issuePrWr(entry.addr, entry.cache_id, line_count);
+        else memory_system->issuePrRd(entry.addr, entry.cache_id, line_count);
+    }
+    return trace_count;
+}
+
+/// @brief Process the trace with a single configuration
+/// @tparam A The address type of the trace
+/// @param config The configuration
+/// @param trace_reader The trace reader
+/// @param trace_file The path to the trace file
+/// @param trace_limit The maximum number of trace entries to process (0 for no limit)
+template<typename A>
+static void singleMetrics(cache_config& config, TraceReader& trace_reader, const char* trace_file, size_t trace_limit) {
+    // Create (or restore) the memory system
+    std::vector<cache_config> configs = { config };
+    std::vector<MemorySystem<A>*> memory_systems;
+    size_t line_count = createMemorySystems(configs, trace_reader, memory_systems, ARG_S_TRACE_FILE);
+    MemorySystem<A>* memory_system = memory_systems[0];
+    SharingMap<A> sharing_map;
+    enablePrivateLines(sharing_map, configs, memory_systems, trace_file, ARG_S_TRACE_FILE);
+    NextUseIndex<A> next_use_index;
+    enableNextUse(next_use_index, configs, memory_systems, trace_file, ARG_S_TRACE_FILE);
+
+    // Execute traces, one chunk at a time
+    INSTRUMENT_THREAD("main");
+    trace_entry<A>* trace_buf = new trace_entry<A>[N_TRACE_BUF];
+    for (size_t n_chunks = 1; processChunk(memory_system, trace_reader, trace_buf, line_count, trace_limit, ARG_S_TRACE_FILE); n_chunks++)
+        checkpointIfDue(n_chunks, configs, trace_reader, memory_systems, line_count);
+
+    // Print statistics
+    {
+        ResultsSink results_sink(options.output_format, std::cout);
+        memory_system->printStats(results_sink);
+    }
+    INSTRUMENT_REPORT();
+
+    // Cleanup
+    delete[] trace_buf;
+    delete memory_system;
+}
+
+/// @brief Process the trace with a single configuration up to the fork point, then fork a process for each
+/// variant, which continues from the simulated state while this process continues with the single configuration
+///
+/// The forked processes share the memory of the simulated state copy-on-write, so the prefix of the trace is
+/// simulated once however many variants there are, and only the lines each variant changes are copied.
+/// Each variant hands its statistics back through a shared memory mapping
+/// @tparam A The address type of the trace
+/// @param config The configuration
+/// @param variants The variants to fork
+/// @param trace_reader The trace reader
+/// @param trace_file The path to the trace file
+/// @param trace_limit The maximum number of trace entries to process (0 for no limit), including the prefix
+template<typename A>
+static void forkMetrics(cache_config& config, std::vector<fork_variant>& variants, TraceReader& trace_reader, const char* trace_file, size_t trace_limit) {
+    MemorySystem<A>* memory_system = (*directory_map)[config.directory].create<A>(config, trace_reader.n_cores);
+    uint32_t n_caches = trace_reader.n_cores;
+    std::vector<cache_config> configs = { config };
+    std::vector<MemorySystem<A>*> memory_systems = { memory_system };
+    SharingMap<A> sharing_map;
+    enablePrivateLines(sharing_map, configs, memory_systems, trace_file, ARG_S_TRACE_FILE);
+    NextUseIndex<A> next_use_index;
+    bool variants_use_opt = std::any_of(variants.begin(), variants.end(), [](fork_variant& variant) { return needsNextUse(variant.config); });
+    enableNextUse(next_use_index, configs, memory_systems, trace_file, ARG_S_TRACE_FILE, variants_use_opt);
+
+    // Simulate the shared prefix once
+    INSTRUMENT_THREAD("main");
+    trace_entry<A>* trace_buf = new trace_entry<A>[N_TRACE_BUF];
+    size_t line_count = 0;
+    size_t fork_at = trace_limit ? std::min<size_t>(trace_limit, options.fork_at) : options.fork_at;
+    while (processChunk(memory_system, trace_reader, trace_buf, line_count, fork_at, ARG_S_TRACE_FILE));
+
+    // Every variant must be able to take over the simulated state
+    for (fork_variant& variant : variants) {
+        std::string error = memory_system->checkCoherenceSwitch(variant.config.coherence);
+        exitIf(!error.empty(), error, variant.config.id, ARG_COHERENCE);
+        exitIf(variant.tail_trace.empty() && !trace_reader.isSeekable(), "Variants can only continue a trace that can be opened again", 0, ARG_S_TRACE_FILE);
+    }
+
+    // Each variant writes its statistics to its own 'n_caches' rows of the shared mapping
+    size_t stats_size = std::max<size_t>(variants.size() * n_caches * N_STATISTICS * sizeof(size_t), 1);
+    size_t* variant_stats = (size_t*)mmap(nullptr, stats_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (variant_stats == MAP_FAILED) {
+        std::cerr << "Shared memory error: " << std::strerror(errno) << std::endl;
+        exit(-1);
+    }
+
+    // Fork the variants
+    std::vector<pid_t> pids;
+    std::cout.flush();
+    for (uint32_t v = 0; v < variants.size(); v++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "Fork error: " << std::strerror(errno) << std::endl;
+            exit(-1);
+        }
+        if (pid) {
+            pids.push_back(pid);
+            continue;
+        }
+
+        // The trace file is opened again, since the file offset of the open trace is shared with this process
+        fork_variant& variant = variants[v];
+        memory_system->reconfigure(variant.config.coherence, variant.config.replacer);
+        // Only the lines of the trace were classified, and a line private to one core there may be shared in a tail trace
+        if (!variant.tail_trace.empty()) memory_system->shared_lines = nullptr;
+        TraceReader tail_reader;
+        std::string tf_error = tail_reader.open(variant.tail_trace.empty() ? trace_file : variant.tail_trace.c_str());
+        exitIf(!tf_error.empty(), tf_error, variant.config.id, ARG_S_TRACE_FILE);
+        if (variant.tail_trace.empty()) exitIf(!tail_reader.skip(line_count), "Malformed trace file", 0, ARG_S_TRACE_FILE);
+
+        // Process the rest of the trace (or the tail trace) and hand the statistics back
+        while (processChunk(memory_system, tail_reader, trace_buf, line_count, trace_limit, ARG_S_TRACE_FILE));
+        memory_system->copyStats(&variant_stats[(size_t)v * n_caches * N_STATISTICS]);
+        _exit(0);
+    }
+
+    // Continue with the single configuration while the variants run
+    while (processChunk(memory_system, trace_reader, trace_buf, line_count, trace_limit, ARG_S_TRACE_FILE));
+
+    // Wait for every variant (a variant that failed has already reported why)
+    int exit_code = 0;
+    for (uint32_t v = 0; v < variants.size(); v++) {
+        int status;
+        waitpid(pids[v], &status, 0);
+        if (exit_code) continue;
+        if (WIFEXITED(status)) exit_code = WEXITSTATUS(status);
+        else {
+            std::cerr << "Variant " << variants[v].config.id << " was terminated by signal " << WTERMSIG(status) << std::endl;
+            exit_code = -1;
+        }
+    }
+    if (exit_code) exit(exit_code);
+
+    // Print statistics (the single configuration is config 0, and each variant is numbered by its line in the variants file)
+    {
+        ResultsSink results_sink(options.output_format, std::cout);
+        memory_system->printStats(results_sink);
+        for (uint32_t v = 0; v < variants.size(); v++)
+            for (uint32_t i = 0; i < n_caches; i++) {
+                const size_t* statistics = &variant_stats[((size_t)v * n_caches + i) * N_STATISTICS];
+                if (statistics[ProcRead] + statistics[ProcWrite]) results_sink.addRow(variants[v].config, i, statistics);
+            }
+    }
+    INSTRUMENT_REPORT();
+
+    // Cleanup
+    munmap(variant_stats, stats_size);
+    delete[] trace_buf;
+    delete memory_system;
+}
+
 void runSingleMetrics(int argc, char* argv[]) {
     // Get configuration
     cache_config config = { 0 };
     getConfig(argc, argv, config);
 
     // Get trace file and limit
-    std::ifstream trace_file;
-    size_t trace_limit = getTrace(argc, argv, trace_file, ARG_S_COUNT);
-
-    // Create memory system
-    MemorySystem* memory_system = (*directory_map)[config.directory](config);
-
-    // Execute traces
-    addr_t addr;
-    uint8_t op;
-    for (size_t line_count = 0; !(trace_file.eof() || (trace_limit && line_count == trace_limit)); line_count++) {
-        trace_file.read((char*)&op, sizeof(op));
-        trace_file.read((char*)&addr, sizeof(addr));
-        if (op & 1) memory_system->issuePrWr(le32toh(addr), op >> 1
-#ifdef WRITE_TIMESTAMP
-            , line_count
-#endif
-        );
-        else memory_system->issuePrRd(le32toh(addr), op >> 1
-#ifdef WRITE_TIMESTAMP
-            , line_count
-#endif
-        );
+    TraceReader trace_reader;
+    size_t trace_limit = getTrace(argc, argv, trace_reader, ARG_S_COUNT);
+
+    // Fork the variants, if any, from the configuration's simulated state
+    if (options.variants_file) {
+        if (options.checkpoint_file || options.resume_file) {
+            std::cerr << "Forking variants cannot be combined with checkpoints" << std::endl;
+            exit(-1);
+        }
+        std::vector<fork_variant> variants;
+        readVariants(variants, options.variants_file, config, trace_reader);
+        if (trace_reader.addr_width == sizeof(uint64_t)) forkMetrics<uint64_t>(config, variants, trace_reader, argv[ARG_S_TRACE_FILE], trace_limit);
+        else forkMetrics<uint32_t>(config, variants, trace_reader, argv[ARG_S_TRACE_FILE], trace_limit);
+        return;
     }
 
-    // Print statistics
-    printStatsHeader();
-    memory_system->printStats();
+    // The address width of the trace selects the memory system types
+    if (trace_reader.addr_width == sizeof(uint64_t)) singleMetrics<uint64_t>(config, trace_reader, argv[ARG_S_TRACE_FILE], trace_limit);
+    else singleMetrics<uint32_t>(config, trace_reader, argv[ARG_S_TRACE_FILE], trace_limit);
 }
 
 void runInteractiveMode(char* name_of_showcased) {
     // Get the correct interactive mode class
     InteractiveMode* interactive_mode;
+    std::string spec_error = TableProtocol::registerSpec(name_of_showcased);
+    if (spec_error.empty()) spec_error = Duel::registerDuel(name_of_showcased);
+    if (!spec_error.empty()) {
+        std::cerr << ARG_INTERACTIVE << '@' << 0 << ": " << spec_error << std::endl;
+        exit(ARG_INTERACTIVE);
+    }
     if (coherence_map->count(name_of_showcased)) interactive_mode = new InteractiveModeCoherence(name_of_showcased);
     else if (replacement_map->count(name_of_showcased)) interactive_mode = new InteractiveModeReplacer(name_of_showcased);
     else {
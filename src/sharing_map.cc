@@ -0,0 +1,135 @@
+/// @file sharing_map.cc
+/// @brief Implementation of the SharingMap class
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "sharing_map.h"
+#include "trace_reader.h"
+
+/// @brief The version of the sharing file format
+#define SHARING_VERSION 1
+/// @brief The number of trace entries decoded at a time by the pre-pass
+#define N_SHARING_BUF 65536
+/// @brief The owner value of a line accessed by more than one core (owners are stored as the core ID + 1)
+#define OWNER_SHARED UINT16_MAX
+
+template<typename A>
+std::string SharingMap<A>::load(const char* trace_path, const std::vector<uint32_t>& line_sizes) {
+    // The sharing file is only used if it was written for the current version of the trace file
+    struct stat trace_stat;
+    if (stat(trace_path, &trace_stat) || !S_ISREG(trace_stat.st_mode))
+        return "The private line pre-pass needs a trace file that can be read again";
+    std::ostringstream header;
+    header.write("CSIMSHAR", 8);
+    writeValue<uint32_t>(header, SHARING_VERSION);
+    writeValue<uint32_t>(header, sizeof(A));
+    writeValue<uint64_t>(header, trace_stat.st_size);
+    writeValue<uint64_t>(header, trace_stat.st_mtim.tv_sec * 1000000000ull + trace_stat.st_mtim.tv_nsec);
+
+    std::string sharing_path = std::string(trace_path) + ".sharing";
+    if (readSharingFile(sharing_path, header.str(), line_sizes)) return "";
+
+    std::string error = classify(trace_path, line_sizes);
+    if (error.empty()) writeSharingFile(sharing_path, header.str());
+    return error;
+}
+
+template<typename A>
+bool SharingMap<A>::readSharingFile(const std::string& path, const std::string& header, const std::vector<uint32_t>& line_sizes) {
+    std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+    if (!in) return false;
+    std::string file_header(header.size(), '\0');
+    in.read(file_header.data(), file_header.size());
+    if (!in || file_header != header) return false;
+
+    uint32_t n_sizes = 0;
+    readValue(in, n_sizes);
+    std::vector<A> addrs;
+    for (uint32_t s = 0; s < n_sizes && in; s++) {
+        uint32_t line_size = 0;
+        uint64_t n_shared = 0;
+        readValue(in, line_size);
+        readValue(in, n_shared);
+        if (!in || n_shared > ((uint64_t)1 << 40)) {
+            in.setstate(std::ios_base::failbit);
+            break;
+        }
+        addrs.resize(n_shared);
+        readArray(in, addrs.data(), n_shared);
+        auto set = std::make_unique<FlatMap<A, uint8_t>>(n_shared);
+        bool inserted;
+        for (A addr : addrs) set->insert(addr, inserted) = 1;
+        shared_lines[line_size] = std::move(set);
+    }
+
+    // A malformed or incomplete sharing file is classified again
+    bool complete = (bool)in;
+    for (uint32_t line_size : line_sizes) complete &= shared_lines.count(line_size) > 0;
+    if (!complete) shared_lines.clear();
+    return complete;
+}
+
+template<typename A>
+void SharingMap<A>::writeSharingFile(const std::string& path, const std::string& header) {
+    // Write to a temporary file first, so that concurrent runs never read a partial sharing file
+    std::string temp_path = path + ".tmp";
+    std::ofstream out(temp_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!out) return;
+    out << header;
+    writeValue<uint32_t>(out, shared_lines.size());
+    std::vector<A> addrs;
+    for (auto& [line_size, set] : shared_lines) {
+        addrs.clear();
+        set->forEach([&addrs](A addr, uint8_t&) { addrs.push_back(addr); });
+        writeValue<uint32_t>(out, line_size);
+        writeValue<uint64_t>(out, addrs.size());
+        writeArray(out, addrs.data(), addrs.size());
+    }
+    out.close();
+    if (!out || std::rename(temp_path.c_str(), path.c_str())) std::remove(temp_path.c_str());
+}
+
+template<typename A>
+std::string SharingMap<A>::classify(const char* trace_path, const std::vector<uint32_t>& line_sizes) {
+    TraceReader trace_reader;
+    std::string error = trace_reader.open(trace_path);
+    if (!error.empty()) return error;
+
+    // Record the first core accessing each line, until a second core accesses it
+    std::vector<uint32_t> line_offsets;
+    std::vector<std::unique_ptr<FlatMap<A, uint16_t>>> owners;
+    for (uint32_t line_size : line_sizes) {
+        line_offsets.push_back(__builtin_ctz(line_size));
+        owners.push_back(std::make_unique<FlatMap<A, uint16_t>>());
+    }
+    std::vector<trace_entry<A>> trace_buf(N_SHARING_BUF);
+    while (size_t trace_count = trace_reader.read(trace_buf.data(), N_SHARING_BUF))
+        for (size_t s = 0; s < line_sizes.size(); s++) {
+            FlatMap<A, uint16_t>& owner_map = *owners[s];
+            uint32_t line_offset = line_offsets[s];
+            bool inserted;
+            for (size_t i = 0; i < trace_count; i++) {
+                uint16_t& owner = owner_map.insert(trace_buf[i].addr >> line_offset, inserted);
+                if (inserted) owner = trace_buf[i].cache_id + 1;
+                else if (owner != trace_buf[i].cache_id + 1) owner = OWNER_SHARED;
+            }
+        }
+    if (trace_reader.isMalformed()) return "Malformed trace file";
+
+    // Only the shared lines are kept, since a line missing from the set is private (or never accessed)
+    for (size_t s = 0; s < line_sizes.size(); s++) {
+        auto set = std::make_unique<FlatMap<A, uint8_t>>();
+        bool inserted;
+        owners[s]->forEach([&set, &inserted](A line_addr, uint16_t& owner) {
+            if (owner == OWNER_SHARED) set->insert(line_addr, inserted) = 1;
+            });
+        shared_lines[line_sizes[s]] = std::move(set);
+    }
+    return "";
+}
+
+template class SharingMap<uint32_t>;
+template class SharingMap<uint64_t>;
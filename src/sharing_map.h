@@ -0,0 +1,64 @@
+/// @file sharing_map.h
+/// @brief Declaration of the SharingMap class, which classifies the lines of a trace as private or shared
+///
+/// Sharing file format (native byte order, since it is a cache of the trace file on the machine that wrote it):
+/// - Magic number: the 8 characters "CSIMSHAR"
+/// - Format version (uint32_t): 1
+/// - Address width (uint32_t), and the size and modification time of the trace file (uint64_t each, the time in
+///   nanoseconds), which must match the trace file for the sharing file to be used
+/// - The number of line sizes (uint32_t), followed by each line size: the line size (uint32_t), the number of
+///   shared lines (uint64_t) and the line address of each shared line (address width bytes each)
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "flat_map.h"
+
+/// @brief The lines of a trace accessed by more than one core, for each line size
+///
+/// A line accessed by a single core over the whole trace is private: no other cache ever holds a copy of it, so
+/// bus messages for the line need not be delivered to the other caches. The lines are classified by a pre-pass over
+/// the trace, whose result is saved to a sharing file next to the trace file ('<trace_file>.sharing')
+/// @tparam A The address type
+template<typename A>
+class SharingMap {
+public:
+
+    /// @brief Load the shared lines from the sharing file of a trace, or else classify the lines of the trace and
+    /// write the sharing file
+    /// @param trace_path The path to the trace file (which must be a regular file)
+    /// @param line_sizes The line sizes to classify the lines for
+    /// @return An error message, or an empty string on success
+    /// @note Failing to write the sharing file is not an error, since the lines are already classified
+    std::string load(const char* trace_path, const std::vector<uint32_t>& line_sizes);
+
+    /// @brief Get the shared lines for a line size
+    /// @param line_size The line size (one of the loaded line sizes)
+    /// @return The set of the line addresses (address without the line offset) of the shared lines
+    FlatMap<A, uint8_t>* getSharedLines(uint32_t line_size) { return shared_lines.at(line_size).get(); }
+
+private:
+
+    /// @brief The set of shared lines for each line size
+    std::map<uint32_t, std::unique_ptr<FlatMap<A, uint8_t>>> shared_lines;
+
+    /// @brief Read the shared lines from a sharing file
+    /// @param path The path to the sharing file
+    /// @param header The expected header, identifying the trace file
+    /// @param line_sizes The line sizes that must be present
+    /// @return True if the sharing file is up to date and has every line size
+    bool readSharingFile(const std::string& path, const std::string& header, const std::vector<uint32_t>& line_sizes);
+    /// @brief Write the shared lines to a sharing file
+    /// @param path The path to the sharing file
+    /// @param header The header identifying the trace file
+    void writeSharingFile(const std::string& path, const std::string& header);
+
+    /// @brief Classify the lines of a trace with a pass over the whole trace
+    /// @param trace_path The path to the trace file
+    /// @param line_sizes The line sizes to classify the lines for
+    /// @return An error message, or an empty string on success
+    std::string classify(const char* trace_path, const std::vector<uint32_t>& line_sizes);
+};
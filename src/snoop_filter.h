@@ -0,0 +1,87 @@
+/// @file snoop_filter.h
+/// @brief Declaration and implementation of the SnoopFilter class
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#ifndef SNOOP_FILTER_COUNTERS_PER_LINE
+/// @brief The number of filter counters per cache line (rounded up to a power of 2)
+#define SNOOP_FILTER_COUNTERS_PER_LINE 4
+#endif
+
+/// @brief A counting Bloom filter of the lines a cache holds a valid copy of, which tells the bus that a snoop would
+/// certainly miss the cache
+/// @note Each line address increments two 8-bit counters. A counter that saturates is never decremented, so the filter
+/// can only err by letting a snoop through (a false positive)
+class SnoopFilter {
+public:
+
+    /// @brief Construct a new empty snoop filter
+    /// @param num_lines The number of lines in the cache
+    SnoopFilter(uint32_t num_lines) {
+        uint32_t bits = 1;
+        while ((1ull << bits) < (uint64_t)num_lines * SNOOP_FILTER_COUNTERS_PER_LINE) bits++;
+        shift = 64 - bits;
+        size = 1ull << bits;
+        counters = new uint8_t[size]();
+    }
+    ~SnoopFilter() { delete[] counters; }
+
+    SnoopFilter(const SnoopFilter&) = delete;
+    SnoopFilter& operator=(const SnoopFilter&) = delete;
+
+    /// @brief Check whether a line may be in the filter
+    /// @param line_addr The line address (address without the line offset)
+    /// @return False if the line is certainly not in the filter
+    inline bool mayContain(uint64_t line_addr) const {
+        return counters[hash1(line_addr)] && counters[hash2(line_addr)];
+    }
+
+    /// @brief Add a line to the filter
+    /// @param line_addr The line address (address without the line offset)
+    inline void insert(uint64_t line_addr) {
+        increment(counters[hash1(line_addr)]);
+        increment(counters[hash2(line_addr)]);
+    }
+
+    /// @brief Remove a line from the filter
+    /// @param line_addr The line address (address without the line offset)
+    /// @note The line must have been inserted before
+    inline void remove(uint64_t line_addr) {
+        decrement(counters[hash1(line_addr)]);
+        decrement(counters[hash2(line_addr)]);
+    }
+
+    /// @brief Remove every line from the filter
+    void clear() { memset(counters, 0, size); }
+
+private:
+
+    /// @brief The counters
+    uint8_t* counters;
+    /// @brief The number of counters
+    uint64_t size;
+    /// @brief The shift that reduces a 64-bit hash to a counter index
+    uint32_t shift;
+
+    /// @brief The value of a saturated counter
+    static constexpr uint8_t SATURATED = UINT8_MAX;
+
+    /// @brief Compute the first counter index of a line
+    /// @param line_addr The line address
+    /// @return The counter index
+    inline uint64_t hash1(uint64_t line_addr) const { return (line_addr * 0x9E3779B97F4A7C15ull) >> shift; }
+    /// @brief Compute the second counter index of a line
+    /// @param line_addr The line address
+    /// @return The counter index
+    inline uint64_t hash2(uint64_t line_addr) const { return (line_addr * 0xC2B2AE3D27D4EB4Full) >> shift; }
+
+    /// @brief Increment a counter, unless it is saturated
+    /// @param counter The counter
+    static inline void increment(uint8_t& counter) { counter += counter != SATURATED; }
+    /// @brief Decrement a counter, unless it is saturated (its true count is then unknown)
+    /// @param counter The counter
+    static inline void decrement(uint8_t& counter) { counter -= counter != SATURATED; }
+};
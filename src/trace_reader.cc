@@ -0,0 +1,190 @@
+/// @file trace_reader.cc
+/// @brief Implementation of the TraceReader class
+
+#include <bit>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "memory_system.h"
+#include "trace_reader.h"
+
+/// @brief The size of the raw trace buffer in bytes
+#define TRACE_READ_BUF (1 << 22)
+
+TraceReader::TraceReader()
+    : version(0), n_cores(0), addr_width(0), n_records(0), fd(-1), swap(false), malformed(false), end_of_file(false), seekable(false),
+    record_size(0), records_read(0), mapping(nullptr), data(nullptr), buffer_pos(0), buffer_len(0) {}
+TraceReader::~TraceReader() {
+    if (mapping) munmap(mapping, buffer_len);
+    if (fd >= 0) close(fd);
+}
+
+std::string TraceReader::open(const char* path) {
+    // A trace streamed while it is generated is read from stdin ('-'), a FIFO or a Unix socket, which is connected to
+    fd = strcmp(path, "-") ? ::open(path, O_RDONLY) : dup(STDIN_FILENO);
+    if (fd < 0 && errno == ENXIO) fd = connectSocket(path);
+    if (fd < 0) return std::string("Trace file read error: ") + std::strerror(errno);
+
+    // A regular file is mapped into memory as a whole, so that it is decoded without copying it, while other
+    // files (pipes, sockets) are buffered as they are read
+    struct stat file_stat;
+    seekable = !fstat(fd, &file_stat) && S_ISREG(file_stat.st_mode);
+    if (seekable && file_stat.st_size) {
+        void* map = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, file_stat.st_size, MADV_SEQUENTIAL);
+            mapping = (char*)map;
+            data = mapping;
+            buffer_len = file_stat.st_size;
+            end_of_file = true;
+        }
+    }
+    if (!mapping) {
+        // Buffer the start of the trace file, which contains the header if there is one
+        buffer.resize(TRACE_READ_BUF);
+        data = buffer.data();
+        record_size = 1;
+        refill();
+    }
+
+    if (buffer_len >= TRACE_V2_HEADER_SIZE && !memcmp(data, "CSIMTRAC", 8)) {
+        // Version 2 header
+        const char* header = data;
+        swap = (header[8] == 1) != (std::endian::native == std::endian::big);
+        version = header[9];
+        addr_width = header[10];
+        uint8_t fields = header[11];
+        n_cores = load<uint16_t>(header + 12);
+        n_records = load<uint64_t>(header + 16);
+        uint32_t header_size = load<uint32_t>(header + 24);
+        // A field this version does not know would change the record size, so the records could not be decoded
+        if ((uint8_t)header[8] > 1 || version != 2 || fields & ~(FIELD_THREAD_ID | FIELD_SIZE | FIELD_PC)) return "Unsupported trace file version";
+        if (addr_width != 4 && addr_width != 8) return "Unsupported trace address width (expect 4 or 8 bytes)";
+        if (!n_cores || n_cores > MAX_N_CACHES) return "Unsupported number of cores in trace (expect 1 to " + std::to_string(MAX_N_CACHES) + ")";
+        if (header_size < TRACE_V2_HEADER_SIZE || header_size > buffer_len) return "Malformed trace file";
+
+        record_size = sizeof(uint16_t) + addr_width;
+        if (fields & FIELD_THREAD_ID) record_size += sizeof(uint32_t);
+        if (fields & FIELD_SIZE) record_size += sizeof(uint8_t);
+        if (fields & FIELD_PC) record_size += addr_width;
+        buffer_pos = header_size;
+    } else {
+        // No header
+        version = 1;
+        addr_width = sizeof(uint32_t);
+        n_cores = TRACE_V1_N_CORES;
+        record_size = sizeof(trace_t);
+        swap = std::endian::native == std::endian::big;
+    }
+
+    // A regular file can be checked for truncation up front (streamed traces are checked when they end)
+    if (seekable) {
+        size_t records_size = file_stat.st_size - buffer_pos;
+        if (records_size % record_size || (n_records && n_records != records_size / record_size)) return "Malformed trace file";
+        if (!n_records) n_records = records_size / record_size;
+    }
+    return "";
+}
+
+int TraceReader::connectSocket(const char* path) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    if (connect(sock, (sockaddr*)&addr, sizeof(addr))) {
+        int error = errno;
+        close(sock);
+        errno = error;
+        return -1;
+    }
+    return sock;
+}
+
+bool TraceReader::refill() {
+    if (!mapping) {
+        // Keep the bytes not decoded yet
+        buffer_len -= buffer_pos;
+        memmove(buffer.data(), buffer.data() + buffer_pos, buffer_len);
+        buffer_pos = 0;
+
+        // Pipes and sockets may return less than requested, so read until the buffer is full
+        while (!end_of_file && buffer_len < buffer.size()) {
+            ssize_t n_read = ::read(fd, buffer.data() + buffer_len, buffer.size() - buffer_len);
+            if (n_read < 0 && errno == EINTR) continue;
+            if (n_read <= 0) end_of_file = true;
+            else buffer_len += n_read;
+        }
+    }
+
+    // A partial record at the end of the trace, or fewer records than announced, means the trace was truncated
+    if (buffer_len - buffer_pos >= record_size) return true;
+    if (buffer_len - buffer_pos || (n_records && records_read != n_records)) malformed = true;
+    return false;
+}
+
+bool TraceReader::skip(uint64_t n_skip) {
+    // Seek past the records that are not buffered yet (a mapped trace file is buffered as a whole)
+    uint64_t n_buffered = (buffer_len - buffer_pos) / record_size;
+    if (seekable && n_skip > n_buffered && n_records && records_read + n_skip <= n_records) {
+        lseek(fd, (n_skip - n_buffered) * record_size - (buffer_len - buffer_pos) % record_size, SEEK_CUR);
+        records_read += n_skip;
+        buffer_pos = buffer_len;
+        return true;
+    }
+
+    // Otherwise read through the records
+    while (n_skip) {
+        if (buffer_len - buffer_pos < record_size && !refill()) return false;
+        size_t count = std::min<uint64_t>((buffer_len - buffer_pos) / record_size, n_skip);
+        buffer_pos += count * record_size;
+        records_read += count;
+        n_skip -= count;
+    }
+    return true;
+}
+
+template<typename A>
+size_t TraceReader::read(trace_entry<A>* entries, size_t max_entries) {
+    size_t n = 0;
+    while (n < max_entries && !malformed) {
+        if (buffer_len - buffer_pos < record_size && !refill()) break;
+
+        // Decode every complete record in the buffer
+        size_t count = std::min<size_t>((buffer_len - buffer_pos) / record_size, max_entries - n);
+        const char* record = data + buffer_pos;
+        if (version == 1) {
+            for (size_t i = 0; i < count; i++, record += record_size) {
+                uint8_t op = record[0];
+                entries[n + i] = { (A)load<uint32_t>(record + 1), (uint16_t)(op >> 1), (bool)(op & 1) };
+            }
+        } else {
+            for (size_t i = 0; i < count; i++, record += record_size) {
+                uint16_t op = load<uint16_t>(record);
+                if ((uint32_t)(op >> 1) >= n_cores) {
+                    // Stop at the malformed record
+                    malformed = true;
+                    count = i;
+                    break;
+                }
+                entries[n + i] = { load<A>(record + 2), (uint16_t)(op >> 1), (bool)(op & 1) };
+            }
+        }
+        buffer_pos += count * record_size;
+        records_read += count;
+        n += count;
+    }
+    return n;
+}
+
+template size_t TraceReader::read(trace_entry<uint32_t>* entries, size_t max_entries);
+template size_t TraceReader::read(trace_entry<uint64_t>* entries, size_t max_entries);
@@ -0,0 +1,155 @@
+/// @file trace_reader.h
+/// @brief Declaration of the TraceReader class, which decodes both trace file formats
+///
+/// Version 1 trace format (no header, little endian):
+/// - A sequence of 5 byte records: the 7-bit core ID combined with the 1-bit R/W mode (uint8_t, the
+///   lowest bit is set for writes), followed by the address accessed (uint32_t)
+///
+/// Version 2 trace format (all values in the byte order given by the header):
+/// - Header (TRACE_V2_HEADER_SIZE bytes):
+///   - Magic number: the 8 characters "CSIMTRAC"
+///   - Byte order (uint8_t): 0 for little endian, 1 for big endian
+///   - Format version (uint8_t): 2
+///   - Address width (uint8_t): 4 or 8 bytes
+///   - Optional record fields (uint8_t): a combination of the 'trace_field_e' flags (a trace with any other bit
+///     set is rejected as an unsupported version)
+///   - Number of cores (uint16_t): 1 to MAX_N_CACHES
+///   - Reserved (uint16_t): 0
+///   - Number of records (uint64_t): 0 if unknown when the header was written (e.g. a streamed trace)
+///   - Header size (uint32_t): the offset of the first record, so that fields can be added to the header
+///   - Reserved (uint32_t): 0
+/// - A sequence of records:
+///   - The core ID combined with the R/W mode (uint16_t, the lowest bit is set for writes)
+///   - The address accessed (address width bytes)
+///   - The optional fields present, in the order of the 'trace_field_e' flags
+///
+/// A trace file without the magic number is read as a version 1 trace
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "typedefs.h"
+
+/// @brief The number of cores of a version 1 trace (7-bit core ID)
+#define TRACE_V1_N_CORES 128
+/// @brief The size of the version 2 header written by this version of the simulator
+#define TRACE_V2_HEADER_SIZE 32
+
+/// @brief Optional fields of the version 2 trace records
+enum trace_field_e {
+    /// @brief The ID of the thread that performed the access (uint32_t)
+    FIELD_THREAD_ID = 1,
+    /// @brief The size of the access in bytes (uint8_t)
+    FIELD_SIZE = 2,
+    /// @brief The program counter of the accessing instruction (address width bytes)
+    FIELD_PC = 4
+};
+
+/// @brief A decoded memory access
+/// @tparam A The address type
+template<typename A>
+struct trace_entry {
+    /// @brief The address that is accessed
+    A addr;
+    /// @brief The ID of the accessing core
+    uint16_t cache_id;
+    /// @brief Whether the access is a write
+    bool write;
+};
+
+/// @brief Reads a version 1 or version 2 trace file, decoding it into trace entries
+class TraceReader {
+public:
+
+    /// @brief The format version of the trace
+    uint32_t version;
+    /// @brief The number of cores of the trace (the number of caches to simulate)
+    uint32_t n_cores;
+    /// @brief The width of the addresses in bytes (4 or 8)
+    uint32_t addr_width;
+    /// @brief The number of records in the trace (0 if unknown)
+    uint64_t n_records;
+
+    TraceReader();
+    ~TraceReader();
+
+    /// @brief Open a trace file and read its header
+    /// @param path The path to the trace file, which may also be a FIFO or a Unix socket, or '-' for stdin
+    /// @return An error message, or an empty string on success
+    std::string open(const char* path);
+
+    /// @brief Decode the next entries of the trace
+    /// @tparam A The address type ('addr_width' bytes)
+    /// @param entries The array to contain the entries
+    /// @param max_entries The maximum number of entries to decode
+    /// @return The number of entries decoded (0 at the end of the trace or at the first malformed record)
+    template<typename A>
+    size_t read(trace_entry<A>* entries, size_t max_entries);
+
+    /// @brief Skip over the next records of the trace
+    /// @param n_skip The number of records to skip
+    /// @return False if the trace ended before all records were skipped
+    bool skip(uint64_t n_skip);
+
+    /// @brief Check if a malformed record or a truncated trace was encountered
+    /// @return True if the trace is malformed
+    bool isMalformed() { return malformed; }
+
+    /// @brief Check if the trace file is a regular file, which can be opened again and skipped through
+    /// @return True if the trace file is a regular file
+    bool isSeekable() { return seekable; }
+
+private:
+
+    /// @brief The file descriptor of the trace file
+    int fd;
+    /// @brief Whether the byte order of the trace differs from the byte order of this machine
+    bool swap;
+    /// @brief Whether a malformed record or a truncated trace was encountered
+    bool malformed;
+    /// @brief Whether the end of the trace file was reached
+    bool end_of_file;
+    /// @brief Whether the trace file is a regular file, which can be skipped through without reading it
+    bool seekable;
+    /// @brief The size of each record in bytes
+    uint32_t record_size;
+    /// @brief The number of records decoded so far
+    uint64_t records_read;
+
+    /// @brief Raw bytes read from the trace file and not decoded yet (trace files that are not mapped only)
+    std::vector<char> buffer;
+    /// @brief The trace file mapped into memory as a whole (regular files only, nullptr otherwise)
+    char* mapping;
+    /// @brief The raw bytes of the trace: the mapping if the trace file is mapped, or else the buffer
+    const char* data;
+    /// @brief The offset of the first byte not decoded yet
+    size_t buffer_pos;
+    /// @brief The number of valid bytes in the buffer (the size of the trace file if it is mapped)
+    size_t buffer_len;
+
+    /// @brief Connect to a Unix socket that streams a trace
+    /// @param path The path to the socket
+    /// @return The file descriptor of the connection, or -1 on error (with errno set)
+    int connectSocket(const char* path);
+
+    /// @brief Move the bytes not decoded yet to the start of the buffer, and fill the rest of the buffer
+    /// (a mapped trace file needs no refill, so only the end of the trace is checked)
+    /// @return False if no complete record could be buffered
+    bool refill();
+
+    /// @brief Load an integer in the byte order of the trace
+    /// @tparam T The integer type
+    /// @param src The bytes to load
+    /// @return The integer
+    template<typename T>
+    inline T load(const char* src) {
+        T value;
+        memcpy(&value, src, sizeof(T));
+        if (!swap) return value;
+        if constexpr (sizeof(T) == 2) return __builtin_bswap16(value);
+        else if constexpr (sizeof(T) == 4) return __builtin_bswap32(value);
+        else return __builtin_bswap64(value);
+    }
+};
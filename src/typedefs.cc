@@ -0,0 +1,26 @@
+/// @file typedefs.cc
+/// @brief Definition of the global variables and helper types declared in typedefs.h
+
+#include "typedefs.h"
+
+sim_options options = { .check_coherence = true, .checkpoint_interval = 16 };
+
+std::map<std::string, coh_factory_t, protocol_less>* coherence_map = nullptr;
+std::map<std::string, dir_factory_t, ci_less>* directory_map = nullptr;
+std::map<std::string, rep_factory_t, ci_less>* replacement_map = nullptr;
+
+bool ci_less::operator()(const std::string& s1, const std::string& s2) const {
+    std::string s1l = s1, s2l = s2;
+    for (char& c : s1l) c = std::tolower(c);
+    for (char& c : s2l) c = std::tolower(c);
+    return s1l < s2l;
+}
+
+bool protocol_less::operator()(const std::string& s1, const std::string& s2) const {
+    // Table protocol names sort together, since they share the prefix, and are ordered by their exact path
+    size_t prefix_len = std::strlen(TABLE_PROTOCOL_PREFIX);
+    bool table1 = s1.length() > prefix_len && !strncasecmp(s1.c_str(), TABLE_PROTOCOL_PREFIX, prefix_len);
+    bool table2 = s2.length() > prefix_len && !strncasecmp(s2.c_str(), TABLE_PROTOCOL_PREFIX, prefix_len);
+    if (!table1 || !table2) return ci_less()(s1, s2);
+    return s1.compare(prefix_len, std::string::npos, s2, prefix_len, std::string::npos) < 0;
+}
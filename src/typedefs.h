@@ -19,15 +19,25 @@
 #endif
 
 /// @brief Cache class
-class Cache;
+template<typename A> class Cache;
 /// @brief Cache abstract base class
 class CacheABC;
+/// @brief Coherence checker class
+template<typename A> class CoherenceChecker;
 /// @brief Coherence protocol base class
 class CoherenceProtocol;
 /// @brief MemorySystem class
-class MemorySystem;
+template<typename A> class MemorySystem;
+/// @brief Miss classifier class
+template<typename A> class MissClassifier;
 /// @brief Replacement policy base class
 class ReplacementPolicy;
+/// @brief Snoop filter class
+class SnoopFilter;
+/// @brief Results sink class
+class ResultsSink;
+/// @brief Trace reader class
+class TraceReader;
 
 /// @brief Argument indices for single metrics run
 enum args_single_e {
@@ -85,9 +95,17 @@ enum state_e {
     /// @brief Shared clean
     Sc,
     /// @brief Shared modified
-    Sm
+    Sm,
+    /// @brief Forward (shared clean, but the one copy that responds to bus reads)
+    F,
+
+    /// @brief Number of states
+    N_STATES
 };
 
+/// @brief Names of the states in state_e, as spec files and error messages spell them
+inline constexpr const char* state_names[N_STATES] = { "I", "D", "E", "M", "V", "O", "S", "Sc", "Sm", "F" };
+
 /// @brief Bus message IDs
 enum bus_msg_e {
     /// @brief Read access on a cache line
@@ -132,32 +150,66 @@ enum statistic_e {
     /// @brief Cache line evicted by the replacement policy
     Eviction,
 
-    /// @brief Cache line changes from shared (O, S, Sc, Sm) to singular (D, E, M, V)
+    /// @brief Cache line changes from shared (O, S, Sc, Sm, F) to singular (D, E, M, V)
     Exclusion,
-    /// @brief Cache line changes from singular (D, E, M, V) to shared (O, S, Sc, Sm)
+    /// @brief Cache line changes from singular (D, E, M, V) to shared (O, S, Sc, Sm, F)
     Intervention,
     /// @brief Cache line state set to invalid (I)
     Invalidation,
 
+    /// @brief Miss on a line never accessed before by the cache
+    CompulsoryMiss,
+    /// @brief Miss that a fully-associative cache of the same size would also incur
+    CapacityMiss,
+    /// @brief Miss that a fully-associative cache of the same size would avoid
+    ConflictMiss,
+    /// @brief Miss on a line that was invalidated by another cache
+    CoherenceMiss,
+
+    /// @brief Valid copy that did not respond to a bus read, where every copy would respond without a single
+    /// designated responder (F or O state); the one response needed when no copy responds is not counted
+    RedundantResponseAvoided,
+
+    /// @brief Read miss predicted to be on a migratory line, for which exclusive ownership was requested (BusRdX)
+    MigratoryPrediction,
+    /// @brief Migratory prediction followed by a write of the processor before another cache accessed the line
+    MigratoryPredictionCorrect,
+
+    /// @brief Bus message checked against the snoop filter of the receiving cache
+    SnoopFilterProbe,
+    /// @brief Bus message the snoop filter kept from the receiving cache, since it certainly has no valid copy
+    SnoopLookupAvoided,
+    /// @brief Bus message the snoop filter let through to a cache without a valid copy of the line
+    SnoopFilterFalsePositive,
+
+    /// @brief Fill of a line found in the recency ghost list (B1) of the ARC replacer, which moves its set towards recency
+    RecencyGhostHit,
+    /// @brief Fill of a line found in the frequency ghost list (B2) of the ARC replacer, which moves its set towards
+    /// frequency
+    FrequencyGhostHit,
+    /// @brief Halving of the access counters of a set by the LFU or LFRU replacer, after one of them saturated
+    CounterAging,
+    /// @brief Set in which the ARC replacer favors recency at the end of the run (its T1 target is above half the set)
+    RecencySet,
+    /// @brief Set in which the ARC replacer favors frequency at the end of the run
+    FrequencySet,
+
     /// @brief The number of statistics a cache keeps track of; not a statistic
     N_STATISTICS
 };
 
-/// @brief Memory address
-typedef uint32_t addr_t;
-/// @brief Cache line tag
-typedef uint32_t tag_t;
-
-/// @brief Cache line fields (without data field)
+/// @brief Cache line fields seen by the coherence protocols
 struct cache_line {
-    /// @brief Tag of the line
-    tag_t tag;
     /// @brief State the line is in
     state_e state;
-#ifdef WRITE_TIMESTAMP
-    /// @brief The timestamp of the last write to the cache line
-    size_t timestamp;
-#endif
+};
+
+/// @brief Cache line fields (without data field)
+/// @tparam A The address type (the tag is as wide as the addresses of the trace)
+template<typename A>
+struct tagged_line : cache_line {
+    /// @brief Tag of the line
+    A tag;
 };
 
 /// @brief Configuration for an individual memory system
@@ -178,6 +230,42 @@ struct cache_config {
     std::string replacer;
 };
 
+/// @brief Formats of the statistics output
+enum output_format_e {
+    /// @brief One CSV row per cache, with a header row
+    FORMAT_CSV,
+    /// @brief Columnar binary format (see results_sink.cc)
+    FORMAT_BIN,
+    /// @brief Compressed columnar format including the configurations (see results_store.h)
+    FORMAT_COL
+};
+
+/// @brief Optional simulator features, selected with command line options
+struct sim_options {
+    /// @brief Classify each miss as a compulsory, capacity, conflict or coherence miss
+    bool classify_misses;
+    /// @brief Keep a counting Bloom filter of the valid lines of each cache, so that bus messages skip caches without a copy
+    bool snoop_filter;
+    /// @brief Hash the set index of each line with its tag, like caches with a hashed index
+    bool hashed_index;
+    /// @brief Classify the lines of the trace with a pre-pass, so that bus messages for lines only one core accesses skip the other caches
+    bool private_lines;
+    /// @brief The format of the statistics output
+    output_format_e output_format;
+    /// @brief Verify the coherence invariants after every memory access
+    bool check_coherence;
+    /// @brief The file to periodically write a checkpoint to (nullptr for no checkpoints)
+    const char* checkpoint_file;
+    /// @brief The checkpoint file to resume from (nullptr to start from the beginning of the trace)
+    const char* resume_file;
+    /// @brief The number of trace chunks processed between checkpoints
+    uint32_t checkpoint_interval;
+    /// @brief The file listing the variants to fork from the single configuration (nullptr to not fork)
+    const char* variants_file;
+    /// @brief The number of trace records processed by the single configuration before the variants are forked
+    uint64_t fork_at;
+};
+
 /// @brief Comparator functor for strings, case insensitive
 struct ci_less {
     /// @brief Compare two string ignoring case
@@ -187,25 +275,57 @@ struct ci_less {
     bool operator() (const std::string& s1, const std::string& s2) const;
 };
 
+/// @brief The prefix of the coherence protocol names which load a spec file (the path follows the prefix)
+#define TABLE_PROTOCOL_PREFIX "Table:"
+
+/// @brief Comparator functor for coherence protocol names, case insensitive except for the spec file path of a table
+/// protocol (see TABLE_PROTOCOL_PREFIX), since paths that differ in case may name different files
+struct protocol_less {
+    /// @brief Compare two coherence protocol names
+    /// @param s1 The first name
+    /// @param s2 The second name
+    /// @return True if 's1' comes before 's2'
+    bool operator() (const std::string& s1, const std::string& s2) const;
+};
+
 #pragma pack(push, 1)
-/// @brief The format of a single trace
+/// @brief The format of a single trace in a version 1 trace file (see trace_reader.h)
 struct trace_t {
     /// @brief The first byte of a trace; the 7-bit CPU ID combined with the 1-bit R/W mode
     uint8_t op;
     /// @brief The address that is accessed
-    addr_t addr;
+    uint32_t addr;
 };
 #pragma pack(pop)
 
 /// @brief Coherence protocol factory function signature
 typedef std::function<CoherenceProtocol* (CacheABC&)> coh_factory_t;
-/// @brief Directory protocol factory function signature
-typedef std::function<MemorySystem* (cache_config&)> dir_factory_t;
+/// @brief Directory protocol factory functions, one per supported address width
+struct dir_factory_t {
+    /// @brief Factory of memory systems with 32-bit addresses
+    std::function<MemorySystem<uint32_t>* (cache_config&, uint32_t)> addr32;
+    /// @brief Factory of memory systems with 64-bit addresses
+    std::function<MemorySystem<uint64_t>* (cache_config&, uint32_t)> addr64;
+
+    /// @brief Create a memory system
+    /// @tparam A The address type of the memory system
+    /// @param config The configuration of the memory system
+    /// @param n_caches The number of caches in the memory system
+    /// @return The new memory system
+    template<typename A>
+    MemorySystem<A>* create(cache_config& config, uint32_t n_caches) {
+        if constexpr (sizeof(A) == sizeof(uint32_t)) return addr32(config, n_caches);
+        else return addr64(config, n_caches);
+    }
+};
 /// @brief Replacement policy factory function signature
 typedef std::function<ReplacementPolicy* (CacheABC&, uint32_t, uint32_t)> rep_factory_t;
 
+/// @brief The options selected on the command line
+extern sim_options options;
+
 /// @brief A map from coherence protocol names to their factory functions
-extern std::map<std::string, coh_factory_t, ci_less>* coherence_map;
+extern std::map<std::string, coh_factory_t, protocol_less>* coherence_map;
 /// @brief A map from directory protocol names to their factory functions
 extern std::map<std::string, dir_factory_t, ci_less>* directory_map;
 /// @brief A map from replacement policy names to their factory functions
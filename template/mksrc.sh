@@ -10,7 +10,7 @@ if [ $# -eq 0 ]; then
   echo "  class_name: The name of the new policy/protocol (TitleCase)"
   echo "  file_name:  The file name of the generic source file pair (snake_case)"
   echo "  states:     The list of states in the coherence protocol's state transition graph."
-  echo "                Choose at least two of I, D, E, M, V, O, S, Sc, and Sm"
+  echo "                Choose at least two of I, D, E, M, V, O, S, Sc, Sm, and F"
   exit 0
 fi
 
@@ -68,7 +68,7 @@ if [ $# -gt 1 ]; then
           exit 3
         fi
         # Rule 3: Only specific states permissible
-        if ! [[ "$state" =~ ^(D|E|I|M|O|S|(Sc)|(Sm)|V)$ ]]; then
+        if ! [[ "$state" =~ ^(D|E|F|I|M|O|S|(Sc)|(Sm)|V)$ ]]; then
           echo "Illegal state: $state"
           exit 3
         fi
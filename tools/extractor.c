@@ -1,17 +1,60 @@
 /// @file extractor.c
 /// @brief This program will intercept the output of gem5 and redirect the traces to a binary file
+///
+/// The output of gem5 is read in large blocks and split into lines with memchr (which glibc vectorizes), and the
+/// trace lines are parsed by hand instead of with sscanf. The records are collected in a large buffer which is
+/// written out in a single call once full, so the extractor keeps up with gem5 running at full speed
 
 #include <endian.h>
 #include <errno.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
-#ifndef NCPU
-/// @brief The number of CPU cores in the current gem5 run (defined externally)
-#define NCPU 16
-#endif
+/// @brief The size of the input buffer in bytes (also the maximum length of a trace line)
+#define IN_BUF_SIZE (1 << 24)
+/// @brief The size of the output buffer in bytes
+#define OUT_BUF_SIZE (1 << 22)
+/// @brief The number of cores of a version 1 trace (7-bit core ID)
+#define TRACE_V1_N_CORES 128
+/// @brief The maximum number of cores of a version 2 trace
+#define TRACE_V2_N_CORES 1024
+/// @brief The size of the version 2 header
+#define TRACE_V2_HEADER_SIZE 32
+
+/// @brief Per-core memory operation counts, grown as cores appear in the output of gem5
+struct op_counts {
+    /// @brief The number of instruction fetches of each core
+    uint64_t* ifetch;
+    /// @brief The number of reads of each core
+    uint64_t* read;
+    /// @brief The number of writes of each core
+    uint64_t* write;
+    /// @brief The number of cores counted
+    uint32_t n_cores;
+};
+
+/// @brief The binary trace file being written
+struct trace_out {
+    /// @brief The trace file
+    FILE* file;
+    /// @brief The format version of the trace (1 or 2)
+    int version;
+    /// @brief Whether the trace file is a regular file, whose header can be written again at the end
+    int seekable;
+    /// @brief The number of cores the trace can hold
+    uint32_t max_cores;
+    /// @brief Records not written to the trace file yet
+    char* buf;
+    /// @brief The number of bytes in the buffer
+    size_t len;
+    /// @brief The number of records written
+    uint64_t n_records;
+};
 
 /// @brief Like fprintf, but specifically for integers and with the standard thousands separator
 /// @param file The file to print to
@@ -28,28 +71,154 @@ void fprintfcomma(FILE* file, uint64_t n, int width) {
     }
 }
 
+/// @brief Make sure the operation counts include a core
+/// @param counts The operation counts
+/// @param n_cores The number of cores to include
+void growCounts(struct op_counts* counts, uint32_t n_cores) {
+    if (n_cores <= counts->n_cores) return;
+    counts->ifetch = realloc(counts->ifetch, n_cores * sizeof(uint64_t));
+    counts->read = realloc(counts->read, n_cores * sizeof(uint64_t));
+    counts->write = realloc(counts->write, n_cores * sizeof(uint64_t));
+    if (!counts->ifetch || !counts->read || !counts->write) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    for (uint32_t i = counts->n_cores; i < n_cores; i++) counts->ifetch[i] = counts->read[i] = counts->write[i] = 0;
+    counts->n_cores = n_cores;
+}
+
+/// @brief Write the buffered records to the trace file
+/// @param trace The trace file being written
+void flushTrace(struct trace_out* trace) {
+    if (trace->len && fwrite(trace->buf, 1, trace->len, trace->file) != trace->len) {
+        fprintf(stderr, "Couldn't write to trace file: %s\n", strerror(errno));
+        exit(1);
+    }
+    trace->len = 0;
+}
+
+/// @brief Write the version 2 header (see trace_reader.h) at the current position of the trace file
+/// @param trace The trace file being written
+/// @param n_cores The number of cores
+void writeHeader(struct trace_out* trace, uint32_t n_cores) {
+    char header[TRACE_V2_HEADER_SIZE] = "CSIMTRAC";
+    header[8] = 0;  // Little endian
+    header[9] = 2;  // Version
+    header[10] = 8; // Address width
+    header[11] = 0; // No optional fields
+    uint16_t cores = htole16(n_cores);
+    uint64_t records = htole64(trace->n_records);
+    uint32_t header_size = htole32(TRACE_V2_HEADER_SIZE);
+    memcpy(header + 12, &cores, sizeof(cores));
+    memcpy(header + 16, &records, sizeof(records));
+    memcpy(header + 24, &header_size, sizeof(header_size));
+    if (fwrite(header, 1, TRACE_V2_HEADER_SIZE, trace->file) != TRACE_V2_HEADER_SIZE) {
+        fprintf(stderr, "Couldn't write to trace file: %s\n", strerror(errno));
+        exit(1);
+    }
+}
+
+/// @brief Parse a line of gem5 output of the format '<cpu>\t<op>\t<hex address>', recording it if it is a trace
+/// @param line The line (without the newline character)
+/// @param end The end of the line
+/// @param counts The operation counts
+/// @param trace The trace file being written
+/// @return Zero if the line is not a trace
+int parseLine(const char* line, const char* end, struct op_counts* counts, struct trace_out* trace) {
+    // CPU core ID (decimal)
+    const char* pos = line;
+    uint32_t cpu = 0;
+    if (pos == end || *pos < '0' || *pos > '9') return 0;
+    for (; pos < end && *pos >= '0' && *pos <= '9'; pos++) cpu = cpu < TRACE_V2_N_CORES ? cpu * 10 + (*pos - '0') : cpu;
+    if (pos + 3 > end || pos[0] != '\t' || pos[2] != '\t') return 0;
+    char op = pos[1];
+    pos += 3;
+
+    // Address (hexadecimal, optionally prefixed with '0x')
+    if (end - pos > 2 && pos[0] == '0' && (pos[1] == 'x' || pos[1] == 'X')) pos += 2;
+    uint64_t addr = 0;
+    const char* digits = pos;
+    for (; pos < end; pos++) {
+        char c = *pos;
+        if (c >= '0' && c <= '9') addr = addr << 4 | (c - '0');
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') addr = addr << 4 | ((c | 0x20) - 'a' + 10);
+        else break;
+    }
+    if (pos == digits) return 0;
+    if (op != 'i' && op != 'r' && op != 'w') return 0; // Trace operation is invalid
+    if (cpu >= trace->max_cores) {
+        if (trace->version == 1) fprintf(stderr, "CPU %u does not fit the version 1 trace format (use -2)\n", cpu);
+        else if (trace->seekable) fprintf(stderr, "CPU %u does not fit the version 2 trace format\n", cpu);
+        else fprintf(stderr, "CPU %u is not in the header of the streamed trace (use -n)\n", cpu);
+        exit(1);
+    }
+    if (trace->version == 1 && addr > UINT32_MAX) {
+        fprintf(stderr, "Address %llx does not fit the version 1 trace format (use -2)\n", (unsigned long long)addr);
+        exit(1);
+    }
+
+    // Record stats
+    growCounts(counts, cpu + 1);
+    if (op == 'i') {
+        counts->ifetch[cpu]++;
+        return 1; // Don't write instruction fetches to trace file
+    }
+    if (op == 'r') counts->read[cpu]++;
+    else counts->write[cpu]++;
+
+    // Version 1: 7 bits for CPU core id, 1 bit for operation, and 4 bytes for memory address
+    // Version 2: 15 bits for CPU core id, 1 bit for operation, and 8 bytes for memory address
+    char* record = trace->buf + trace->len;
+    if (trace->version == 1) {
+        record[0] = (cpu << 1) | (op == 'w');
+        uint32_t addr32 = htole32((uint32_t)addr);
+        memcpy(record + 1, &addr32, sizeof(addr32));
+        trace->len += 1 + sizeof(addr32);
+    } else {
+        uint16_t cpu_op = htole16((cpu << 1) | (op == 'w'));
+        uint64_t addr64 = htole64(addr);
+        memcpy(record, &cpu_op, sizeof(cpu_op));
+        memcpy(record + 2, &addr64, sizeof(addr64));
+        trace->len += sizeof(cpu_op) + sizeof(addr64);
+    }
+    trace->n_records++;
+    if (trace->len > OUT_BUF_SIZE - 16) flushTrace(trace);
+    return 1;
+}
+
 /// @brief The main function intercepts the output of gem5, saving the memory traces to a binary file and memory operation statistics to a stat file
 /// @param argc The number of command line arguments
 /// @param argv An array to the ocmmand line arguments
 /// @return The program exit code
 int main(int argc, char const* argv[]) {
     // Verify args
-    if (argc < 2) {
-        printf("Please specify a path to save the trace binary! (./extractor [tracefile])\n");
+    struct trace_out trace = { NULL, 1, 0, TRACE_V1_N_CORES, NULL, 0, 0 };
+    uint32_t min_cores = 0;
+    int arg = 1;
+    for (; arg < argc - 1 && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-2")) trace.version = 2;
+        else if (!strcmp(argv[arg], "-n") && arg + 1 < argc - 1) min_cores = strtoul(argv[++arg], NULL, 10);
+        else break;
+    }
+    if (arg != argc - 1 || min_cores > TRACE_V2_N_CORES) {
+        printf("Please specify a path to save the trace binary! (./extractor [-n ncpus] [-2] [tracefile])\n");
+        printf("  -n ncpus: Include at least ncpus CPUs in the statistics (and the version 2 header, which is limited to\n");
+        printf("            ncpus CPUs if the trace file is a FIFO)\n");
+        printf("  -2:       Write a version 2 trace (64-bit addresses, up to %d CPUs) instead of a version 1 trace\n", TRACE_V2_N_CORES);
         return -1;
     }
 
     // Open trace file
     char buf[BUFSIZ];
-    sprintf(buf, "%s.bin", argv[1]);
-    FILE* trace = fopen(buf, "wb");
-    if (trace == NULL) {
+    snprintf(buf, sizeof(buf), "%s.bin", argv[arg]);
+    trace.file = fopen(buf, "wb");
+    if (trace.file == NULL) {
         printf("Couldn't open trace file for writing: %s", strerror(errno));
         return errno;
     }
 
     // Open trace statistics file
-    sprintf(buf, "%s.stat", argv[1]);
+    snprintf(buf, sizeof(buf), "%s.stat", argv[arg]);
     FILE* tracestat = fopen(buf, "w");
     if (tracestat == NULL) {
         printf("Couldn't open trace statistics file for writing: %s", strerror(errno));
@@ -59,41 +228,57 @@ int main(int argc, char const* argv[]) {
     // Get start time
     time_t tracetime = time(NULL);
 
-    // Read simulator output from stdin
-    uint64_t ifetch[NCPU] = { 0 };
-    uint64_t read[NCPU] = { 0 };
-    uint64_t write[NCPU] = { 0 };
-    while (fgets(buf, sizeof(char) * BUFSIZ, stdin)) {
-        int cpu = 0;
-        char op = 0;
-        int addr = 0;
-
-        // Skip non-trace lines
-        if (sscanf(buf, "%d\t%c\t%x\n", &cpu, &op, &addr) != 3) {
-            printf("%s", buf);
-            continue;
-        }
+    // The version 2 header is written again once the number of CPUs and records is known
+    struct op_counts counts = { NULL, NULL, NULL, 0 };
+    growCounts(&counts, min_cores ? min_cores : 1);
+    trace.buf = malloc(OUT_BUF_SIZE);
+    char* in_buf = malloc(IN_BUF_SIZE);
+    if (!trace.buf || !in_buf) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    if (trace.version == 2) {
+        // The header of a trace streamed to a FIFO is final, so it holds exactly the minimum number of CPUs
+        struct stat file_stat;
+        trace.seekable = !fstat(fileno(trace.file), &file_stat) && S_ISREG(file_stat.st_mode);
+        trace.max_cores = trace.seekable ? TRACE_V2_N_CORES : counts.n_cores;
+        writeHeader(&trace, counts.n_cores);
+    }
 
-        // Record stats
-        switch (op) {
-        case 'i':
-            ifetch[cpu]++;
-            continue; // Don't write instruction fetches to trace file
-        case 'r':
-            read[cpu]++;
-            break;
-        case 'w':
-            write[cpu]++;
-            break;
-        default: // Trace operation is invalid
-            printf("%s", buf);
-            continue;
+    // Read simulator output from stdin, one block at a time
+    size_t in_len = 0;
+    int end_of_input = 0;
+    while (!end_of_input) {
+        ssize_t n_read = read(STDIN_FILENO, in_buf + in_len, IN_BUF_SIZE - in_len);
+        if (n_read < 0 && errno == EINTR) continue;
+        if (n_read <= 0) end_of_input = 1;
+        else in_len += n_read;
+
+        // Parse every complete line (and the last line, even without a newline)
+        char* line = in_buf;
+        char* in_end = in_buf + in_len;
+        while (line < in_end) {
+            char* newline = memchr(line, '\n', in_end - line);
+            if (!newline) {
+                // A line longer than the buffer is not a trace, so it is passed on in pieces
+                if (!end_of_input && (line != in_buf || in_len < IN_BUF_SIZE)) break;
+                if (!end_of_input) newline = in_end - 1;
+                else newline = in_end;
+            }
+
+            // Skip non-trace lines
+            if (!parseLine(line, newline, &counts, &trace)) fwrite(line, 1, newline + (newline < in_end) - line, stdout);
+            line = newline + 1;
         }
 
-        // Write trace to binary file (7 bits for CPU core id, 1 bit for operation, and 4 bytes for memory address)
-        fputc((cpu << 1) | (op == 'w'), trace);
-        addr = htole32(addr);
-        fwrite(&addr, sizeof(addr), 1, trace);
+        // Keep the partial line at the end of the buffer
+        in_len = line < in_end ? in_end - line : 0;
+        memmove(in_buf, line, in_len);
+    }
+    flushTrace(&trace);
+    if (trace.version == 2 && trace.seekable) {
+        rewind(trace.file);
+        writeHeader(&trace, counts.n_cores);
     }
 
     // Get total trace generation time
@@ -109,9 +294,10 @@ int main(int argc, char const* argv[]) {
     else fprintf(tracestat, "%ds\n\n", s);
 
     // Get column widths
-    int cols[NCPU] = { 0 };
-    for (size_t i = 0; i < NCPU; i++) {
-        int num = ifetch[i] > i ? ifetch[i] : i;
+    uint32_t ncpu = counts.n_cores;
+    int* cols = calloc(ncpu, sizeof(int));
+    for (size_t i = 0; i < ncpu; i++) {
+        uint64_t num = counts.ifetch[i] > i ? counts.ifetch[i] : i;
         do cols[i]++;
         while (num /= 10);
         cols[i] += (cols[i] - 1) / 3;
@@ -119,17 +305,23 @@ int main(int argc, char const* argv[]) {
 
     // Write trace statistics to file
     fprintf(tracestat, "CPU:     ");
-    for (size_t i = 0; i < NCPU; i++) fprintfcomma(tracestat, i, cols[i]);
+    for (size_t i = 0; i < ncpu; i++) fprintfcomma(tracestat, i, cols[i]);
     fprintf(tracestat, "\nIFetches:");
-    for (size_t i = 0; i < NCPU; i++) fprintfcomma(tracestat, ifetch[i], cols[i]);
+    for (size_t i = 0; i < ncpu; i++) fprintfcomma(tracestat, counts.ifetch[i], cols[i]);
     fprintf(tracestat, "\nReads:   ");
-    for (size_t i = 0; i < NCPU; i++) fprintfcomma(tracestat, read[i], cols[i]);
+    for (size_t i = 0; i < ncpu; i++) fprintfcomma(tracestat, counts.read[i], cols[i]);
     fprintf(tracestat, "\nWrites:  ");
-    for (size_t i = 0; i < NCPU; i++) fprintfcomma(tracestat, write[i], cols[i]);
+    for (size_t i = 0; i < ncpu; i++) fprintfcomma(tracestat, counts.write[i], cols[i]);
     fprintf(tracestat, "\n");
 
     // Cleanup
-    fclose(trace);
+    fclose(trace.file);
     fclose(tracestat);
+    free(cols);
+    free(counts.ifetch);
+    free(counts.read);
+    free(counts.write);
+    free(trace.buf);
+    free(in_buf);
     return 0;
 }
@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Required arguments
+if [ $# -eq 0 ]; then
+    echo "Usage: ./$(basename $0) [configs_file]"
+    echo '  - configs_file: The configs file whose cache geometries the simulator is specialized for'
+    echo '    - The generated header is written to stdout'
+    echo '    - Normally run by "make GEOMETRY=<configs_file>"'
+    exit 0
+fi
+
+if [ ! -r "$1" ]; then
+    echo "Cannot read configs file '$1'" >&2
+    exit 1
+fi
+
+echo "/// @file geometry_kernels.h"
+echo "/// @brief The cache geometries the simulator is specialized for, generated by gen_kernels.sh from $(basename "$1")"
+echo ""
+echo "#pragma once"
+echo ""
+echo "/// @brief Apply KERNEL to each geometry: KERNEL(line offset, number of sets, associativity)"
+echo "#define GEOMETRY_KERNEL_LIST(KERNEL) \\"
+
+# Each config line starts with the cache size, line size and associativity (invalid configs are skipped, since the
+# simulator reports them when it reads the configs file)
+awk '
+function isPow2(n) { return n >= 1 && n == 2 ^ int(log(n) / log(2) + 0.5) }
+NF >= 3 && $1 ~ /^[0-9]+[kM]?$/ && $2 ~ /^[0-9]+$/ && $3 ~ /^[0-9]+$/ {
+    size = $1 + 0
+    if ($1 ~ /k$/) size *= 1024
+    if ($1 ~ /M$/) size *= 1024 * 1024
+    line_size = $2 + 0
+    assoc = $3 + 0
+    if (!isPow2(line_size) || assoc < 1 || line_size * assoc > size || size % (line_size * assoc)) next
+    key = int(log(line_size) / log(2) + 0.5) ", " size / line_size / assoc ", " assoc
+    if (!(key in seen)) {
+        seen[key] = 1
+        printf "    KERNEL(%s) \\\n", key
+    }
+}' "$1"
+echo ""
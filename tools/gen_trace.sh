@@ -31,7 +31,7 @@ PARSECDIR="$(pwd)/parsec-benchmark"
 source get_platform.sh
 
 # Compile the trace extractor program
-gcc -DNCPU=$NCPUS extractor.c -o extractor || {
+gcc -O2 extractor.c -o extractor || {
     echo "Please ensure the trace extractor program is present!"
     exit 1
 }
@@ -101,16 +101,16 @@ fi
 mkdir -p $OUTDIR
 if [[ $SUITE == "parsec" ]]; then
     "$GEMDIR/build/X86/gem5.fast" "$TOOLSDIR/gem5_config.py" $NCPUS $PROG $run_args \
-        | $TOOLSDIR/extractor "$OUTDIR/$BENCHMARK.$INPUTSIZE"
+        | $TOOLSDIR/extractor -n $NCPUS "$OUTDIR/$BENCHMARK.$INPUTSIZE"
 elif [[ $SUITE == "splash2x" ]]; then
     cat $PROG | sed -rz 's/\n+$//' | head -n -2 > ./run_vars.sh
     source ./run_vars.sh $NTHREADS $INPUTSIZE
     if [[ $PROGARGS =~ '<' ]]; then
         "$GEMDIR/build/X86/gem5.fast" "$TOOLSDIR/gem5_config.py" $NCPUS $PROG $NTHREADS < $INPUTFILE \
-            | $TOOLSDIR/extractor "$OUTDIR/$BENCHMARK.$INPUTSIZE"
+            | $TOOLSDIR/extractor -n $NCPUS "$OUTDIR/$BENCHMARK.$INPUTSIZE"
     else
         "$GEMDIR/build/X86/gem5.fast" "$TOOLSDIR/gem5_config.py" $NCPUS $RUN \
-            | $TOOLSDIR/extractor "$OUTDIR/$BENCHMARK.$INPUTSIZE"
+            | $TOOLSDIR/extractor -n $NCPUS "$OUTDIR/$BENCHMARK.$INPUTSIZE"
     fi
 fi
 
@@ -0,0 +1,69 @@
+/// @file read_results.cc
+/// @brief This program converts a compressed columnar results store (see results_store.h) back into CSV format
+
+#include <fstream>
+
+#include "results_store.h"
+
+/// @brief Find a column by name
+/// @param columns The decoded columns
+/// @param name The name of the column
+/// @return The column, or nullptr if the store has no such column
+const store_column* findColumn(const std::vector<store_column>& columns, const char* name) {
+    for (const store_column& column : columns)
+        if (column.name == name) return &column;
+    return nullptr;
+}
+
+/// @brief The main function decodes the results store and prints it to stdout as CSV
+/// @param argc The number of command line arguments
+/// @param argv An array to the command line arguments
+/// @return The program exit code
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: ./read_results <results_store>" << std::endl;
+        return -1;
+    }
+
+    // Decode the store
+    std::ifstream store_file(argv[1], std::ios_base::in | std::ios_base::binary);
+    if (!store_file) {
+        std::cerr << "Results store read error: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    std::vector<store_column> columns;
+    int64_t n_rows = readStore(store_file, columns);
+    if (n_rows < 0) {
+        std::cerr << "Malformed results store" << std::endl;
+        return 1;
+    }
+
+    // The miss rate is not stored, but derived from the access and miss counts. It follows the core column
+    const store_column* reads = findColumn(columns, "processor reads");
+    const store_column* writes = findColumn(columns, "processor writes");
+    const store_column* read_misses = findColumn(columns, "read misses");
+    const store_column* write_misses = findColumn(columns, "write misses");
+    bool miss_rate = reads && writes && read_misses && write_misses;
+    uint32_t miss_rate_after = miss_rate && columns.size() > 1 && columns[1].name == "core" ? 1 : 0;
+
+    // Header
+    for (uint32_t i = 0; i < columns.size(); i++) {
+        std::cout << (i ? "," : "") << columns[i].name;
+        if (miss_rate && i == miss_rate_after) std::cout << ",miss rate";
+    }
+    std::cout << '\n';
+
+    // Rows
+    for (int64_t row = 0; row < n_rows; row++) {
+        for (uint32_t i = 0; i < columns.size(); i++) {
+            if (i) std::cout << ',';
+            if (columns[i].encoding == ENCODING_DICTIONARY) std::cout << columns[i].dictionary[columns[i].values[row]];
+            else std::cout << columns[i].values[row];
+            if (miss_rate && i == miss_rate_after)
+                std::cout << ',' << ((double)read_misses->values[row] + (double)write_misses->values[row]) /
+                ((double)reads->values[row] + (double)writes->values[row]);
+        }
+        std::cout << '\n';
+    }
+    return 0;
+}
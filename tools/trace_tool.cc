@@ -0,0 +1,519 @@
+/// @file trace_tool.cc
+/// @brief This program filters and transforms trace files (see trace_reader.h for the formats)
+///
+/// The trace streams through a pipeline of three threads: one decodes the input (mapped into memory), one
+/// applies the filters in the order they were given on the command line, and one encodes and writes the output.
+/// The threads hand blocks of trace entries to each other at a barrier, so each stage works on its own block
+
+#include <barrier>
+#include <endian.h>
+#include <fcntl.h>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+
+#include "memory_system.h"
+#include "trace_reader.h"
+
+/// @brief The number of trace entries in each block of the pipeline
+#define N_BLOCK_ENTRIES (1 << 20)
+/// @brief The number of blocks in the pipeline (one per stage)
+#define N_BLOCKS 3
+
+/// @brief A filter applied to every block of the trace
+/// @tparam A The address type of the trace
+template<typename A>
+class TraceFilter {
+public:
+
+    virtual ~TraceFilter() {}
+
+    /// @brief Filter a block of entries in place
+    /// @param entries The entries
+    /// @param count The number of entries
+    /// @return The number of entries kept, which are moved to the front of the block in their original order
+    virtual size_t apply(trace_entry<A>* entries, size_t count) = 0;
+
+    /// @brief Determine the number of cores after the filter
+    /// @param n_cores The number of cores before the filter
+    /// @return The number of cores after the filter
+    virtual uint32_t mapCores(uint32_t n_cores) { return n_cores; }
+};
+
+/// @brief Keeps the accesses of a set of cores
+/// @tparam A The address type of the trace
+template<typename A>
+class CoreFilter : public TraceFilter<A> {
+public:
+
+    /// @brief Construct a new core filter
+    /// @param keep Whether to keep the accesses of each core (MAX_N_CACHES entries)
+    CoreFilter(std::vector<bool>& keep) : keep(keep) {}
+
+    size_t apply(trace_entry<A>* entries, size_t count) {
+        size_t n_kept = 0;
+        for (size_t i = 0; i < count; i++)
+            if (keep[entries[i].cache_id]) entries[n_kept++] = entries[i];
+        return n_kept;
+    }
+
+private:
+
+    /// @brief Whether to keep the accesses of each core
+    std::vector<bool> keep;
+};
+
+/// @brief Renumbers the cores
+/// @tparam A The address type of the trace
+template<typename A>
+class CoreRemap : public TraceFilter<A> {
+public:
+
+    /// @brief Construct a new core remap
+    /// @param new_ids The new number of each core (MAX_N_CACHES entries)
+    CoreRemap(std::vector<uint16_t>& new_ids) : new_ids(new_ids) {}
+
+    size_t apply(trace_entry<A>* entries, size_t count) {
+        for (size_t i = 0; i < count; i++) entries[i].cache_id = new_ids[entries[i].cache_id];
+        return count;
+    }
+
+    uint32_t mapCores(uint32_t n_cores) {
+        uint32_t new_n_cores = 0;
+        for (uint32_t i = 0; i < n_cores; i++) new_n_cores = std::max<uint32_t>(new_n_cores, new_ids[i] + 1);
+        return new_n_cores;
+    }
+
+private:
+
+    /// @brief The new number of each core
+    std::vector<uint16_t> new_ids;
+};
+
+/// @brief ANDs every address with a mask
+/// @tparam A The address type of the trace
+template<typename A>
+class AddressMask : public TraceFilter<A> {
+public:
+
+    /// @brief Construct a new address mask
+    /// @param mask The mask
+    AddressMask(A mask) : mask(mask) {}
+
+    size_t apply(trace_entry<A>* entries, size_t count) {
+        for (size_t i = 0; i < count; i++) entries[i].addr &= mask;
+        return count;
+    }
+
+private:
+
+    /// @brief The mask
+    A mask;
+};
+
+/// @brief Drops the accesses to a range of addresses
+/// @tparam A The address type of the trace
+template<typename A>
+class AddressStrip : public TraceFilter<A> {
+public:
+
+    /// @brief Construct a new address strip
+    /// @param start The first address of the range
+    /// @param end The address after the range
+    AddressStrip(A start, A end) : start(start), end(end) {}
+
+    size_t apply(trace_entry<A>* entries, size_t count) {
+        size_t n_kept = 0;
+        for (size_t i = 0; i < count; i++)
+            if (entries[i].addr < start || entries[i].addr >= end) entries[n_kept++] = entries[i];
+        return n_kept;
+    }
+
+private:
+
+    /// @brief The first address of the range
+    A start;
+    /// @brief The address after the range
+    A end;
+};
+
+/// @brief Keeps every nth access
+/// @tparam A The address type of the trace
+template<typename A>
+class Sample : public TraceFilter<A> {
+public:
+
+    /// @brief Construct a new sample filter
+    /// @param period The number of accesses per access kept
+    Sample(uint64_t period) : period(period), phase(0) {}
+
+    size_t apply(trace_entry<A>* entries, size_t count) {
+        // The phase carries over from block to block
+        size_t n_kept = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!phase) entries[n_kept++] = entries[i];
+            if (++phase == period) phase = 0;
+        }
+        return n_kept;
+    }
+
+private:
+
+    /// @brief The number of accesses per access kept
+    uint64_t period;
+    /// @brief The position of the next access within its period
+    uint64_t phase;
+};
+
+/// @brief A filter given on the command line, before the address type of the trace is known
+struct filter_arg {
+    /// @brief The name of the option
+    std::string option;
+    /// @brief The first value of the option
+    uint64_t value;
+    /// @brief The second value of the option (address ranges only)
+    uint64_t value2;
+    /// @brief The cores selected or renumbered by the option (core options only)
+    std::vector<uint16_t> cores;
+};
+
+/// @brief Block of trace entries passed along the pipeline
+/// @tparam A The address type of the trace
+template<typename A>
+struct trace_block {
+    /// @brief The entries (N_BLOCK_ENTRIES entries)
+    std::unique_ptr<trace_entry<A>[]> entries;
+    /// @brief The number of entries in the block
+    size_t count;
+    /// @brief Whether this is the last block of the trace
+    bool last;
+};
+
+/// @brief The tool's options
+struct tool_options {
+    /// @brief The second trace to interleave with the input (nullptr for none)
+    const char* merge_file;
+    /// @brief The number added to the cores of the second trace
+    uint32_t merge_offset;
+    /// @brief The format version of the output trace (0 for the format of the input trace)
+    uint32_t version;
+};
+
+/// @brief Print an error message and exit
+/// @param msg The error message
+[[noreturn]] void fail(const std::string& msg) {
+    std::cerr << msg << std::endl;
+    exit(1);
+}
+
+/// @brief Parse an unsigned integer (decimal, or hexadecimal with a '0x' prefix)
+/// @param str The string to parse
+/// @param end Set to the character after the integer, or nullptr if the whole string must be the integer
+/// @return The integer
+uint64_t parseNumber(const char* str, const char** end = nullptr) {
+    char* suffix;
+    uint64_t value = strtoull(str, &suffix, 0);
+    if (suffix == str || (!end && *suffix)) fail(std::string("Invalid number: ") + str);
+    if (end) *end = suffix;
+    return value;
+}
+
+/// @brief Parse a list of cores and core ranges, e.g. '0-3,8'
+/// @param str The string to parse
+/// @return Whether each core is listed, 1 or 0 (MAX_N_CACHES entries)
+std::vector<uint16_t> parseCores(const char* str) {
+    std::vector<uint16_t> listed(MAX_N_CACHES);
+    const char* pos = str;
+    while (true) {
+        uint64_t first = parseNumber(pos, &pos);
+        uint64_t last = *pos == '-' ? parseNumber(pos + 1, &pos) : first;
+        if (first > last || last >= MAX_N_CACHES) fail(std::string("Invalid core list: ") + str);
+        for (uint64_t core = first; core <= last; core++) listed[core] = 1;
+        if (!*pos) return listed;
+        if (*pos++ != ',') fail(std::string("Invalid core list: ") + str);
+    }
+}
+
+/// @brief Parse a list of core renumberings, e.g. '4:0,5:1' (the cores not listed keep their number)
+/// @param str The string to parse
+/// @return The new number of each core (MAX_N_CACHES entries)
+std::vector<uint16_t> parseCoreMap(const char* str) {
+    std::vector<uint16_t> new_ids(MAX_N_CACHES);
+    for (uint32_t i = 0; i < MAX_N_CACHES; i++) new_ids[i] = i;
+    const char* pos = str;
+    while (true) {
+        uint64_t core = parseNumber(pos, &pos);
+        if (*pos != ':') fail(std::string("Invalid core map: ") + str);
+        uint64_t new_id = parseNumber(pos + 1, &pos);
+        if (core >= MAX_N_CACHES || new_id >= MAX_N_CACHES) fail(std::string("Invalid core map: ") + str);
+        new_ids[core] = new_id;
+        if (!*pos) return new_ids;
+        if (*pos++ != ',') fail(std::string("Invalid core map: ") + str);
+    }
+}
+
+/// @brief Create the filters given on the command line
+/// @tparam A The address type of the trace
+/// @param args The filters given on the command line, in order
+/// @param filters The vector to contain the filters
+template<typename A>
+void createFilters(std::vector<filter_arg>& args, std::vector<std::unique_ptr<TraceFilter<A>>>& filters) {
+    for (filter_arg& arg : args) {
+        if (arg.option == "--cores" || arg.option == "--drop-cores") {
+            std::vector<bool> keep(MAX_N_CACHES);
+            for (uint32_t i = 0; i < MAX_N_CACHES; i++) keep[i] = (bool)arg.cores[i] == (arg.option == "--cores");
+            filters.emplace_back(new CoreFilter<A>(keep));
+        }
+        else if (arg.option == "--fold-cores") {
+            std::vector<uint16_t> new_ids(MAX_N_CACHES);
+            for (uint32_t i = 0; i < MAX_N_CACHES; i++) new_ids[i] = i % arg.value;
+            filters.emplace_back(new CoreRemap<A>(new_ids));
+        }
+        else if (arg.option == "--map-cores") filters.emplace_back(new CoreRemap<A>(arg.cores));
+        else if (arg.option == "--mask") filters.emplace_back(new AddressMask<A>(arg.value));
+        else if (arg.option == "--strip") filters.emplace_back(new AddressStrip<A>(arg.value, arg.value2));
+        else if (arg.option == "--sample") filters.emplace_back(new Sample<A>(arg.value));
+    }
+}
+
+/// @brief Store an integer in little endian byte order
+/// @tparam T The integer type
+/// @param dst The bytes to store to
+/// @param value The integer
+template<typename T>
+inline void storeLE(char* dst, T value) {
+    if constexpr (sizeof(T) == 1) *dst = value;
+    else if constexpr (sizeof(T) == 2) value = htole16(value);
+    else if constexpr (sizeof(T) == 4) value = htole32(value);
+    else value = htole64(value);
+    if constexpr (sizeof(T) > 1) memcpy(dst, &value, sizeof(T));
+}
+
+/// @brief Write a buffer to a file descriptor in full
+/// @param fd The file descriptor
+/// @param data The buffer
+/// @param size The size of the buffer in bytes
+void writeAll(int fd, const char* data, size_t size) {
+    while (size) {
+        ssize_t n_written = ::write(fd, data, size);
+        if (n_written < 0 && errno == EINTR) continue;
+        if (n_written <= 0) fail(std::string("Output trace write error: ") + std::strerror(errno));
+        data += n_written;
+        size -= n_written;
+    }
+}
+
+/// @brief Encode a version 2 trace header (see trace_reader.h)
+/// @param header The header to encode (TRACE_V2_HEADER_SIZE bytes)
+/// @param addr_width The width of the addresses in bytes
+/// @param n_cores The number of cores
+/// @param n_records The number of records (0 if unknown)
+void encodeHeader(char* header, uint32_t addr_width, uint32_t n_cores, uint64_t n_records) {
+    memset(header, 0, TRACE_V2_HEADER_SIZE);
+    memcpy(header, "CSIMTRAC", 8);
+    header[8] = 0; // Little endian
+    header[9] = 2;
+    header[10] = addr_width;
+    header[11] = 0; // No optional fields
+    storeLE<uint16_t>(header + 12, n_cores);
+    storeLE<uint64_t>(header + 16, n_records);
+    storeLE<uint32_t>(header + 24, TRACE_V2_HEADER_SIZE);
+}
+
+/// @brief Stream the input trace through the filters to the output trace
+/// @tparam A The address type of the traces
+/// @param input The reader of the input trace
+/// @param merge The reader of the trace to interleave with the input (nullptr for none)
+/// @param args The filters given on the command line, in order
+/// @param tool The tool's options
+/// @param out_fd The file descriptor of the output trace
+template<typename A>
+void transformTrace(TraceReader& input, TraceReader* merge, std::vector<filter_arg>& args, tool_options& tool, int out_fd) {
+    std::vector<std::unique_ptr<TraceFilter<A>>> filters;
+    createFilters<A>(args, filters);
+
+    // The number of cores of the output (an upper bound until the whole trace has been written)
+    uint32_t n_cores = input.n_cores;
+    if (merge) n_cores = std::max(n_cores, merge->n_cores + tool.merge_offset);
+    for (auto& filter : filters) n_cores = filter->mapCores(n_cores);
+    uint32_t version = tool.version ? tool.version : input.version;
+    if (version == 2 && n_cores > MAX_N_CACHES) fail("The output trace has too many cores (at most " + std::to_string(MAX_N_CACHES) + ')');
+
+    // The header of a regular file is rewritten with the exact number of cores and records at the end
+    bool seekable = lseek(out_fd, 0, SEEK_CUR) >= 0;
+    char header[TRACE_V2_HEADER_SIZE];
+    if (version == 2) {
+        encodeHeader(header, sizeof(A), n_cores, 0);
+        writeAll(out_fd, header, TRACE_V2_HEADER_SIZE);
+    }
+
+    trace_block<A> blocks[N_BLOCKS];
+    for (trace_block<A>& block : blocks) block.entries.reset(new trace_entry<A>[N_BLOCK_ENTRIES]);
+    std::unique_ptr<trace_entry<A>[]> merge_entries(merge ? new trace_entry<A>[N_BLOCK_ENTRIES] : nullptr);
+    std::barrier sync_point(N_BLOCKS);
+
+    // Each stage works on the block the previous stage finished at the last barrier, and stops after the last block
+    auto run_stage = [&](uint32_t stage, auto process) {
+        for (uint32_t i = 0; i < stage; i++) sync_point.arrive_and_wait();
+        for (uint32_t i = 0; ; i++) {
+            trace_block<A>& block = blocks[i % N_BLOCKS];
+            process(block);
+            if (block.last) {
+                sync_point.arrive_and_drop();
+                return;
+            }
+            sync_point.arrive_and_wait();
+        }
+    };
+
+    // Decode the input, interleaving the accesses of the merged trace one at a time
+    auto read_block = [&](trace_block<A>& block) {
+        if (!merge) block.count = input.read(block.entries.get(), N_BLOCK_ENTRIES);
+        else {
+            trace_entry<A>* entries = block.entries.get();
+            size_t n_input = input.read(merge_entries.get(), N_BLOCK_ENTRIES / 2);
+            size_t n_merge = merge->read(merge_entries.get() + n_input, N_BLOCK_ENTRIES / 2);
+            trace_entry<A>* from_input = merge_entries.get();
+            trace_entry<A>* from_merge = merge_entries.get() + n_input;
+            block.count = 0;
+            for (size_t i = 0; i < std::max(n_input, n_merge); i++) {
+                if (i < n_input) entries[block.count++] = from_input[i];
+                if (i < n_merge) {
+                    entries[block.count] = from_merge[i];
+                    entries[block.count++].cache_id += tool.merge_offset;
+                }
+            }
+            if (merge->isMalformed()) fail("Malformed merged trace file");
+        }
+        if (input.isMalformed()) fail("Malformed input trace file");
+        block.last = !block.count;
+    };
+
+    // Apply the filters in order
+    auto filter_block = [&](trace_block<A>& block) {
+        for (auto& filter : filters) block.count = filter->apply(block.entries.get(), block.count);
+    };
+
+    // Encode and write the output
+    std::vector<char> out_buf(N_BLOCK_ENTRIES * (sizeof(uint16_t) + sizeof(A)));
+    uint64_t n_records = 0;
+    uint32_t max_core = 0;
+    auto write_block = [&](trace_block<A>& block) {
+        char* record = out_buf.data();
+        for (size_t i = 0; i < block.count; i++) {
+            trace_entry<A>& entry = block.entries[i];
+            max_core = std::max<uint32_t>(max_core, entry.cache_id);
+            if (version == 1) {
+                if (entry.cache_id >= TRACE_V1_N_CORES || (uint64_t)entry.addr > UINT32_MAX)
+                    fail("Access does not fit the version 1 format (use --format v2)");
+                storeLE<uint8_t>(record, entry.cache_id << 1 | entry.write);
+                storeLE<uint32_t>(record + 1, entry.addr);
+                record += sizeof(trace_t);
+            } else {
+                storeLE<uint16_t>(record, entry.cache_id << 1 | entry.write);
+                storeLE<A>(record + 2, entry.addr);
+                record += sizeof(uint16_t) + sizeof(A);
+            }
+        }
+        writeAll(out_fd, out_buf.data(), record - out_buf.data());
+        n_records += block.count;
+    };
+
+    std::thread reader(run_stage, 0, read_block);
+    std::thread filterer(run_stage, 1, filter_block);
+    run_stage(2, write_block);
+    reader.join();
+    filterer.join();
+
+    if (version == 2 && seekable) {
+        encodeHeader(header, sizeof(A), n_records ? max_core + 1 : 1, n_records);
+        if (pwrite(out_fd, header, TRACE_V2_HEADER_SIZE, 0) != TRACE_V2_HEADER_SIZE)
+            fail(std::string("Output trace write error: ") + std::strerror(errno));
+    }
+}
+
+/// @brief Print the program usage message
+void usageMsg() {
+    std::cout << "Usage: ./trace_tool [options..] <input_trace> <output_trace>" << std::endl;
+    std::cout << "  input_trace:  The path to the input trace file (version 1 or 2)" << std::endl;
+    std::cout << "  output_trace: The path to the output trace file, or '-' for stdout" << std::endl;
+    std::cout << "Filters (applied in the order given, numbers may be hexadecimal with a '0x' prefix):" << std::endl;
+    std::cout << "  --cores <list>           Keep only the accesses of the listed cores (e.g. 0-3,8)" << std::endl;
+    std::cout << "  --drop-cores <list>      Drop the accesses of the listed cores" << std::endl;
+    std::cout << "  --fold-cores <n>         Renumber each core as its number modulo n (e.g. 16 cores onto 4)" << std::endl;
+    std::cout << "  --map-cores <old:new,..> Renumber the listed cores (e.g. 4:0,5:1)" << std::endl;
+    std::cout << "  --mask <mask>            AND every address with the mask" << std::endl;
+    std::cout << "  --strip <start>:<end>    Drop the accesses to the addresses from start up to, but excluding, end" << std::endl;
+    std::cout << "  --sample <n>             Keep every nth access, starting with the first" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --merge <trace> <offset> Interleave the accesses of a second trace with the input, one at a time," << std::endl;
+    std::cout << "                             adding offset to its cores (before any filter is applied)" << std::endl;
+    std::cout << "  --format <v1|v2>         The format of the output trace (default: the format of the input trace)" << std::endl;
+}
+
+/// @brief The main function parses the command line and streams the input trace through the filters
+/// @param argc The number of command line arguments
+/// @param argv An array to the command line arguments
+/// @return The program exit code
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        usageMsg();
+        return argc == 1 ? 0 : -1;
+    }
+
+    // Options and filters come before the trace files
+    std::vector<filter_arg> args;
+    tool_options tool = { nullptr, 0, 0 };
+    int arg = 1;
+    for (; arg < argc - 2; arg++) {
+        std::string option = argv[arg];
+        if (arg + 1 >= argc - 2) fail("Missing value for option: " + option);
+        const char* value = argv[++arg];
+        const char* end;
+        if (option == "--cores" || option == "--drop-cores") args.push_back({ option, 0, 0, parseCores(value) });
+        else if (option == "--map-cores") args.push_back({ option, 0, 0, parseCoreMap(value) });
+        else if (option == "--fold-cores" || option == "--sample") {
+            uint64_t n = parseNumber(value);
+            if (!n) fail(option + " expects a positive number");
+            args.push_back({ option, n });
+        }
+        else if (option == "--mask") args.push_back({ option, parseNumber(value) });
+        else if (option == "--strip") {
+            uint64_t start = parseNumber(value, &end);
+            if (*end != ':') fail(std::string("Invalid address range: ") + value);
+            args.push_back({ option, start, parseNumber(end + 1) });
+        }
+        else if (option == "--merge") {
+            if (arg + 1 >= argc - 2) fail("Missing core offset for option: " + option);
+            tool.merge_file = value;
+            tool.merge_offset = parseNumber(argv[++arg]);
+        }
+        else if (option == "--format") {
+            if (!strcmp(value, "v1")) tool.version = 1;
+            else if (!strcmp(value, "v2")) tool.version = 2;
+            else fail(std::string("Unknown output format: ") + value);
+        }
+        else fail("Unknown option: " + option);
+    }
+
+    // Open the input traces
+    TraceReader input;
+    std::string error = input.open(argv[argc - 2]);
+    if (!error.empty()) fail(error);
+    TraceReader merge;
+    if (tool.merge_file) {
+        error = merge.open(tool.merge_file);
+        if (!error.empty()) fail(error);
+        if (merge.addr_width != input.addr_width) fail("The merged trace must have the address width of the input trace");
+        if (tool.merge_offset >= MAX_N_CACHES) fail("The core offset of the merged trace must be less than " + std::to_string(MAX_N_CACHES));
+    }
+
+    // Open the output trace
+    int out_fd = strcmp(argv[argc - 1], "-") ? open(argv[argc - 1], O_WRONLY | O_CREAT | O_TRUNC, 0644) : STDOUT_FILENO;
+    if (out_fd < 0) fail(std::string("Output trace write error: ") + std::strerror(errno));
+
+    if (input.addr_width == sizeof(uint64_t)) transformTrace<uint64_t>(input, tool.merge_file ? &merge : nullptr, args, tool, out_fd);
+    else transformTrace<uint32_t>(input, tool.merge_file ? &merge : nullptr, args, tool, out_fd);
+    close(out_fd);
+    return 0;
+}